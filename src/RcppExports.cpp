@@ -11,9 +11,281 @@ Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
 Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
+// landscape_adjoint_gradient
+NumericMatrix landscape_adjoint_gradient(const std::vector<double>& m, const std::vector<double>& R, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const std::vector<double>& P_max, const double& u, const double& q, const std::vector<double>& W, const double& w, const arma::mat& z, const double& min_F_for_P, const std::vector<double>& Y0, const std::vector<double>& B0, const std::vector<double>& N0, const NumericMatrix& obs, const double& dt, const double& max_t, const uint32_t& checkpoint_steps, const bool& show_progress);
+RcppExport SEXP _sweetsoursong_landscape_adjoint_gradient(SEXP mSEXP, SEXP RSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP uSEXP, SEXP qSEXP, SEXP WSEXP, SEXP wSEXP, SEXP zSEXP, SEXP min_F_for_PSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP N0SEXP, SEXP obsSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP checkpoint_stepsSEXP, SEXP show_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type R(RSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type P_max(P_maxSEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type q(qSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type W(WSEXP);
+    Rcpp::traits::input_parameter< const double& >::type w(wSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type z(zSEXP);
+    Rcpp::traits::input_parameter< const double& >::type min_F_for_P(min_F_for_PSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type N0(N0SEXP);
+    Rcpp::traits::input_parameter< const NumericMatrix& >::type obs(obsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type checkpoint_steps(checkpoint_stepsSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_adjoint_gradient(m, R, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, u, q, W, w, z, min_F_for_P, Y0, B0, N0, obs, dt, max_t, checkpoint_steps, show_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_constantF_basins
+NumericMatrix landscape_constantF_basins(const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const double& u, const double& X, const std::vector<double>& Y0, const std::vector<double>& B0, const std::vector<double>& Y0_1, const std::vector<double>& B0_1, const std::vector<double>& Y0_2, const std::vector<double>& B0_2, const uint32_t& n_grid, const uint32_t& n_refine, const double& tol, const double& attr_tol, const double& threshold, const double& dt, const double& max_t, const bool& show_progress, const uint32_t& grain_size);
+RcppExport SEXP _sweetsoursong_landscape_constantF_basins(SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP uSEXP, SEXP XSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP Y0_1SEXP, SEXP B0_1SEXP, SEXP Y0_2SEXP, SEXP B0_2SEXP, SEXP n_gridSEXP, SEXP n_refineSEXP, SEXP tolSEXP, SEXP attr_tolSEXP, SEXP thresholdSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP show_progressSEXP, SEXP grain_sizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0_1(Y0_1SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0_1(B0_1SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0_2(Y0_2SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0_2(B0_2SEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_grid(n_gridSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_refine(n_refineSEXP);
+    Rcpp::traits::input_parameter< const double& >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< const double& >::type attr_tol(attr_tolSEXP);
+    Rcpp::traits::input_parameter< const double& >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type grain_size(grain_sizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_constantF_basins(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X, Y0, B0, Y0_1, B0_1, Y0_2, B0_2, n_grid, n_refine, tol, attr_tol, threshold, dt, max_t, show_progress, grain_size));
+    return rcpp_result_gen;
+END_RCPP
+}
+// one_plant_continuation
+NumericMatrix one_plant_continuation(const double& m, const double& R, const double& d_yp, const double& d_b0, const double& d_bp, const double& g_yp, const double& g_b0, const double& g_bp, const double& L_0, const double& P_max, const double& q, const double& s_0, const double& h, const double& f_0, const double& F_tilde, const double& u, const std::string& par, const double& par_min, const double& par_max, const double& Y0, const double& B0, const double& N0, const double& settle_t, const double& ds, const double& ds_max, const uint32_t& max_steps);
+RcppExport SEXP _sweetsoursong_one_plant_continuation(SEXP mSEXP, SEXP RSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP qSEXP, SEXP s_0SEXP, SEXP hSEXP, SEXP f_0SEXP, SEXP F_tildeSEXP, SEXP uSEXP, SEXP parSEXP, SEXP par_minSEXP, SEXP par_maxSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP N0SEXP, SEXP settle_tSEXP, SEXP dsSEXP, SEXP ds_maxSEXP, SEXP max_stepsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const double& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const double& >::type R(RSEXP);
+    Rcpp::traits::input_parameter< const double& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const double& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const double& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const double& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const double& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type P_max(P_maxSEXP);
+    Rcpp::traits::input_parameter< const double& >::type q(qSEXP);
+    Rcpp::traits::input_parameter< const double& >::type s_0(s_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type h(hSEXP);
+    Rcpp::traits::input_parameter< const double& >::type f_0(f_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type F_tilde(F_tildeSEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type par(parSEXP);
+    Rcpp::traits::input_parameter< const double& >::type par_min(par_minSEXP);
+    Rcpp::traits::input_parameter< const double& >::type par_max(par_maxSEXP);
+    Rcpp::traits::input_parameter< const double& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type N0(N0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type settle_t(settle_tSEXP);
+    Rcpp::traits::input_parameter< const double& >::type ds(dsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type ds_max(ds_maxSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type max_steps(max_stepsSEXP);
+    rcpp_result_gen = Rcpp::wrap(one_plant_continuation(m, R, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, q, s_0, h, f_0, F_tilde, u, par, par_min, par_max, Y0, B0, N0, settle_t, ds, ds_max, max_steps));
+    return rcpp_result_gen;
+END_RCPP
+}
+// one_plant_bifurcation_curve
+NumericMatrix one_plant_bifurcation_curve(const double& m, const double& R, const double& d_yp, const double& d_b0, const double& d_bp, const double& g_yp, const double& g_b0, const double& g_bp, const double& L_0, const double& P_max, const double& q, const double& s_0, const double& h, const double& f_0, const double& F_tilde, const double& u, const std::string& par, const double& par_min, const double& par_max, const std::string& par2, const double& par2_min, const double& par2_max, const double& Y0, const double& B0, const double& N0, const double& settle_t, const double& ds, const double& ds_max, const uint32_t& max_steps);
+RcppExport SEXP _sweetsoursong_one_plant_bifurcation_curve(SEXP mSEXP, SEXP RSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP qSEXP, SEXP s_0SEXP, SEXP hSEXP, SEXP f_0SEXP, SEXP F_tildeSEXP, SEXP uSEXP, SEXP parSEXP, SEXP par_minSEXP, SEXP par_maxSEXP, SEXP par2SEXP, SEXP par2_minSEXP, SEXP par2_maxSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP N0SEXP, SEXP settle_tSEXP, SEXP dsSEXP, SEXP ds_maxSEXP, SEXP max_stepsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const double& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const double& >::type R(RSEXP);
+    Rcpp::traits::input_parameter< const double& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const double& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const double& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const double& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const double& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type P_max(P_maxSEXP);
+    Rcpp::traits::input_parameter< const double& >::type q(qSEXP);
+    Rcpp::traits::input_parameter< const double& >::type s_0(s_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type h(hSEXP);
+    Rcpp::traits::input_parameter< const double& >::type f_0(f_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type F_tilde(F_tildeSEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type par(parSEXP);
+    Rcpp::traits::input_parameter< const double& >::type par_min(par_minSEXP);
+    Rcpp::traits::input_parameter< const double& >::type par_max(par_maxSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type par2(par2SEXP);
+    Rcpp::traits::input_parameter< const double& >::type par2_min(par2_minSEXP);
+    Rcpp::traits::input_parameter< const double& >::type par2_max(par2_maxSEXP);
+    Rcpp::traits::input_parameter< const double& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type N0(N0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type settle_t(settle_tSEXP);
+    Rcpp::traits::input_parameter< const double& >::type ds(dsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type ds_max(ds_maxSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type max_steps(max_stepsSEXP);
+    rcpp_result_gen = Rcpp::wrap(one_plant_bifurcation_curve(m, R, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, q, s_0, h, f_0, F_tilde, u, par, par_min, par_max, par2, par2_min, par2_max, Y0, B0, N0, settle_t, ds, ds_max, max_steps));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_constantF_continuation
+NumericMatrix landscape_constantF_continuation(const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const double& u, const double& X, const std::vector<double>& Y0, const std::vector<double>& B0, const std::string& par, const double& par_min, const double& par_max, const double& settle_t, const double& ds, const double& ds_max, const uint32_t& max_steps);
+RcppExport SEXP _sweetsoursong_landscape_constantF_continuation(SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP uSEXP, SEXP XSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP parSEXP, SEXP par_minSEXP, SEXP par_maxSEXP, SEXP settle_tSEXP, SEXP dsSEXP, SEXP ds_maxSEXP, SEXP max_stepsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type par(parSEXP);
+    Rcpp::traits::input_parameter< const double& >::type par_min(par_minSEXP);
+    Rcpp::traits::input_parameter< const double& >::type par_max(par_maxSEXP);
+    Rcpp::traits::input_parameter< const double& >::type settle_t(settle_tSEXP);
+    Rcpp::traits::input_parameter< const double& >::type ds(dsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type ds_max(ds_maxSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type max_steps(max_stepsSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_constantF_continuation(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X, Y0, B0, par, par_min, par_max, settle_t, ds, ds_max, max_steps));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_constantF_bifurcation_curve
+NumericMatrix landscape_constantF_bifurcation_curve(const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const double& u, const double& X, const std::vector<double>& Y0, const std::vector<double>& B0, const std::string& par, const double& par_min, const double& par_max, const std::string& par2, const double& par2_min, const double& par2_max, const double& settle_t, const double& ds, const double& ds_max, const uint32_t& max_steps);
+RcppExport SEXP _sweetsoursong_landscape_constantF_bifurcation_curve(SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP uSEXP, SEXP XSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP parSEXP, SEXP par_minSEXP, SEXP par_maxSEXP, SEXP par2SEXP, SEXP par2_minSEXP, SEXP par2_maxSEXP, SEXP settle_tSEXP, SEXP dsSEXP, SEXP ds_maxSEXP, SEXP max_stepsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type par(parSEXP);
+    Rcpp::traits::input_parameter< const double& >::type par_min(par_minSEXP);
+    Rcpp::traits::input_parameter< const double& >::type par_max(par_maxSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type par2(par2SEXP);
+    Rcpp::traits::input_parameter< const double& >::type par2_min(par2_minSEXP);
+    Rcpp::traits::input_parameter< const double& >::type par2_max(par2_maxSEXP);
+    Rcpp::traits::input_parameter< const double& >::type settle_t(settle_tSEXP);
+    Rcpp::traits::input_parameter< const double& >::type ds(dsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type ds_max(ds_maxSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type max_steps(max_stepsSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_constantF_bifurcation_curve(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X, Y0, B0, par, par_min, par_max, par2, par2_min, par2_max, settle_t, ds, ds_max, max_steps));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_constantF_fit
+NumericMatrix landscape_constantF_fit(const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const double& u, const double& X, const std::vector<double>& Y0, const std::vector<double>& B0, const NumericMatrix& obs, const std::vector<std::string>& fit_pars, const std::string& family, const double& phi, const double& dt, const uint32_t& max_evals, const double& tol, const bool& show_progress);
+RcppExport SEXP _sweetsoursong_landscape_constantF_fit(SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP uSEXP, SEXP XSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP obsSEXP, SEXP fit_parsSEXP, SEXP familySEXP, SEXP phiSEXP, SEXP dtSEXP, SEXP max_evalsSEXP, SEXP tolSEXP, SEXP show_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const NumericMatrix& >::type obs(obsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type fit_pars(fit_parsSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type family(familySEXP);
+    Rcpp::traits::input_parameter< const double& >::type phi(phiSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type max_evals(max_evalsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_constantF_fit(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X, Y0, B0, obs, fit_pars, family, phi, dt, max_evals, tol, show_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_fit
+NumericMatrix landscape_fit(const std::vector<double>& m, const std::vector<double>& R, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const std::vector<double>& P_max, const double& u, const double& q, const std::vector<double>& W, const double& w, const arma::mat& z, const double& min_F_for_P, const std::vector<double>& Y0, const std::vector<double>& B0, const std::vector<double>& N0, const NumericMatrix& obs, const std::vector<std::string>& fit_pars, const std::string& family, const double& phi, const double& dt, const uint32_t& max_evals, const double& tol, const bool& show_progress);
+RcppExport SEXP _sweetsoursong_landscape_fit(SEXP mSEXP, SEXP RSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP uSEXP, SEXP qSEXP, SEXP WSEXP, SEXP wSEXP, SEXP zSEXP, SEXP min_F_for_PSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP N0SEXP, SEXP obsSEXP, SEXP fit_parsSEXP, SEXP familySEXP, SEXP phiSEXP, SEXP dtSEXP, SEXP max_evalsSEXP, SEXP tolSEXP, SEXP show_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type R(RSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type P_max(P_maxSEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type q(qSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type W(WSEXP);
+    Rcpp::traits::input_parameter< const double& >::type w(wSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type z(zSEXP);
+    Rcpp::traits::input_parameter< const double& >::type min_F_for_P(min_F_for_PSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type N0(N0SEXP);
+    Rcpp::traits::input_parameter< const NumericMatrix& >::type obs(obsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type fit_pars(fit_parsSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type family(familySEXP);
+    Rcpp::traits::input_parameter< const double& >::type phi(phiSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type max_evals(max_evalsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type tol(tolSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_fit(m, R, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, u, q, W, w, z, min_F_for_P, Y0, B0, N0, obs, fit_pars, family, phi, dt, max_evals, tol, show_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
 // landscape_ode
-NumericMatrix landscape_ode(const std::vector<double>& m, const std::vector<double>& R, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const std::vector<double>& P_max, const double& u, const double& q, const std::vector<double>& W, const double& w, const arma::mat& z, const double& min_F_for_P, const std::vector<double>& Y0, const std::vector<double>& B0, const std::vector<double>& N0, const double& dt, const double& max_t);
-RcppExport SEXP _sweetsoursong_landscape_ode(SEXP mSEXP, SEXP RSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP uSEXP, SEXP qSEXP, SEXP WSEXP, SEXP wSEXP, SEXP zSEXP, SEXP min_F_for_PSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP N0SEXP, SEXP dtSEXP, SEXP max_tSEXP) {
+NumericMatrix landscape_ode(const std::vector<double>& m, const std::vector<double>& R, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const std::vector<double>& P_max, const double& u, const double& q, const std::vector<double>& W, const double& w, const arma::mat& z, const double& min_F_for_P, const std::vector<double>& Y0, const std::vector<double>& B0, const std::vector<double>& N0, const double& dt, const double& max_t, const bool& single_prec, const bool& outcomes_only, const double& threshold, const double& outcome_window, const bool& by_plant, const bool& show_progress);
+RcppExport SEXP _sweetsoursong_landscape_ode(SEXP mSEXP, SEXP RSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP uSEXP, SEXP qSEXP, SEXP WSEXP, SEXP wSEXP, SEXP zSEXP, SEXP min_F_for_PSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP N0SEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP single_precSEXP, SEXP outcomes_onlySEXP, SEXP thresholdSEXP, SEXP outcome_windowSEXP, SEXP by_plantSEXP, SEXP show_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -38,13 +310,19 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const std::vector<double>& >::type N0(N0SEXP);
     Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
     Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
-    rcpp_result_gen = Rcpp::wrap(landscape_ode(m, R, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, u, q, W, w, z, min_F_for_P, Y0, B0, N0, dt, max_t));
+    Rcpp::traits::input_parameter< const bool& >::type single_prec(single_precSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type outcomes_only(outcomes_onlySEXP);
+    Rcpp::traits::input_parameter< const double& >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type outcome_window(outcome_windowSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type by_plant(by_plantSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_ode(m, R, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, u, q, W, w, z, min_F_for_P, Y0, B0, N0, dt, max_t, single_prec, outcomes_only, threshold, outcome_window, by_plant, show_progress));
     return rcpp_result_gen;
 END_RCPP
 }
 // landscape_constantF_ode
-NumericMatrix landscape_constantF_ode(const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const double& u, const double& X, const std::vector<double>& Y0, const std::vector<double>& B0, const double& dt, const double& max_t);
-RcppExport SEXP _sweetsoursong_landscape_constantF_ode(SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP uSEXP, SEXP XSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP dtSEXP, SEXP max_tSEXP) {
+NumericMatrix landscape_constantF_ode(const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const double& u, const double& X, const std::vector<double>& Y0, const std::vector<double>& B0, const double& dt, const double& max_t, const bool& single_prec, const bool& outcomes_only, const double& threshold, const double& outcome_window, const bool& by_plant, const bool& show_progress);
+RcppExport SEXP _sweetsoursong_landscape_constantF_ode(SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP uSEXP, SEXP XSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP single_precSEXP, SEXP outcomes_onlySEXP, SEXP thresholdSEXP, SEXP outcome_windowSEXP, SEXP by_plantSEXP, SEXP show_progressSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -62,13 +340,19 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
     Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
     Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
-    rcpp_result_gen = Rcpp::wrap(landscape_constantF_ode(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X, Y0, B0, dt, max_t));
+    Rcpp::traits::input_parameter< const bool& >::type single_prec(single_precSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type outcomes_only(outcomes_onlySEXP);
+    Rcpp::traits::input_parameter< const double& >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type outcome_window(outcome_windowSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type by_plant(by_plantSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_constantF_ode(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X, Y0, B0, dt, max_t, single_prec, outcomes_only, threshold, outcome_window, by_plant, show_progress));
     return rcpp_result_gen;
 END_RCPP
 }
 // landscape_constantF_stoch_ode
-NumericMatrix landscape_constantF_stoch_ode(const uint32_t& n_reps, const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const double& u, const double& X, const std::vector<double>& Y0, const std::vector<double>& B0, const double& n_sigma, SEXP season_len, const double& season_surv, const double& season_sigma, const double& dt, const double& max_t);
-RcppExport SEXP _sweetsoursong_landscape_constantF_stoch_ode(SEXP n_repsSEXP, SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP uSEXP, SEXP XSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP n_sigmaSEXP, SEXP season_lenSEXP, SEXP season_survSEXP, SEXP season_sigmaSEXP, SEXP dtSEXP, SEXP max_tSEXP) {
+NumericMatrix landscape_constantF_stoch_ode(const uint32_t& n_reps, const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const double& u, const double& X, const std::vector<double>& Y0, const std::vector<double>& B0, const double& n_sigma, SEXP season_len, const double& season_surv, const double& season_sigma, const double& dt, const double& max_t, const bool& single_prec, const bool& outcomes_only, const double& threshold, const double& outcome_window, const bool& by_plant, const std::string& checkpoint_file, const double& checkpoint_every, const bool& resume, const bool& show_progress, SEXP seed, SEXP noise_z, const double& noise_w, SEXP noise_vcv, const uint32_t& noise_rank, const uint32_t& grain_size, const bool& thread_stats, const bool& antithetic, const bool& summarize, SEXP quantiles, const double& compression);
+RcppExport SEXP _sweetsoursong_landscape_constantF_stoch_ode(SEXP n_repsSEXP, SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP uSEXP, SEXP XSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP n_sigmaSEXP, SEXP season_lenSEXP, SEXP season_survSEXP, SEXP season_sigmaSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP single_precSEXP, SEXP outcomes_onlySEXP, SEXP thresholdSEXP, SEXP outcome_windowSEXP, SEXP by_plantSEXP, SEXP checkpoint_fileSEXP, SEXP checkpoint_everySEXP, SEXP resumeSEXP, SEXP show_progressSEXP, SEXP seedSEXP, SEXP noise_zSEXP, SEXP noise_wSEXP, SEXP noise_vcvSEXP, SEXP noise_rankSEXP, SEXP grain_sizeSEXP, SEXP thread_statsSEXP, SEXP antitheticSEXP, SEXP summarizeSEXP, SEXP quantilesSEXP, SEXP compressionSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -91,13 +375,161 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const double& >::type season_sigma(season_sigmaSEXP);
     Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
     Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
-    rcpp_result_gen = Rcpp::wrap(landscape_constantF_stoch_ode(n_reps, m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X, Y0, B0, n_sigma, season_len, season_surv, season_sigma, dt, max_t));
+    Rcpp::traits::input_parameter< const bool& >::type single_prec(single_precSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type outcomes_only(outcomes_onlySEXP);
+    Rcpp::traits::input_parameter< const double& >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type outcome_window(outcome_windowSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type by_plant(by_plantSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type checkpoint_file(checkpoint_fileSEXP);
+    Rcpp::traits::input_parameter< const double& >::type checkpoint_every(checkpoint_everySEXP);
+    Rcpp::traits::input_parameter< const bool& >::type resume(resumeSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type noise_z(noise_zSEXP);
+    Rcpp::traits::input_parameter< const double& >::type noise_w(noise_wSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type noise_vcv(noise_vcvSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type noise_rank(noise_rankSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type grain_size(grain_sizeSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type thread_stats(thread_statsSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type antithetic(antitheticSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type summarize(summarizeSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type quantiles(quantilesSEXP);
+    Rcpp::traits::input_parameter< const double& >::type compression(compressionSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_constantF_stoch_ode(n_reps, m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X, Y0, B0, n_sigma, season_len, season_surv, season_sigma, dt, max_t, single_prec, outcomes_only, threshold, outcome_window, by_plant, checkpoint_file, checkpoint_every, resume, show_progress, seed, noise_z, noise_w, noise_vcv, noise_rank, grain_size, thread_stats, antithetic, summarize, quantiles, compression));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_constantF_stoch_compare
+NumericMatrix landscape_constantF_stoch_compare(const uint32_t& n_reps, const List& par_sets, const List& shared, const uint32_t& n_plants, SEXP season_len, const double& dt, const double& max_t, const double& threshold, const double& outcome_window, const bool& antithetic, const bool& show_progress, SEXP seed, const uint32_t& grain_size, const bool& thread_stats);
+RcppExport SEXP _sweetsoursong_landscape_constantF_stoch_compare(SEXP n_repsSEXP, SEXP par_setsSEXP, SEXP sharedSEXP, SEXP n_plantsSEXP, SEXP season_lenSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP thresholdSEXP, SEXP outcome_windowSEXP, SEXP antitheticSEXP, SEXP show_progressSEXP, SEXP seedSEXP, SEXP grain_sizeSEXP, SEXP thread_statsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_reps(n_repsSEXP);
+    Rcpp::traits::input_parameter< const List& >::type par_sets(par_setsSEXP);
+    Rcpp::traits::input_parameter< const List& >::type shared(sharedSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_plants(n_plantsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type season_len(season_lenSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const double& >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type outcome_window(outcome_windowSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type antithetic(antitheticSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type grain_size(grain_sizeSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type thread_stats(thread_statsSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_constantF_stoch_compare(n_reps, par_sets, shared, n_plants, season_len, dt, max_t, threshold, outcome_window, antithetic, show_progress, seed, grain_size, thread_stats));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_constantF_stoch_sweep
+NumericMatrix landscape_constantF_stoch_sweep(const uint32_t& n_reps, const List& par_sets, const List& shared, const uint32_t& n_plants, SEXP season_len, const double& dt, const double& max_t, const bool& single_prec, const bool& outcomes_only, const double& threshold, const double& outcome_window, const bool& by_plant, const bool& show_progress, SEXP seed, const bool& common_random, SEXP noise_z, const double& noise_w, SEXP noise_vcv, const uint32_t& noise_rank, const bool& antithetic, const uint32_t& grain_size, const bool& thread_stats);
+RcppExport SEXP _sweetsoursong_landscape_constantF_stoch_sweep(SEXP n_repsSEXP, SEXP par_setsSEXP, SEXP sharedSEXP, SEXP n_plantsSEXP, SEXP season_lenSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP single_precSEXP, SEXP outcomes_onlySEXP, SEXP thresholdSEXP, SEXP outcome_windowSEXP, SEXP by_plantSEXP, SEXP show_progressSEXP, SEXP seedSEXP, SEXP common_randomSEXP, SEXP noise_zSEXP, SEXP noise_wSEXP, SEXP noise_vcvSEXP, SEXP noise_rankSEXP, SEXP antitheticSEXP, SEXP grain_sizeSEXP, SEXP thread_statsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_reps(n_repsSEXP);
+    Rcpp::traits::input_parameter< const List& >::type par_sets(par_setsSEXP);
+    Rcpp::traits::input_parameter< const List& >::type shared(sharedSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_plants(n_plantsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type season_len(season_lenSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type single_prec(single_precSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type outcomes_only(outcomes_onlySEXP);
+    Rcpp::traits::input_parameter< const double& >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type outcome_window(outcome_windowSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type by_plant(by_plantSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type common_random(common_randomSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type noise_z(noise_zSEXP);
+    Rcpp::traits::input_parameter< const double& >::type noise_w(noise_wSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type noise_vcv(noise_vcvSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type noise_rank(noise_rankSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type antithetic(antitheticSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type grain_size(grain_sizeSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type thread_stats(thread_statsSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_constantF_stoch_sweep(n_reps, par_sets, shared, n_plants, season_len, dt, max_t, single_prec, outcomes_only, threshold, outcome_window, by_plant, show_progress, seed, common_random, noise_z, noise_w, noise_vcv, noise_rank, antithetic, grain_size, thread_stats));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_constantF_stoch_ams
+NumericMatrix landscape_constantF_stoch_ams(const uint32_t& n_runs, const uint32_t& n_particles, const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const double& u, const double& X, const std::vector<double>& Y0, const std::vector<double>& B0, const double& n_sigma, const std::string& extinct, const double& threshold, const uint32_t& n_kill, const uint32_t& max_iters, SEXP season_len, const double& season_surv, const double& season_sigma, const double& dt, const double& max_t, const bool& show_progress, SEXP seed, const uint32_t& grain_size);
+RcppExport SEXP _sweetsoursong_landscape_constantF_stoch_ams(SEXP n_runsSEXP, SEXP n_particlesSEXP, SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP uSEXP, SEXP XSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP n_sigmaSEXP, SEXP extinctSEXP, SEXP thresholdSEXP, SEXP n_killSEXP, SEXP max_itersSEXP, SEXP season_lenSEXP, SEXP season_survSEXP, SEXP season_sigmaSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP show_progressSEXP, SEXP seedSEXP, SEXP grain_sizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_runs(n_runsSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_particles(n_particlesSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type n_sigma(n_sigmaSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type extinct(extinctSEXP);
+    Rcpp::traits::input_parameter< const double& >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_kill(n_killSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type max_iters(max_itersSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type season_len(season_lenSEXP);
+    Rcpp::traits::input_parameter< const double& >::type season_surv(season_survSEXP);
+    Rcpp::traits::input_parameter< const double& >::type season_sigma(season_sigmaSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type grain_size(grain_sizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_constantF_stoch_ams(n_runs, n_particles, m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X, Y0, B0, n_sigma, extinct, threshold, n_kill, max_iters, season_len, season_surv, season_sigma, dt, max_t, show_progress, seed, grain_size));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_constantF_stoch_abc
+NumericMatrix landscape_constantF_stoch_abc(const uint32_t& n_particles, const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const double& u, const double& X, const std::vector<double>& Y0, const std::vector<double>& B0, const std::vector<double>& obs_stats, const std::vector<double>& lower, const std::vector<double>& upper, const uint32_t& n_gens, const double& alpha, const double& min_accept, SEXP season_len, const double& dt, const double& max_t, const bool& show_progress, SEXP seed, const uint32_t& grain_size);
+RcppExport SEXP _sweetsoursong_landscape_constantF_stoch_abc(SEXP n_particlesSEXP, SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP uSEXP, SEXP XSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP obs_statsSEXP, SEXP lowerSEXP, SEXP upperSEXP, SEXP n_gensSEXP, SEXP alphaSEXP, SEXP min_acceptSEXP, SEXP season_lenSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP show_progressSEXP, SEXP seedSEXP, SEXP grain_sizeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_particles(n_particlesSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type obs_stats(obs_statsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type lower(lowerSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type upper(upperSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_gens(n_gensSEXP);
+    Rcpp::traits::input_parameter< const double& >::type alpha(alphaSEXP);
+    Rcpp::traits::input_parameter< const double& >::type min_accept(min_acceptSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type season_len(season_lenSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type grain_size(grain_sizeSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_constantF_stoch_abc(n_particles, m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X, Y0, B0, obs_stats, lower, upper, n_gens, alpha, min_accept, season_len, dt, max_t, show_progress, seed, grain_size));
     return rcpp_result_gen;
 END_RCPP
 }
 // landscape_season_ode
-NumericMatrix landscape_season_ode(const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const std::vector<double>& P_max, const double& u, const double& q, const std::vector<double>& W, const std::vector<double>& R_hat, const std::vector<double>& par1, const std::vector<double>& par2, const StringVector& distr_types, const double& w, const arma::mat& z, const double& min_F_for_P, const std::vector<double>& Y0, const std::vector<double>& B0, const double& add_F, const double& dt, const double& max_t);
-RcppExport SEXP _sweetsoursong_landscape_season_ode(SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP uSEXP, SEXP qSEXP, SEXP WSEXP, SEXP R_hatSEXP, SEXP par1SEXP, SEXP par2SEXP, SEXP distr_typesSEXP, SEXP wSEXP, SEXP zSEXP, SEXP min_F_for_PSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP add_FSEXP, SEXP dtSEXP, SEXP max_tSEXP) {
+NumericMatrix landscape_season_ode(const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const std::vector<double>& P_max, const double& u, const double& q, const std::vector<double>& W, const std::vector<double>& R_hat, const std::vector<double>& par1, const std::vector<double>& par2, const StringVector& distr_types, const double& w, const arma::mat& z, const double& min_F_for_P, const std::vector<double>& Y0, const std::vector<double>& B0, const double& add_F, const double& dt, const double& max_t, const bool& single_prec, const bool& outcomes_only, const double& threshold, const double& outcome_window, const bool& by_plant, const std::string& checkpoint_file, const double& checkpoint_every, const bool& resume, const bool& show_progress, const std::string& cache_dir);
+RcppExport SEXP _sweetsoursong_landscape_season_ode(SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP uSEXP, SEXP qSEXP, SEXP WSEXP, SEXP R_hatSEXP, SEXP par1SEXP, SEXP par2SEXP, SEXP distr_typesSEXP, SEXP wSEXP, SEXP zSEXP, SEXP min_F_for_PSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP add_FSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP single_precSEXP, SEXP outcomes_onlySEXP, SEXP thresholdSEXP, SEXP outcome_windowSEXP, SEXP by_plantSEXP, SEXP checkpoint_fileSEXP, SEXP checkpoint_everySEXP, SEXP resumeSEXP, SEXP show_progressSEXP, SEXP cache_dirSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -125,7 +557,196 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< const double& >::type add_F(add_FSEXP);
     Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
     Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
-    rcpp_result_gen = Rcpp::wrap(landscape_season_ode(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, u, q, W, R_hat, par1, par2, distr_types, w, z, min_F_for_P, Y0, B0, add_F, dt, max_t));
+    Rcpp::traits::input_parameter< const bool& >::type single_prec(single_precSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type outcomes_only(outcomes_onlySEXP);
+    Rcpp::traits::input_parameter< const double& >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type outcome_window(outcome_windowSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type by_plant(by_plantSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type checkpoint_file(checkpoint_fileSEXP);
+    Rcpp::traits::input_parameter< const double& >::type checkpoint_every(checkpoint_everySEXP);
+    Rcpp::traits::input_parameter< const bool& >::type resume(resumeSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type cache_dir(cache_dirSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_season_ode(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, u, q, W, R_hat, par1, par2, distr_types, w, z, min_F_for_P, Y0, B0, add_F, dt, max_t, single_prec, outcomes_only, threshold, outcome_window, by_plant, checkpoint_file, checkpoint_every, resume, show_progress, cache_dir));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_multiseason_ode
+NumericMatrix landscape_multiseason_ode(const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const std::vector<double>& P_max, const double& u, const double& q, const std::vector<double>& W, const std::vector<double>& R_hat, const std::vector<double>& par1, const std::vector<double>& par2, const StringVector& distr_types, const double& w, const arma::mat& z, const double& min_F_for_P, const std::vector<double>& Y0, const std::vector<double>& B0, const uint32_t& n_seasons, const double& season_surv, const double& phen_sd, const double& R_hat_sd, const double& add_F, const double& dt, const double& max_t, const bool& show_progress, SEXP seed);
+RcppExport SEXP _sweetsoursong_landscape_multiseason_ode(SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP uSEXP, SEXP qSEXP, SEXP WSEXP, SEXP R_hatSEXP, SEXP par1SEXP, SEXP par2SEXP, SEXP distr_typesSEXP, SEXP wSEXP, SEXP zSEXP, SEXP min_F_for_PSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP n_seasonsSEXP, SEXP season_survSEXP, SEXP phen_sdSEXP, SEXP R_hat_sdSEXP, SEXP add_FSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP show_progressSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type P_max(P_maxSEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type q(qSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type W(WSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type R_hat(R_hatSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type par1(par1SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type par2(par2SEXP);
+    Rcpp::traits::input_parameter< const StringVector& >::type distr_types(distr_typesSEXP);
+    Rcpp::traits::input_parameter< const double& >::type w(wSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type z(zSEXP);
+    Rcpp::traits::input_parameter< const double& >::type min_F_for_P(min_F_for_PSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_seasons(n_seasonsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type season_surv(season_survSEXP);
+    Rcpp::traits::input_parameter< const double& >::type phen_sd(phen_sdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type R_hat_sd(R_hat_sdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type add_F(add_FSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_multiseason_ode(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, u, q, W, R_hat, par1, par2, distr_types, w, z, min_F_for_P, Y0, B0, n_seasons, season_surv, phen_sd, R_hat_sd, add_F, dt, max_t, show_progress, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_stoch_ode
+NumericMatrix landscape_stoch_ode(const uint32_t& n_reps, const std::vector<double>& m, const std::vector<double>& R, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const std::vector<double>& P_max, const double& u, const double& q, const std::vector<double>& W, const double& w, const arma::mat& z, const double& min_F_for_P, const std::vector<double>& Y0, const std::vector<double>& B0, const std::vector<double>& N0, const double& n_sigma, const double& dt, const double& max_t, const bool& single_prec, const bool& outcomes_only, const double& threshold, const double& outcome_window, const bool& by_plant, const bool& show_progress, SEXP seed, SEXP noise_z, const double& noise_w, SEXP noise_vcv, const uint32_t& noise_rank, const uint32_t& grain_size, const bool& thread_stats);
+RcppExport SEXP _sweetsoursong_landscape_stoch_ode(SEXP n_repsSEXP, SEXP mSEXP, SEXP RSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP uSEXP, SEXP qSEXP, SEXP WSEXP, SEXP wSEXP, SEXP zSEXP, SEXP min_F_for_PSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP N0SEXP, SEXP n_sigmaSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP single_precSEXP, SEXP outcomes_onlySEXP, SEXP thresholdSEXP, SEXP outcome_windowSEXP, SEXP by_plantSEXP, SEXP show_progressSEXP, SEXP seedSEXP, SEXP noise_zSEXP, SEXP noise_wSEXP, SEXP noise_vcvSEXP, SEXP noise_rankSEXP, SEXP grain_sizeSEXP, SEXP thread_statsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_reps(n_repsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type R(RSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type P_max(P_maxSEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type q(qSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type W(WSEXP);
+    Rcpp::traits::input_parameter< const double& >::type w(wSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type z(zSEXP);
+    Rcpp::traits::input_parameter< const double& >::type min_F_for_P(min_F_for_PSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type N0(N0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type n_sigma(n_sigmaSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type single_prec(single_precSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type outcomes_only(outcomes_onlySEXP);
+    Rcpp::traits::input_parameter< const double& >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type outcome_window(outcome_windowSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type by_plant(by_plantSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type noise_z(noise_zSEXP);
+    Rcpp::traits::input_parameter< const double& >::type noise_w(noise_wSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type noise_vcv(noise_vcvSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type noise_rank(noise_rankSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type grain_size(grain_sizeSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type thread_stats(thread_statsSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_stoch_ode(n_reps, m, R, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, u, q, W, w, z, min_F_for_P, Y0, B0, N0, n_sigma, dt, max_t, single_prec, outcomes_only, threshold, outcome_window, by_plant, show_progress, seed, noise_z, noise_w, noise_vcv, noise_rank, grain_size, thread_stats));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_season_stoch_ode
+NumericMatrix landscape_season_stoch_ode(const uint32_t& n_reps, const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const std::vector<double>& P_max, const double& u, const double& q, const std::vector<double>& W, const std::vector<double>& R_hat, const std::vector<double>& par1, const std::vector<double>& par2, const StringVector& distr_types, const double& w, const arma::mat& z, const double& min_F_for_P, const std::vector<double>& Y0, const std::vector<double>& B0, const double& n_sigma, const double& add_F, const double& dt, const double& max_t, const bool& single_prec, const bool& outcomes_only, const double& threshold, const double& outcome_window, const bool& by_plant, const bool& show_progress, SEXP seed, SEXP noise_z, const double& noise_w, SEXP noise_vcv, const uint32_t& noise_rank, const uint32_t& grain_size, const bool& thread_stats);
+RcppExport SEXP _sweetsoursong_landscape_season_stoch_ode(SEXP n_repsSEXP, SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP uSEXP, SEXP qSEXP, SEXP WSEXP, SEXP R_hatSEXP, SEXP par1SEXP, SEXP par2SEXP, SEXP distr_typesSEXP, SEXP wSEXP, SEXP zSEXP, SEXP min_F_for_PSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP n_sigmaSEXP, SEXP add_FSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP single_precSEXP, SEXP outcomes_onlySEXP, SEXP thresholdSEXP, SEXP outcome_windowSEXP, SEXP by_plantSEXP, SEXP show_progressSEXP, SEXP seedSEXP, SEXP noise_zSEXP, SEXP noise_wSEXP, SEXP noise_vcvSEXP, SEXP noise_rankSEXP, SEXP grain_sizeSEXP, SEXP thread_statsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_reps(n_repsSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type P_max(P_maxSEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type q(qSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type W(WSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type R_hat(R_hatSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type par1(par1SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type par2(par2SEXP);
+    Rcpp::traits::input_parameter< const StringVector& >::type distr_types(distr_typesSEXP);
+    Rcpp::traits::input_parameter< const double& >::type w(wSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type z(zSEXP);
+    Rcpp::traits::input_parameter< const double& >::type min_F_for_P(min_F_for_PSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type n_sigma(n_sigmaSEXP);
+    Rcpp::traits::input_parameter< const double& >::type add_F(add_FSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type single_prec(single_precSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type outcomes_only(outcomes_onlySEXP);
+    Rcpp::traits::input_parameter< const double& >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type outcome_window(outcome_windowSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type by_plant(by_plantSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type noise_z(noise_zSEXP);
+    Rcpp::traits::input_parameter< const double& >::type noise_w(noise_wSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type noise_vcv(noise_vcvSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type noise_rank(noise_rankSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type grain_size(grain_sizeSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type thread_stats(thread_statsSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_season_stoch_ode(n_reps, m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, u, q, W, R_hat, par1, par2, distr_types, w, z, min_F_for_P, Y0, B0, n_sigma, add_F, dt, max_t, single_prec, outcomes_only, threshold, outcome_window, by_plant, show_progress, seed, noise_z, noise_w, noise_vcv, noise_rank, grain_size, thread_stats));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_sweep
+NumericMatrix landscape_sweep(const List& par_sets, const List& shared, const arma::mat& z, const double& dt, const double& max_t, const bool& outcomes_only, const double& threshold, const double& outcome_window, const bool& by_plant, const bool& show_progress, const uint32_t& grain_size, const bool& thread_stats);
+RcppExport SEXP _sweetsoursong_landscape_sweep(SEXP par_setsSEXP, SEXP sharedSEXP, SEXP zSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP outcomes_onlySEXP, SEXP thresholdSEXP, SEXP outcome_windowSEXP, SEXP by_plantSEXP, SEXP show_progressSEXP, SEXP grain_sizeSEXP, SEXP thread_statsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const List& >::type par_sets(par_setsSEXP);
+    Rcpp::traits::input_parameter< const List& >::type shared(sharedSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type z(zSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type outcomes_only(outcomes_onlySEXP);
+    Rcpp::traits::input_parameter< const double& >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type outcome_window(outcome_windowSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type by_plant(by_plantSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type grain_size(grain_sizeSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type thread_stats(thread_statsSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_sweep(par_sets, shared, z, dt, max_t, outcomes_only, threshold, outcome_window, by_plant, show_progress, grain_size, thread_stats));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_season_sweep
+NumericMatrix landscape_season_sweep(const List& par_sets, const List& shared, const arma::mat& z, const double& dt, const double& max_t, const bool& outcomes_only, const double& threshold, const double& outcome_window, const bool& by_plant, const bool& show_progress, const uint32_t& grain_size, const bool& thread_stats);
+RcppExport SEXP _sweetsoursong_landscape_season_sweep(SEXP par_setsSEXP, SEXP sharedSEXP, SEXP zSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP outcomes_onlySEXP, SEXP thresholdSEXP, SEXP outcome_windowSEXP, SEXP by_plantSEXP, SEXP show_progressSEXP, SEXP grain_sizeSEXP, SEXP thread_statsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const List& >::type par_sets(par_setsSEXP);
+    Rcpp::traits::input_parameter< const List& >::type shared(sharedSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type z(zSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type outcomes_only(outcomes_onlySEXP);
+    Rcpp::traits::input_parameter< const double& >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< const double& >::type outcome_window(outcome_windowSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type by_plant(by_plantSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type grain_size(grain_sizeSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type thread_stats(thread_statsSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_season_sweep(par_sets, shared, z, dt, max_t, outcomes_only, threshold, outcome_window, by_plant, show_progress, grain_size, thread_stats));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -160,6 +781,37 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// local_multistrain_ode
+NumericMatrix local_multistrain_ode(const std::vector<double>& r_Y, const std::vector<double>& m_Y, const std::vector<double>& q_Y, const std::vector<double>& c_Y, const std::vector<double>& h_Y, const std::vector<double>& Y0, const std::vector<double>& Y_arrive, const std::vector<double>& r_B, const std::vector<double>& m_B, const std::vector<double>& e_B, const std::vector<double>& q_B, const std::vector<double>& c_B, const std::vector<double>& h_B, const std::vector<double>& B0, const std::vector<double>& B_arrive, const double& A0, const double& H0, const double& D, SEXP A_0, const double& dt, const double& max_t);
+RcppExport SEXP _sweetsoursong_local_multistrain_ode(SEXP r_YSEXP, SEXP m_YSEXP, SEXP q_YSEXP, SEXP c_YSEXP, SEXP h_YSEXP, SEXP Y0SEXP, SEXP Y_arriveSEXP, SEXP r_BSEXP, SEXP m_BSEXP, SEXP e_BSEXP, SEXP q_BSEXP, SEXP c_BSEXP, SEXP h_BSEXP, SEXP B0SEXP, SEXP B_arriveSEXP, SEXP A0SEXP, SEXP H0SEXP, SEXP DSEXP, SEXP A_0SEXP, SEXP dtSEXP, SEXP max_tSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type r_Y(r_YSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m_Y(m_YSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type q_Y(q_YSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type c_Y(c_YSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type h_Y(h_YSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y_arrive(Y_arriveSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type r_B(r_BSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m_B(m_BSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type e_B(e_BSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type q_B(q_BSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type c_B(c_BSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type h_B(h_BSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B_arrive(B_arriveSEXP);
+    Rcpp::traits::input_parameter< const double& >::type A0(A0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type H0(H0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type D(DSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type A_0(A_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    rcpp_result_gen = Rcpp::wrap(local_multistrain_ode(r_Y, m_Y, q_Y, c_Y, h_Y, Y0, Y_arrive, r_B, m_B, e_B, q_B, c_B, h_B, B0, B_arrive, A0, H0, D, A_0, dt, max_t));
+    return rcpp_result_gen;
+END_RCPP
+}
 // one_plant_ode
 NumericMatrix one_plant_ode(const double& m, const double& R, const double& d_yp, const double& d_b0, const double& d_bp, const double& g_yp, const double& g_b0, const double& g_bp, const double& L_0, const double& P_max, const double& q, const double& s_0, const double& h, const double& f_0, const double& F_tilde, const double& u, const double& dt, const double& max_t, const double& Y0, const double& B0, const double& N0);
 RcppExport SEXP _sweetsoursong_one_plant_ode(SEXP mSEXP, SEXP RSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP qSEXP, SEXP s_0SEXP, SEXP hSEXP, SEXP f_0SEXP, SEXP F_tildeSEXP, SEXP uSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP N0SEXP) {
@@ -191,6 +843,40 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// one_plant_batch_ode
+NumericMatrix one_plant_batch_ode(const List& pars, const double& dt, const double& max_t, const bool& last_only, const bool& show_progress, const uint32_t& grain_size, const bool& thread_stats);
+RcppExport SEXP _sweetsoursong_one_plant_batch_ode(SEXP parsSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP last_onlySEXP, SEXP show_progressSEXP, SEXP grain_sizeSEXP, SEXP thread_statsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const List& >::type pars(parsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type last_only(last_onlySEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type grain_size(grain_sizeSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type thread_stats(thread_statsSEXP);
+    rcpp_result_gen = Rcpp::wrap(one_plant_batch_ode(pars, dt, max_t, last_only, show_progress, grain_size, thread_stats));
+    return rcpp_result_gen;
+END_RCPP
+}
+// one_plant_season_batch_ode
+NumericMatrix one_plant_season_batch_ode(const List& pars, const double& dt, const double& max_t, const bool& last_only, const bool& show_progress, const uint32_t& grain_size, const bool& thread_stats);
+RcppExport SEXP _sweetsoursong_one_plant_season_batch_ode(SEXP parsSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP last_onlySEXP, SEXP show_progressSEXP, SEXP grain_sizeSEXP, SEXP thread_statsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const List& >::type pars(parsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type last_only(last_onlySEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type grain_size(grain_sizeSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type thread_stats(thread_statsSEXP);
+    rcpp_result_gen = Rcpp::wrap(one_plant_season_batch_ode(pars, dt, max_t, last_only, show_progress, grain_size, thread_stats));
+    return rcpp_result_gen;
+END_RCPP
+}
 // one_plant_season_ode
 NumericMatrix one_plant_season_ode(const double& m, const double& d_yp, const double& d_b0, const double& d_bp, const double& g_yp, const double& g_b0, const double& g_bp, const double& L_0, const double& P_max, const double& q, const double& s_0, const double& h, const double& f_0, const double& F_tilde, const double& u, const double& R_hat, const double& t0, const double& k, const double& lambda, const double& dt, const double& max_t, const double& Y0, const double& B0, const double& N0);
 RcppExport SEXP _sweetsoursong_one_plant_season_ode(SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP qSEXP, SEXP s_0SEXP, SEXP hSEXP, SEXP f_0SEXP, SEXP F_tildeSEXP, SEXP uSEXP, SEXP R_hatSEXP, SEXP t0SEXP, SEXP kSEXP, SEXP lambdaSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP N0SEXP) {
@@ -225,6 +911,65 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// landscape_constantF_sensitivity
+NumericMatrix landscape_constantF_sensitivity(const std::vector<double>& m, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const double& u, const double& X, const std::vector<double>& Y0, const std::vector<double>& B0, const std::vector<std::string>& sens_pars, const double& dt, const double& max_t, const bool& show_progress);
+RcppExport SEXP _sweetsoursong_landscape_constantF_sensitivity(SEXP mSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP uSEXP, SEXP XSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP sens_parsSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP show_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type X(XSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type sens_pars(sens_parsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_constantF_sensitivity(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X, Y0, B0, sens_pars, dt, max_t, show_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
+// landscape_sensitivity
+NumericMatrix landscape_sensitivity(const std::vector<double>& m, const std::vector<double>& R, const std::vector<double>& d_yp, const std::vector<double>& d_b0, const std::vector<double>& d_bp, const std::vector<double>& g_yp, const std::vector<double>& g_b0, const std::vector<double>& g_bp, const std::vector<double>& L_0, const std::vector<double>& P_max, const double& u, const double& q, const std::vector<double>& W, const double& w, const arma::mat& z, const double& min_F_for_P, const std::vector<double>& Y0, const std::vector<double>& B0, const std::vector<double>& N0, const std::vector<std::string>& sens_pars, const double& dt, const double& max_t, const bool& show_progress);
+RcppExport SEXP _sweetsoursong_landscape_sensitivity(SEXP mSEXP, SEXP RSEXP, SEXP d_ypSEXP, SEXP d_b0SEXP, SEXP d_bpSEXP, SEXP g_ypSEXP, SEXP g_b0SEXP, SEXP g_bpSEXP, SEXP L_0SEXP, SEXP P_maxSEXP, SEXP uSEXP, SEXP qSEXP, SEXP WSEXP, SEXP wSEXP, SEXP zSEXP, SEXP min_F_for_PSEXP, SEXP Y0SEXP, SEXP B0SEXP, SEXP N0SEXP, SEXP sens_parsSEXP, SEXP dtSEXP, SEXP max_tSEXP, SEXP show_progressSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type m(mSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type R(RSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_yp(d_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_b0(d_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type d_bp(d_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_yp(g_ypSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_b0(g_b0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type g_bp(g_bpSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type L_0(L_0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type P_max(P_maxSEXP);
+    Rcpp::traits::input_parameter< const double& >::type u(uSEXP);
+    Rcpp::traits::input_parameter< const double& >::type q(qSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type W(WSEXP);
+    Rcpp::traits::input_parameter< const double& >::type w(wSEXP);
+    Rcpp::traits::input_parameter< const arma::mat& >::type z(zSEXP);
+    Rcpp::traits::input_parameter< const double& >::type min_F_for_P(min_F_for_PSEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type Y0(Y0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type B0(B0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<double>& >::type N0(N0SEXP);
+    Rcpp::traits::input_parameter< const std::vector<std::string>& >::type sens_pars(sens_parsSEXP);
+    Rcpp::traits::input_parameter< const double& >::type dt(dtSEXP);
+    Rcpp::traits::input_parameter< const double& >::type max_t(max_tSEXP);
+    Rcpp::traits::input_parameter< const bool& >::type show_progress(show_progressSEXP);
+    rcpp_result_gen = Rcpp::wrap(landscape_sensitivity(m, R, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, u, q, W, w, z, min_F_for_P, Y0, B0, N0, sens_pars, dt, max_t, show_progress));
+    return rcpp_result_gen;
+END_RCPP
+}
 // stoch_test
 NumericMatrix stoch_test();
 RcppExport SEXP _sweetsoursong_stoch_test() {
@@ -288,6 +1033,20 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// normal_draws_rcpp
+NumericMatrix normal_draws_rcpp(const uint32_t& n_blocks, const uint32_t& block_size, const double& seed, const uint32_t& rep);
+RcppExport SEXP _sweetsoursong_normal_draws_rcpp(SEXP n_blocksSEXP, SEXP block_sizeSEXP, SEXP seedSEXP, SEXP repSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const uint32_t& >::type n_blocks(n_blocksSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type block_size(block_sizeSEXP);
+    Rcpp::traits::input_parameter< const double& >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< const uint32_t& >::type rep(repSEXP);
+    rcpp_result_gen = Rcpp::wrap(normal_draws_rcpp(n_blocks, block_size, seed, rep));
+    return rcpp_result_gen;
+END_RCPP
+}
 // dissimilarity
 double dissimilarity(NumericVector yeast, NumericVector bact);
 RcppExport SEXP _sweetsoursong_dissimilarity(SEXP yeastSEXP, SEXP bactSEXP) {
@@ -329,18 +1088,41 @@ END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_sweetsoursong_landscape_ode", (DL_FUNC) &_sweetsoursong_landscape_ode, 21},
-    {"_sweetsoursong_landscape_constantF_ode", (DL_FUNC) &_sweetsoursong_landscape_constantF_ode, 14},
-    {"_sweetsoursong_landscape_constantF_stoch_ode", (DL_FUNC) &_sweetsoursong_landscape_constantF_stoch_ode, 19},
-    {"_sweetsoursong_landscape_season_ode", (DL_FUNC) &_sweetsoursong_landscape_season_ode, 24},
+    {"_sweetsoursong_landscape_adjoint_gradient", (DL_FUNC) &_sweetsoursong_landscape_adjoint_gradient, 24},
+    {"_sweetsoursong_landscape_constantF_basins", (DL_FUNC) &_sweetsoursong_landscape_constantF_basins, 25},
+    {"_sweetsoursong_one_plant_continuation", (DL_FUNC) &_sweetsoursong_one_plant_continuation, 26},
+    {"_sweetsoursong_one_plant_bifurcation_curve", (DL_FUNC) &_sweetsoursong_one_plant_bifurcation_curve, 29},
+    {"_sweetsoursong_landscape_constantF_continuation", (DL_FUNC) &_sweetsoursong_landscape_constantF_continuation, 19},
+    {"_sweetsoursong_landscape_constantF_bifurcation_curve", (DL_FUNC) &_sweetsoursong_landscape_constantF_bifurcation_curve, 22},
+    {"_sweetsoursong_landscape_constantF_fit", (DL_FUNC) &_sweetsoursong_landscape_constantF_fit, 20},
+    {"_sweetsoursong_landscape_fit", (DL_FUNC) &_sweetsoursong_landscape_fit, 27},
+    {"_sweetsoursong_landscape_ode", (DL_FUNC) &_sweetsoursong_landscape_ode, 27},
+    {"_sweetsoursong_landscape_constantF_ode", (DL_FUNC) &_sweetsoursong_landscape_constantF_ode, 20},
+    {"_sweetsoursong_landscape_constantF_stoch_ode", (DL_FUNC) &_sweetsoursong_landscape_constantF_stoch_ode, 39},
+    {"_sweetsoursong_landscape_constantF_stoch_compare", (DL_FUNC) &_sweetsoursong_landscape_constantF_stoch_compare, 14},
+    {"_sweetsoursong_landscape_constantF_stoch_sweep", (DL_FUNC) &_sweetsoursong_landscape_constantF_stoch_sweep, 22},
+    {"_sweetsoursong_landscape_constantF_stoch_ams", (DL_FUNC) &_sweetsoursong_landscape_constantF_stoch_ams, 27},
+    {"_sweetsoursong_landscape_constantF_stoch_abc", (DL_FUNC) &_sweetsoursong_landscape_constantF_stoch_abc, 25},
+    {"_sweetsoursong_landscape_season_ode", (DL_FUNC) &_sweetsoursong_landscape_season_ode, 34},
+    {"_sweetsoursong_landscape_multiseason_ode", (DL_FUNC) &_sweetsoursong_landscape_multiseason_ode, 30},
+    {"_sweetsoursong_landscape_stoch_ode", (DL_FUNC) &_sweetsoursong_landscape_stoch_ode, 36},
+    {"_sweetsoursong_landscape_season_stoch_ode", (DL_FUNC) &_sweetsoursong_landscape_season_stoch_ode, 39},
+    {"_sweetsoursong_landscape_sweep", (DL_FUNC) &_sweetsoursong_landscape_sweep, 12},
+    {"_sweetsoursong_landscape_season_sweep", (DL_FUNC) &_sweetsoursong_landscape_season_sweep, 12},
     {"_sweetsoursong_run_ode_cpp", (DL_FUNC) &_sweetsoursong_run_ode_cpp, 21},
+    {"_sweetsoursong_local_multistrain_ode", (DL_FUNC) &_sweetsoursong_local_multistrain_ode, 21},
     {"_sweetsoursong_one_plant_ode", (DL_FUNC) &_sweetsoursong_one_plant_ode, 21},
+    {"_sweetsoursong_one_plant_batch_ode", (DL_FUNC) &_sweetsoursong_one_plant_batch_ode, 7},
+    {"_sweetsoursong_one_plant_season_batch_ode", (DL_FUNC) &_sweetsoursong_one_plant_season_batch_ode, 7},
     {"_sweetsoursong_one_plant_season_ode", (DL_FUNC) &_sweetsoursong_one_plant_season_ode, 24},
+    {"_sweetsoursong_landscape_constantF_sensitivity", (DL_FUNC) &_sweetsoursong_landscape_constantF_sensitivity, 16},
+    {"_sweetsoursong_landscape_sensitivity", (DL_FUNC) &_sweetsoursong_landscape_sensitivity, 23},
     {"_sweetsoursong_stoch_test", (DL_FUNC) &_sweetsoursong_stoch_test, 0},
     {"_sweetsoursong_make_dist_mat_rcpp", (DL_FUNC) &_sweetsoursong_make_dist_mat_rcpp, 2},
     {"_sweetsoursong_make_spat_wts_rcpp", (DL_FUNC) &_sweetsoursong_make_spat_wts_rcpp, 2},
     {"_sweetsoursong_test_R", (DL_FUNC) &_sweetsoursong_test_R, 3},
     {"_sweetsoursong_landscape_weights", (DL_FUNC) &_sweetsoursong_landscape_weights, 6},
+    {"_sweetsoursong_normal_draws_rcpp", (DL_FUNC) &_sweetsoursong_normal_draws_rcpp, 4},
     {"_sweetsoursong_dissimilarity", (DL_FUNC) &_sweetsoursong_dissimilarity, 2},
     {"_sweetsoursong_dissimilarity_vector", (DL_FUNC) &_sweetsoursong_dissimilarity_vector, 4},
     {"_sweetsoursong_diversity", (DL_FUNC) &_sweetsoursong_diversity, 3},
@@ -0,0 +1,227 @@
+
+/*
+ Adjoint gradients for `landscape_ode` (see adjoint.h).
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <limits>
+
+#include "ode.h"
+#include "landscape.h"
+#include "adjoint.h"
+#include "checkpoint.h"
+#include "progress.h"
+
+using namespace Rcpp;
+
+
+
+/*
+ Number of steps `integrate_const_from` takes from 0 to `max_t`, using the
+ same test so it always matches (e.g., it stops short of `max_t` when
+ rounding makes the last time a bit larger than it).
+ */
+inline size_t adjoint_n_steps(const double& dt, const double& max_t) {
+    size_t n = 0;
+    while ((0.0 + static_cast<double>(n) * dt + dt) - max_t <=
+           std::numeric_limits<double>::epsilon()) n++;
+    return n;
+}
+
+
+
+/*
+ Re-run steps `k0` to `k1` starting from the state at `k0`, storing
+ states and their derivatives at every step.
+ Steps are the same as in `integrate_const_from`, so these match the
+ forward run exactly.
+ */
+inline bool adjoint_segment(NonSeasonalLandscapeAdjoint& system,
+                            const MatType& x0,
+                            const size_t& k0,
+                            const size_t& k1,
+                            const double& dt,
+                            std::vector<MatType>& xs,
+                            std::vector<MatType>& fs,
+                            ProgressTicker& ticker) {
+    CheckpointStepper stepper;
+    MatType x(x0);
+    xs.resize(k1 - k0 + 1U);
+    fs.resize(k1 - k0 + 1U);
+    for (size_t k = k0; k <= k1; k++) {
+        double t = 0.0 + static_cast<double>(k) * dt;
+        xs[k - k0] = x;
+        fs[k - k0].set_size(x.n_rows, x.n_cols);
+        system(x, fs[k - k0], t);
+        if (k == k1) break;
+        stepper.do_step(std::ref(system), x, t, dt);
+        if (! ticker.tick()) return false;
+    }
+    return true;
+}
+
+
+
+/*
+ Gradient of the squared-error loss between `landscape_ode` output and
+ observed proportions of flowers colonized by yeast and bacteria.
+ `obs` has columns for time (multiples of `dt`), plant (starting at 0,
+ as in `landscape_ode` output), and observed Y / F and B / F
+ (either can be NA).
+ Returns one row per plant with gradients for each per-plant parameter,
+ with the loss and gradients for `u`, `q`, and `w` as attributes.
+
+ Only states every `checkpoint_steps` steps are stored from the forward run,
+ and the steps in between are re-run one segment at a time on the way back,
+ so memory is about (number of steps / checkpoint_steps + checkpoint_steps)
+ states. The default (0) uses the square root of the number of steps.
+ The adjoint equations are solved backward using 4th-order Runge-Kutta
+ on the output time steps, with states between steps from cubic Hermite
+ interpolation.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_adjoint_gradient(const std::vector<double>& m,
+                                         const std::vector<double>& R,
+                                         const std::vector<double>& d_yp,
+                                         const std::vector<double>& d_b0,
+                                         const std::vector<double>& d_bp,
+                                         const std::vector<double>& g_yp,
+                                         const std::vector<double>& g_b0,
+                                         const std::vector<double>& g_bp,
+                                         const std::vector<double>& L_0,
+                                         const std::vector<double>& P_max,
+                                         const double& u,
+                                         const double& q,
+                                         const std::vector<double>& W,
+                                         const double& w,
+                                         const arma::mat& z,
+                                         const double& min_F_for_P,
+                                         const std::vector<double>& Y0,
+                                         const std::vector<double>& B0,
+                                         const std::vector<double>& N0,
+                                         const NumericMatrix& obs,
+                                         const double& dt = 0.1,
+                                         const double& max_t = 90.0,
+                                         const uint32_t& checkpoint_steps = 0,
+                                         const bool& show_progress = false) {
+
+    size_t np = z.n_rows;
+    bool err = lanscape_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                   L_0, P_max, u, q, W, w, z, min_F_for_P,
+                                   Y0, B0, dt, max_t);
+    len_check(err, R, "R", np);
+    len_check(err, N0, "N0", np);
+    min_val_check(err, R, "R", 0);
+    min_val_check(err, N0, "N0", 0);
+    if (err) return NumericMatrix(0,0);
+
+    size_t n_steps = adjoint_n_steps(dt, max_t);
+    SurveyLoss survey(obs, np, dt, n_steps, err);
+    if (err) return NumericMatrix(0,0);
+
+    size_t every = checkpoint_steps;
+    if (every == 0) {
+        every = static_cast<size_t>(std::ceil(std::sqrt(
+            static_cast<double>(n_steps))));
+    }
+    every = std::max(every, static_cast<size_t>(1U));
+
+    MatType x(np, 3);
+    for (size_t i = 0; i < np; i++) {
+        x(i,0) = Y0[i];
+        x(i,1) = B0[i];
+        x(i,2) = N0[i];
+    }
+
+    NonSeasonalLandscapeAdjoint system(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                       L_0, P_max, u, q, W, w, z,
+                                       min_F_for_P, R);
+
+    // Forward run (twice) plus backward run:
+    Progress progress(1U, 3U * n_steps, show_progress);
+    ProgressTicker ticker(progress, true);
+
+    // ------------
+    // Forward, storing checkpoints:
+    // ------------
+    std::vector<MatType> checkpoints;
+    {
+        CheckpointStepper stepper;
+        for (size_t k = 0; k < n_steps; k++) {
+            if (k % every == 0) checkpoints.push_back(x);
+            stepper.do_step(std::ref(system), x,
+                            0.0 + static_cast<double>(k) * dt, dt);
+            if (! ticker.tick()) {
+                ticker.flush();
+                progress.finish();
+                return NumericMatrix(0,0);
+            }
+        }
+    }
+
+    // ------------
+    // Backward, one segment at a time:
+    // ------------
+    MatType lambda(np, 3, arma::fill::zeros);
+    arma::mat plant_grad(np, adjoint_plant_pars.size(), arma::fill::zeros);
+    arma::vec scalar_grad(adjoint_scalar_pars.size(), arma::fill::zeros);
+    double loss = survey.add(n_steps, x, lambda);
+
+    std::vector<MatType> xs, fs;
+    MatType x_mid, lam_tmp, k1, k2, k3, k4;
+    const double h = dt;
+    for (size_t c = checkpoints.size(); c > 0; c--) {
+        size_t k0 = (c - 1U) * every;
+        size_t k_end = std::min(k0 + every, n_steps);
+        if (! adjoint_segment(system, checkpoints[c-1U], k0, k_end, dt, xs, fs,
+                              ticker)) {
+            ticker.flush();
+            progress.finish();
+            return NumericMatrix(0,0);
+        }
+        for (size_t k = k_end; k > k0; k--) {
+            const MatType& x1(xs[k - k0]);
+            const MatType& x0(xs[k - 1U - k0]);
+            x_mid = 0.5 * (x0 + x1) + (h / 8) * (fs[k - 1U - k0] - fs[k - k0]);
+            system.vjp(x1, lambda, k1, h / 6, plant_grad, scalar_grad);
+            lam_tmp = lambda + (h / 2) * k1;
+            system.vjp(x_mid, lam_tmp, k2, h / 3, plant_grad, scalar_grad);
+            lam_tmp = lambda + (h / 2) * k2;
+            system.vjp(x_mid, lam_tmp, k3, h / 3, plant_grad, scalar_grad);
+            lam_tmp = lambda + h * k3;
+            system.vjp(x0, lam_tmp, k4, h / 6, plant_grad, scalar_grad);
+            lambda += (h / 6) * (k1 + 2 * k2 + 2 * k3 + k4);
+            loss += survey.add(k - 1U, x0, lambda);
+            if (! ticker.tick()) {
+                ticker.flush();
+                progress.finish();
+                return NumericMatrix(0,0);
+            }
+        }
+        checkpoints.pop_back();
+    }
+    ticker.flush();
+    progress.add_rep();
+    if (! progress.finish()) return NumericMatrix(0,0);
+
+    NumericMatrix output(np, 1U + adjoint_plant_pars.size());
+    CharacterVector cn = CharacterVector::create("p");
+    for (const std::string& s : adjoint_plant_pars) cn.push_back(s);
+    colnames(output) = cn;
+    for (size_t i = 0; i < np; i++) {
+        output(i,0) = i;
+        for (size_t j = 0; j < adjoint_plant_pars.size(); j++) {
+            output(i,j+1U) = plant_grad(i,j);
+        }
+    }
+    output.attr("loss") = loss;
+    for (size_t j = 0; j < adjoint_scalar_pars.size(); j++) {
+        output.attr(adjoint_scalar_pars[j]) = scalar_grad(j);
+    }
+
+    return output;
+}
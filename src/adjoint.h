@@ -0,0 +1,321 @@
+# ifndef __SWEETSOURSONG_ADJOINT_H
+# define __SWEETSOURSONG_ADJOINT_H
+
+
+/*
+ Adjoint gradients for the non-seasonal landscape model.
+ For a loss L that's a sum of terms at time points along the trajectory,
+ the adjoint lambda = dL/dx follows d(lambda)/dt = -J^T lambda backward in
+ time (jumping by dL/dx at each observation), and the gradient of L with
+ respect to parameters theta is the integral of (df/d(theta))^T lambda.
+ This costs about the same as a few forward runs no matter how many
+ parameters there are, unlike forward sensitivities (see sensitivity.h).
+
+ J^T lambda and (df/d(theta))^T lambda are found by going backward through
+ the RHS by hand (see `NonSeasonalLandscapeAdjoint::vjp`), so neither J nor
+ df/d(theta) is ever formed.
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <string>
+#include <cmath>
+
+#include "ode.h"
+#include "landscape.h"
+
+
+using namespace Rcpp;
+
+
+
+// Per-plant parameters that gradients are returned for, in order:
+const std::vector<std::string> adjoint_plant_pars = {"m", "R", "d_yp", "d_b0",
+                                                     "d_bp", "g_yp", "g_b0",
+                                                     "g_bp", "L_0", "P_max",
+                                                     "W"};
+// ... and the same for parameters with one value:
+const std::vector<std::string> adjoint_scalar_pars = {"u", "q", "w"};
+
+
+
+class NonSeasonalLandscapeAdjoint : public NonSeasonalLandscape
+{
+public:
+
+    NonSeasonalLandscapeAdjoint(const std::vector<double>& m_,
+                                const std::vector<double>& d_yp_,
+                                const std::vector<double>& d_b0_,
+                                const std::vector<double>& d_bp_,
+                                const std::vector<double>& g_yp_,
+                                const std::vector<double>& g_b0_,
+                                const std::vector<double>& g_bp_,
+                                const std::vector<double>& L_0_,
+                                const std::vector<double>& P_max_,
+                                const double& u_,
+                                const double& q_,
+                                const std::vector<double>& W_,
+                                const double& w_,
+                                const arma::mat& z_,
+                                const double& min_F_for_P_,
+                                const std::vector<double>& R_)
+        : NonSeasonalLandscape(m_, d_yp_, d_b0_, d_bp_, g_yp_, g_b0_, g_bp_,
+                               L_0_, P_max_, u_, q_, W_, w_, z_, min_F_for_P_,
+                               R_),
+          dPhi(dPhi_dw__(w_, z_)),
+          a(z_.n_rows),
+          V(z_.n_rows, 2U),
+          G_bar(z_.n_rows, 2U) {};
+
+    /*
+     Set `lambda_dot` to J^T `lambda` at state `x`, and add
+     `weight * (df/d(theta))^T lambda` to `plant_grad` (columns in the
+     same order as `adjoint_plant_pars`) and `scalar_grad` (same order as
+     `adjoint_scalar_pars`).
+     */
+    void vjp(const MatType& x,
+             const MatType& lambda,
+             MatType& lambda_dot,
+             const double& weight,
+             arma::mat& plant_grad,
+             arma::vec& scalar_grad) {
+
+        const arma::vec Y(x.col(0));
+        const arma::vec B(x.col(1));
+        const arma::vec N(x.col(2));
+        const arma::vec lam_Y(lambda.col(0));
+        const arma::vec lam_B(lambda.col(1));
+        const arma::vec lam_N(lambda.col(2));
+
+        // ------------
+        // Going forward through the RHS:
+        // ------------
+        LandscapeSystemFunction::make_weights(this->weights, x);
+        double a_sum = 0;
+        for (size_t i = 0; i < n_plants; i++) {
+            a(i) = 0;
+            if (F(i) < min_F_for_P) continue;
+            a(i) = std::pow(F(i), q);
+            double YN = Y(i) + N(i);
+            if (F(i) > 0) YN /= F(i);
+            a(i) *= std::pow(YN, u);
+            a_sum += a(i);
+        }
+        arma::vec P = P_max % weights;
+        arma::vec PF(n_plants, arma::fill::zeros);
+        arma::vec YF(n_plants, arma::fill::zeros);
+        arma::vec BF(n_plants, arma::fill::zeros);
+        for (size_t i = 0; i < n_plants; i++) {
+            if (F(i) <= 0) continue;
+            PF(i) = P(i) / F(i);
+            YF(i) = Y(i) / F(i);
+            BF(i) = B(i) / F(i);
+        }
+        arma::vec LPF = L_0 + PF;
+        arma::vec Lambda = PF / LPF;
+        arma::vec delta_y = d_yp % Lambda;
+        arma::vec delta_b = d_b0 + d_bp % Lambda;
+        V.col(0) = delta_y % YF + g_yp % Lambda;
+        V.col(1) = delta_b % BF + g_b0 + g_bp % Lambda;
+        arma::mat PhiV = (*Phi) * V;
+
+        // ------------
+        // ... and backward:
+        // ------------
+        arma::vec gy_bar = lam_Y - lam_N;
+        arma::vec gb_bar = lam_B - lam_N;
+        plant_grad.col(0) -= weight * (lam_Y % Y + lam_B % B + lam_N % N);
+        plant_grad.col(1) += weight * lam_N;
+
+        arma::vec Y_bar = -m % lam_Y;
+        arma::vec B_bar = -m % lam_B;
+        arma::vec N_bar = -m % lam_N + gy_bar % PhiV.col(0) +
+            gb_bar % PhiV.col(1);
+
+        G_bar.col(0) = N % gy_bar;
+        G_bar.col(1) = N % gb_bar;
+        arma::mat V_bar = Phi->t() * G_bar;
+        scalar_grad(2) += weight * arma::accu(G_bar % ((*dPhi) * V));
+
+        arma::vec delta_y_bar = V_bar.col(0) % YF;
+        arma::vec delta_b_bar = V_bar.col(1) % BF;
+        arma::vec YF_bar = V_bar.col(0) % delta_y;
+        arma::vec BF_bar = V_bar.col(1) % delta_b;
+        // (gamma_y_bar and gamma_b_bar are just the columns of V_bar)
+        plant_grad.col(2) += weight * (delta_y_bar % Lambda);
+        plant_grad.col(3) += weight * delta_b_bar;
+        plant_grad.col(4) += weight * (delta_b_bar % Lambda);
+        plant_grad.col(5) += weight * (V_bar.col(0) % Lambda);
+        plant_grad.col(6) += weight * V_bar.col(1);
+        plant_grad.col(7) += weight * (V_bar.col(1) % Lambda);
+
+        arma::vec Lambda_bar = delta_y_bar % d_yp + delta_b_bar % d_bp +
+            V_bar.col(0) % g_yp + V_bar.col(1) % g_bp;
+        arma::vec LPF2 = LPF % LPF;
+        arma::vec PF_bar = Lambda_bar % L_0 / LPF2;
+        plant_grad.col(8) -= weight * (Lambda_bar % PF / LPF2);
+
+        arma::vec F_bar(n_plants, arma::fill::zeros);
+        arma::vec P_bar(n_plants, arma::fill::zeros);
+        for (size_t i = 0; i < n_plants; i++) {
+            if (F(i) <= 0) continue;
+            P_bar(i) = PF_bar(i) / F(i);
+            Y_bar(i) += YF_bar(i) / F(i);
+            B_bar(i) += BF_bar(i) / F(i);
+            F_bar(i) -= (PF_bar(i) * PF(i) + YF_bar(i) * YF(i) +
+                BF_bar(i) * BF(i)) / F(i);
+        }
+        plant_grad.col(9) += weight * (P_bar % weights);
+
+        // Weights are `a` divided by their sum (plus W):
+        arma::vec a_bar = P_bar % P_max;
+        double S_bar = 0;
+        for (size_t i = 0; i < n_plants; i++) {
+            if (a_sum > 0 || W(i) > 0) {
+                double D = a_sum + W(i);
+                double D_bar = -a_bar(i) * weights(i) / D;
+                a_bar(i) /= D;
+                plant_grad(i,10) += weight * D_bar;
+                S_bar += D_bar;
+            }
+        }
+        a_bar += S_bar;
+        for (size_t i = 0; i < n_plants; i++) {
+            if (a(i) <= 0 || F(i) <= 0) continue;
+            double c = a_bar(i) * a(i);
+            scalar_grad(1) += weight * c * std::log(F(i));
+            F_bar(i) += c * q / F(i);
+            double YN = (Y(i) + N(i)) / F(i);
+            if (YN > 0) {
+                scalar_grad(0) += weight * c * std::log(YN);
+                double YN_bar = c * u / YN;
+                Y_bar(i) += YN_bar / F(i);
+                N_bar(i) += YN_bar / F(i);
+                F_bar(i) -= YN_bar * YN / F(i);
+            }
+        }
+
+        if (lambda_dot.n_rows != n_plants || lambda_dot.n_cols != 3U) {
+            lambda_dot.set_size(n_plants, 3U);
+        }
+        lambda_dot.col(0) = Y_bar + F_bar;
+        lambda_dot.col(1) = B_bar + F_bar;
+        lambda_dot.col(2) = N_bar + F_bar;
+
+        return;
+    }
+
+private:
+
+    std::shared_ptr<const arma::mat> dPhi;  // d(Phi)/dw
+    arma::vec a;        // weights before dividing by their sum (plus W)
+    arma::mat V;        // vectors multiplied by Phi in the RHS
+    arma::mat G_bar;
+
+    // d(Phi)/dw, where Phi has columns exp(-w * z) normalized to sum to 1:
+    std::shared_ptr<const arma::mat> dPhi_dw__(const double& w_,
+                                               const arma::mat& z_) const {
+        arma::mat out(n_plants, n_plants);
+        arma::vec E(n_plants), dE(n_plants);
+        for (size_t j = 0; j < n_plants; j++) {
+            double col_sum = 0, dcol_sum = 0;
+            for (size_t i = 0; i < n_plants; i++) {
+                E(i) = (i == j) ? 1 : std::exp(-w_ * z_(i,j));
+                dE(i) = (i == j) ? 0 : -z_(i,j) * E(i);
+                col_sum += E(i);
+                dcol_sum += dE(i);
+            }
+            for (size_t i = 0; i < n_plants; i++) {
+                out(i,j) = (dE(i) - E(i) * dcol_sum / col_sum) / col_sum;
+            }
+        }
+        return std::make_shared<const arma::mat>(std::move(out));
+    }
+
+};
+
+
+
+
+/*
+ Squared-error loss against observed proportions of flowers that are
+ colonized by yeast (Y / F) and bacteria (B / F) at survey times.
+ Observations are stored by output time step, and NAs are skipped.
+ */
+class SurveyLoss
+{
+public:
+
+    SurveyLoss(const NumericMatrix& obs,
+               const size_t& n_plants,
+               const double& dt,
+               const uint64_t& n_steps,
+               bool& err)
+        : by_step(n_steps + 1U) {
+
+        if (obs.ncol() != 4) {
+            Rcout << "obs should have 4 columns (t, p, Y, and B)!" << std::endl;
+            err = true;
+            return;
+        }
+        for (size_t r = 0; r < static_cast<size_t>(obs.nrow()); r++) {
+            double t = obs(r,0), p = obs(r,1);
+            double k = std::round(t / dt);
+            if (! (k >= 0 && k <= static_cast<double>(n_steps)) ||
+                ! same_time(k * dt, t)) {
+                Rcout << "Observation times should be multiples of dt between ";
+                Rcout << "0 and max_t (row " << (r + 1U) << ")!" << std::endl;
+                err = true;
+                return;
+            }
+            if (! (p >= 0 && p < static_cast<double>(n_plants)) ||
+                p != std::floor(p)) {
+                Rcout << "Observation plants should be integers from 0 to ";
+                Rcout << "the number of plants minus one (row " << (r + 1U);
+                Rcout << ")!" << std::endl;
+                err = true;
+                return;
+            }
+            by_step[static_cast<size_t>(k)].push_back(
+                Survey{static_cast<size_t>(p), obs(r,2), obs(r,3)});
+        }
+    };
+
+    /*
+     Loss for time step `k` at state `x`, adding its gradient with respect
+     to `x` to `lambda`.
+     */
+    double add(const size_t& k, const MatType& x, MatType& lambda) const {
+        double loss = 0;
+        for (const Survey& s : by_step[k]) {
+            const size_t& i(s.plant);
+            double F = x(i,0) + x(i,1) + x(i,2);
+            if (F <= 0) continue;
+            double YF = x(i,0) / F, BF = x(i,1) / F;
+            double rY = 0, rB = 0;
+            if (! std::isnan(s.Y)) rY = YF - s.Y;
+            if (! std::isnan(s.B)) rB = BF - s.B;
+            loss += rY * rY + rB * rB;
+            // d(Y/F)/dY = (1 - Y/F) / F, d(Y/F)/dB = d(Y/F)/dN = -(Y/F) / F:
+            double common = -2 * (rY * YF + rB * BF) / F;
+            lambda(i,0) += common + 2 * rY / F;
+            lambda(i,1) += common + 2 * rB / F;
+            lambda(i,2) += common;
+        }
+        return loss;
+    }
+
+private:
+
+    struct Survey {
+        size_t plant;
+        double Y;
+        double B;
+    };
+    std::vector<std::vector<Survey>> by_step;
+};
+
+
+
+
+#endif
@@ -0,0 +1,435 @@
+/*
+ Basins of attraction for `landscape_constantF_ode`.
+
+ Starting states lie on a plane through the space of Y0 and B0:
+ for coordinates `s1` and `s2` in [0,1],
+   Y0 + s1 * Y0_1 + s2 * Y0_2  and  B0 + s1 * B0_1 + s2 * B0_2,
+ so, e.g., `Y0_1` and `B0_2` being all 1 (and the rest 0) maps Y0 against
+ B0 at all plants, and `Y0_1` and `Y0_2` being 1 only at plants 1 and 2
+ maps Y0 at plant 1 against plant 2.
+ Each start is integrated until it stops changing (largest |dx/dt| at or
+ below `tol`) or until `max_t`, and final states within `attr_tol` of each
+ other (largest absolute difference) are the same attractor.
+ Starts that haven't converged by `max_t` aren't assigned an attractor,
+ since their final states could be anywhere along a slow transient.
+
+ The map starts as an `n_grid` x `n_grid` grid of cells (each run from its
+ center), and cells bordering a cell with a different attractor are split
+ into four, `n_refine` times. Since only cells along basin boundaries are
+ split, this costs much less than a uniform grid at the finest resolution.
+ Basins (or parts of them) that fit between the centers of the starting
+ cells can be missed, so `n_grid` should be large enough to hit each one.
+ */
+
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "ode.h"
+#include "landscape_constantF.h"
+#include "outcomes.h"
+#include "checkpoint.h"
+#include "progress.h"
+#include "scheduler.h"
+
+#include <RcppParallel.h>
+
+
+using namespace Rcpp;
+
+
+
+// One cell of the map, in units of the finest cells:
+struct BasinCell {
+    size_t i;
+    size_t j;
+    size_t size;
+    // 0 if its start isn't a valid state or it didn't converge,
+    // otherwise an index to `attractors`:
+    size_t attractor;
+    double t_end;
+    bool valid;
+    bool converged;
+};
+
+
+
+class BasinMapper
+{
+public:
+
+    const LandscapeConstF& system0;
+    std::vector<BasinCell> cells;
+    // Final state for each attractor (index 0 is unused):
+    std::vector<MatType> attractors;
+
+    BasinMapper(const LandscapeConstF& system0_,
+                const MatType& x0_,
+                const MatType& dir1_,
+                const MatType& dir2_,
+                const size_t& n_grid,
+                const size_t& n_refine_,
+                const double& tol_,
+                const double& attr_tol_,
+                const double& dt_,
+                const double& max_t_)
+        : system0(system0_),
+          cells(),
+          attractors(1U),
+          x0(x0_),
+          dir1(dir1_),
+          dir2(dir2_),
+          n_refine(n_refine_),
+          n_fine(n_grid << n_refine_),
+          tol(tol_),
+          attr_tol(attr_tol_),
+          dt(dt_),
+          max_steps(n_const_steps(dt_, max_t_)),
+          labels(n_fine * n_fine, 0U) {
+
+        size_t size = static_cast<size_t>(1U) << n_refine;
+        for (size_t j = 0; j < n_grid; j++) {
+            for (size_t i = 0; i < n_grid; i++) {
+                cells.push_back(BasinCell{i * size, j * size, size, 0U,
+                                          arma::datum::nan, false, false});
+            }
+        }
+    };
+
+    // Map coordinates of a cell's center:
+    double s1(const BasinCell& c) const {
+        return (static_cast<double>(c.i) + 0.5 * static_cast<double>(c.size)) /
+            static_cast<double>(n_fine);
+    }
+    double s2(const BasinCell& c) const {
+        return (static_cast<double>(c.j) + 0.5 * static_cast<double>(c.size)) /
+            static_cast<double>(n_fine);
+    }
+
+    /*
+     Run from the center of `c`, leaving the final state in `x`.
+     Returns false if the start isn't a valid state.
+     */
+    bool run_cell(BasinCell& c,
+                  MatType& x,
+                  LandscapeConstF& system,
+                  ProgressTicker& ticker) const {
+
+        x = x0 + s1(c) * dir1 + s2(c) * dir2;
+        c.valid = false;
+        for (size_t i = 0; i < x.n_rows; i++) {
+            if (x(i,0) < 0 || x(i,1) < 0 || x(i,0) + x(i,1) > 1) return false;
+        }
+        c.valid = true;
+        CheckpointStepper stepper;
+        size_t step = 0;
+        c.converged = false;
+        while (step < max_steps && ! c.converged) {
+            stepper.do_step(std::ref(system), x,
+                            static_cast<double>(step) * dt, dt);
+            step++;
+            // (dopri5's derivative at the new state is already there)
+            c.converged = arma::abs(stepper.dxdt).max() <= tol;
+            if (! ticker.tick()) break;
+        }
+        c.t_end = static_cast<double>(step) * dt;
+        return true;
+    }
+
+    /*
+     Run all levels, refining cells along boundaries.
+     Returns false if cancelled.
+     */
+    bool run(Progress& progress,
+             const size_t& grain_size,
+             ThreadUsage& usage);
+
+private:
+    MatType x0;
+    MatType dir1;
+    MatType dir2;
+    size_t n_refine;
+    size_t n_fine;
+    double tol;
+    double attr_tol;
+    double dt;
+    size_t max_steps;
+    // Attractor for each of the finest cells (from the smallest cell so far):
+    std::vector<uint32_t> labels;
+
+    // Attractor for final state `x`, adding a new one if none are close:
+    size_t classify__(const MatType& x) {
+        for (size_t k = 1; k < attractors.size(); k++) {
+            if (arma::abs(x - attractors[k]).max() <= attr_tol) return k;
+        }
+        attractors.push_back(x);
+        return attractors.size() - 1U;
+    }
+
+    void paint__(const BasinCell& c) {
+        for (size_t j = c.j; j < c.j + c.size; j++) {
+            for (size_t i = c.i; i < c.i + c.size; i++) {
+                labels[j * n_fine + i] = static_cast<uint32_t>(c.attractor);
+            }
+        }
+        return;
+    }
+
+    // Whether any cell just outside the edges of `c` has another attractor:
+    bool on_boundary__(const BasinCell& c) const {
+        if (c.attractor == 0) return false;
+        auto differs = [&](const size_t& i, const size_t& j) {
+            size_t a = labels[j * n_fine + i];
+            return a != 0 && a != c.attractor;
+        };
+        for (size_t k = 0; k < c.size; k++) {
+            if (c.i > 0 && differs(c.i - 1U, c.j + k)) return true;
+            if (c.i + c.size < n_fine && differs(c.i + c.size, c.j + k)) return true;
+            if (c.j > 0 && differs(c.i + k, c.j - 1U)) return true;
+            if (c.j + c.size < n_fine && differs(c.i + k, c.j + c.size)) return true;
+        }
+        return false;
+    }
+};
+
+
+
+// RcppParallel Worker where each task is one cell:
+struct BasinWorker : public RcppParallel::Worker {
+
+    const BasinMapper& mapper;
+    std::vector<BasinCell>& cells;
+    // Final state for each cell (empty for invalid starts):
+    std::vector<MatType> finals;
+    Progress& progress;
+
+    BasinWorker(const BasinMapper& mapper_,
+                std::vector<BasinCell>& cells_,
+                Progress& progress_)
+        : mapper(mapper_), cells(cells_), finals(cells_.size()),
+          progress(progress_) {};
+
+    void operator()(size_t begin, size_t end) {
+        LandscapeConstF system(mapper.system0);
+        ProgressTicker ticker(progress, false);
+        for (size_t k = begin; k < end; k++) {
+            if (progress.cancelled()) break;
+            if (! mapper.run_cell(cells[k], finals[k], system, ticker)) {
+                finals[k].reset();
+            }
+            progress.add_rep();
+        }
+        return;
+    }
+};
+
+
+
+inline bool BasinMapper::run(Progress& progress,
+                             const size_t& grain_size,
+                             ThreadUsage& usage) {
+
+    std::vector<BasinCell> to_run(cells);
+    cells.clear();
+
+    for (size_t level = 0; level <= n_refine; level++) {
+
+        BasinWorker worker(*this, to_run, progress);
+        dynamic_parallel_for(worker, to_run.size(), grain_size, usage);
+        if (progress.cancelled()) return false;
+
+        // Attractors are numbered in cell order, so threads don't matter:
+        for (size_t k = 0; k < to_run.size(); k++) {
+            BasinCell& c(to_run[k]);
+            c.attractor = c.valid && c.converged ?
+                classify__(worker.finals[k]) : 0U;
+            paint__(c);
+        }
+
+        std::vector<BasinCell> next;
+        for (const BasinCell& c : to_run) {
+            if (level < n_refine && on_boundary__(c)) {
+                size_t h = c.size / 2U;
+                for (size_t dj = 0; dj < 2U; dj++) {
+                    for (size_t di = 0; di < 2U; di++) {
+                        next.push_back(BasinCell{c.i + di * h, c.j + dj * h, h,
+                                                 0U, arma::datum::nan, false,
+                                                 false});
+                    }
+                }
+            } else cells.push_back(c);
+        }
+        to_run.swap(next);
+    }
+
+    return true;
+}
+
+
+
+
+/*
+ Basins of attraction for `landscape_constantF_ode` (see top of this file).
+ Returns one row per cell of the final map with the coordinates of its
+ center (`s1` and `s2`), its width, its attractor (0 if its start isn't
+ a valid state, NA if it didn't converge by `max_t`), the landscape-wide
+ outcome of that attractor (codes are in outcomes.h), when the run stopped,
+ and whether it converged.
+ Final states of attractors (with columns for attractor, plant, Y, and B)
+ are in the `attractors` attribute, and the share of the map's area in
+ each basin (out of cells that are valid and converged) is in the `basins`
+ attribute. The number of cells that didn't converge is in the
+ `n_not_converged` attribute.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_constantF_basins(const std::vector<double>& m,
+                                         const std::vector<double>& d_yp,
+                                         const std::vector<double>& d_b0,
+                                         const std::vector<double>& d_bp,
+                                         const std::vector<double>& g_yp,
+                                         const std::vector<double>& g_b0,
+                                         const std::vector<double>& g_bp,
+                                         const std::vector<double>& L_0,
+                                         const double& u,
+                                         const double& X,
+                                         const std::vector<double>& Y0,
+                                         const std::vector<double>& B0,
+                                         const std::vector<double>& Y0_1,
+                                         const std::vector<double>& B0_1,
+                                         const std::vector<double>& Y0_2,
+                                         const std::vector<double>& B0_2,
+                                         const uint32_t& n_grid = 16,
+                                         const uint32_t& n_refine = 3,
+                                         const double& tol = 1e-8,
+                                         const double& attr_tol = 1e-4,
+                                         const double& threshold = 1e-6,
+                                         const double& dt = 0.1,
+                                         const double& max_t = 20e3,
+                                         const bool& show_progress = false,
+                                         const uint32_t& grain_size = 1) {
+
+    size_t np = m.size();
+    bool err = lanscape_constF_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                          L_0, u, X, Y0, B0, dt, max_t);
+    len_check(err, Y0_1, "Y0_1", np);
+    len_check(err, B0_1, "B0_1", np);
+    len_check(err, Y0_2, "Y0_2", np);
+    len_check(err, B0_2, "B0_2", np);
+    min_val_check(err, n_grid, "n_grid", 1);
+    // (The finest cells all get a label, so this limits memory to 256 MB)
+    double n_fine = std::ldexp(static_cast<double>(n_grid),
+                               static_cast<int>(std::min(n_refine, 30U)));
+    if (n_fine > 8192) {
+        Rcout << "n_grid * 2^n_refine should be <= 8192!" << std::endl;
+        err = true;
+    }
+    min_val_check(err, tol, "tol", 0);
+    min_val_check(err, attr_tol, "attr_tol", 0);
+    min_val_check(err, threshold, "threshold", 0);
+    min_val_check(err, grain_size, "grain_size", 1);
+    if (err) return NumericMatrix(0,0);
+
+    MatType x0(np, 2U), dir1(np, 2U), dir2(np, 2U);
+    for (size_t i = 0; i < np; i++) {
+        x0(i,0) = Y0[i];
+        x0(i,1) = B0[i];
+        dir1(i,0) = Y0_1[i];
+        dir1(i,1) = B0_1[i];
+        dir2(i,0) = Y0_2[i];
+        dir2(i,1) = B0_2[i];
+    }
+
+    LandscapeConstF system0(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X);
+    BasinMapper mapper(system0, x0, dir1, dir2, n_grid, n_refine, tol,
+                       attr_tol, dt, max_t);
+
+    // The number of cells isn't known ahead of time:
+    Progress progress(0U, 0U, show_progress);
+    ThreadUsage usage;
+    // All levels run in another thread:
+    bool finished = progress.run_parallel([&]() {
+        mapper.run(progress, grain_size, usage);
+    });
+    if (! finished) return NumericMatrix(0,0);
+
+    // Landscape-wide outcome for each attractor (as in `OutcomeTracker`):
+    size_t n_attr = mapper.attractors.size();
+    std::vector<int> attr_outcome(n_attr, 0);
+    for (size_t k = 1; k < n_attr; k++) {
+        const MatType& xk(mapper.attractors[k]);
+        attr_outcome[k] = classify_outcome(arma::accu(xk.col(0)),
+                                           arma::accu(xk.col(1)), threshold);
+    }
+
+    const std::vector<BasinCell>& cells(mapper.cells);
+    NumericMatrix output(cells.size(), 7U);
+    colnames(output) = CharacterVector::create("s1", "s2", "width",
+             "attractor", "outcome", "t_end", "converged");
+    for (size_t k = 0; k < cells.size(); k++) {
+        const BasinCell& c(cells[k]);
+        output(k,0) = mapper.s1(c);
+        output(k,1) = mapper.s2(c);
+        output(k,2) = static_cast<double>(c.size) / n_fine;
+        if (c.attractor > 0) {
+            output(k,3) = c.attractor;
+            output(k,4) = attr_outcome[c.attractor];
+            output(k,5) = c.t_end;
+            output(k,6) = 1;
+        } else if (c.valid) {
+            output(k,3) = NA_REAL;
+            output(k,4) = NA_REAL;
+            output(k,5) = c.t_end;
+            output(k,6) = 0;
+        } else {
+            output(k,3) = 0;
+            output(k,4) = NA_REAL;
+            output(k,5) = NA_REAL;
+            output(k,6) = NA_REAL;
+        }
+    }
+
+    NumericMatrix attr_out((n_attr - 1U) * np, 4U);
+    colnames(attr_out) = CharacterVector::create("attractor", "p", "Y", "B");
+    size_t i = 0;
+    for (size_t k = 1; k < n_attr; k++) {
+        for (size_t p = 0; p < np; p++) {
+            attr_out(i,0) = k;
+            attr_out(i,1) = p;
+            attr_out(i,2) = mapper.attractors[k](p,0);
+            attr_out(i,3) = mapper.attractors[k](p,1);
+            i++;
+        }
+    }
+    output.attr("attractors") = attr_out;
+
+    // Area in each basin, leaving out invalid and non-converged cells:
+    std::vector<double> area(n_attr, 0.0);
+    double total_area = 0;
+    uint32_t n_not_converged = 0;
+    for (const BasinCell& c : cells) {
+        if (c.valid && ! c.converged) n_not_converged++;
+        if (c.attractor == 0) continue;
+        double a = static_cast<double>(c.size) * static_cast<double>(c.size);
+        area[c.attractor] += a;
+        total_area += a;
+    }
+    NumericMatrix basins_out(n_attr - 1U, 3U);
+    colnames(basins_out) = CharacterVector::create("attractor", "outcome",
+             "fraction");
+    for (size_t k = 1; k < n_attr; k++) {
+        basins_out(k-1U,0) = k;
+        basins_out(k-1U,1) = attr_outcome[k];
+        basins_out(k-1U,2) = area[k] / total_area;
+    }
+    output.attr("basins") = basins_out;
+    output.attr("n_not_converged") = n_not_converged;
+    if (n_not_converged > 0) {
+        Rcout << "Warning: " << n_not_converged << " cell(s) didn't converge ";
+        Rcout << "by max_t and were left out of basins." << std::endl;
+    }
+
+    return output;
+}
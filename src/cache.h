@@ -0,0 +1,116 @@
+# ifndef __SWEETSOURSONG_CACHE_H
+# define __SWEETSOURSONG_CACHE_H
+
+
+/*
+ Persistent cache of simulation results, so repeating a run with identical
+ inputs (e.g., in another R session) only reads a file.
+ Results are stored in `<dir>/<engine>-<key>.bin`, where the key is a hash
+ of all inputs, the engine name, and `result_cache_version`.
+ Files have the same header as checkpoints (see checkpoint.h), so one
+ written by a different engine or with different inputs is never used.
+ Each file is written to its own temporary file then renamed, so
+ processes sharing a directory never see partial files, and if two write
+ the same result at once, one of them simply wins.
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+#include "checkpoint.h"
+#include "rng.h"
+
+using namespace Rcpp;
+
+
+/*
+ Change this whenever any engine's results change for the same inputs,
+ so old cached results aren't used.
+ (2: delayed strain arrivals in the local model are integrator events)
+ */
+const uint32_t result_cache_version = 2;
+
+
+
+class ResultCache
+{
+public:
+
+    // If `dir` is empty, nothing is read or written:
+    ResultCache(const std::string& dir,
+                const std::string& engine_,
+                const InputHash& inputs)
+        : file(),
+          engine(engine_),
+          hash(inputs) {
+        if (dir.empty()) return;
+        hash.add(engine, result_cache_version);
+        char key[17];
+        std::snprintf(key, sizeof(key), "%016llx",
+                      static_cast<unsigned long long>(hash.value));
+        file = dir + "/" + engine + "-" + key + ".bin";
+    };
+
+    bool enabled() const { return ! file.empty(); }
+
+    // Returns true and fills `output` if this result was cached.
+    bool load(NumericMatrix& output) const {
+        if (! enabled() || ! file_exists(file)) return false;
+        CheckpointReader reader(file, engine, hash.value);
+        if (! reader.good()) return false;
+        arma::mat values;
+        std::vector<std::string> names;
+        reader.read(values);
+        reader.read(names);
+        // Broken files are just re-run (and overwritten):
+        if (! reader.good() || names.size() != values.n_cols) return false;
+        output = NumericMatrix(values.n_rows, values.n_cols);
+        std::copy(values.begin(), values.end(), output.begin());
+        CharacterVector cn(names.size());
+        for (size_t j = 0; j < names.size(); j++) cn[j] = names[j];
+        colnames(output) = cn;
+        return true;
+    }
+
+    void store(NumericMatrix output) const {
+        if (! enabled() || output.ncol() == 0) return;
+        size_t nr = output.nrow(), nc = output.ncol();
+        arma::mat values(nr, nc);
+        std::copy(output.begin(), output.end(), values.begin());
+        std::vector<std::string> names(nc);
+        CharacterVector cn = colnames(output);
+        for (size_t j = 0; j < nc; j++) names[j] = as<std::string>(cn[j]);
+        // Unique for this process and call:
+        uint64_t stamp = splitmix64(static_cast<uint64_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count()) ^
+            splitmix64(reinterpret_cast<uintptr_t>(this)));
+        char suffix[22];
+        std::snprintf(suffix, sizeof(suffix), ".%016llx.tmp",
+                      static_cast<unsigned long long>(stamp));
+        CheckpointWriter writer(file, engine, hash.value, suffix);
+        writer.write(values);
+        writer.write(names);
+        /*
+         Replacing works for old or broken files too (see
+         `CheckpointWriter::commit`), so any failure here means this result
+         will keep being re-run:
+         */
+        if (! writer.commit()) {
+            Rcout << "Warning: cache file " << file << " could not be written.";
+            Rcout << std::endl;
+        }
+        return;
+    }
+
+private:
+    std::string file;
+    std::string engine;
+    InputHash hash;
+};
+
+
+#endif
@@ -0,0 +1,603 @@
+# ifndef __SWEETSOURSONG_CHECKPOINT_H
+# define __SWEETSOURSONG_CHECKPOINT_H
+
+
+/*
+ Binary checkpoints so that long runs can be stopped and later resumed
+ with exactly the same results as an uninterrupted run.
+ Each file starts with a header (magic string, format version, engine name,
+ and a hash of all inputs) so a checkpoint can only resume the simulation
+ that wrote it.
+ Files are first written to `<file>.tmp` then renamed, so a run killed
+ while writing never leaves a broken checkpoint behind.
+ Trajectories are appended to their own file instead (see `TrajectoryLog`),
+ so checkpoints stay the same size however long the run gets.
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+#include "ode.h"
+#include "progress.h"
+
+using namespace Rcpp;
+
+
+const char ckpt_magic[8] = {'S', 'S', 'S', 'C', 'K', 'P', 'T', '\0'};
+const uint32_t ckpt_version = 2;
+
+
+
+// FNV-1a hash of simulation inputs:
+class InputHash
+{
+public:
+    uint64_t value;
+
+    InputHash() : value(14695981039346656037ULL) {};
+
+    void add_bytes(const void* ptr, const size_t& n) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(ptr);
+        for (size_t i = 0; i < n; i++) {
+            value ^= static_cast<uint64_t>(bytes[i]);
+            value *= 1099511628211ULL;
+        }
+        return;
+    }
+
+    template< class T >
+    typename std::enable_if<std::is_arithmetic<T>::value>::type
+    add(const T& x) {
+        add_bytes(&x, sizeof(T));
+        return;
+    }
+    template< class T >
+    void add(const std::vector<T>& x) {
+        add(static_cast<uint64_t>(x.size()));
+        for (const T& xi : x) add(xi);
+        return;
+    }
+    void add(const std::vector<bool>& x) {
+        add(static_cast<uint64_t>(x.size()));
+        for (size_t i = 0; i < x.size(); i++) add(static_cast<bool>(x[i]));
+        return;
+    }
+    void add(const arma::mat& x) {
+        add(static_cast<uint64_t>(x.n_rows));
+        add(static_cast<uint64_t>(x.n_cols));
+        add_bytes(x.memptr(), x.n_elem * sizeof(double));
+        return;
+    }
+    void add(const std::string& x) {
+        add(static_cast<uint64_t>(x.size()));
+        add_bytes(x.data(), x.size());
+        return;
+    }
+
+    template< class T, class... Ts >
+    void add(const T& x, const Ts&... xs) {
+        add(x);
+        add(xs...);
+        return;
+    }
+};
+
+
+
+
+class CheckpointWriter
+{
+public:
+
+    /*
+     `tmp_suffix` should be unique when more than one process might write
+     the same file at once.
+     */
+    CheckpointWriter(const std::string& file_,
+                     const std::string& engine,
+                     const uint64_t& hash,
+                     const std::string& tmp_suffix = ".tmp")
+        : file(file_),
+          tmp_file(file_ + tmp_suffix),
+          out(tmp_file, std::ios::binary | std::ios::trunc) {
+        out.write(ckpt_magic, sizeof(ckpt_magic));
+        write(ckpt_version);
+        write(engine);
+        write(hash);
+    };
+    // Append to a file already written as above (no header or renaming):
+    explicit CheckpointWriter(const std::string& file_)
+        : file(file_),
+          tmp_file(),
+          out(file_, std::ios::binary | std::ios::app) {};
+
+    template< class T >
+    typename std::enable_if<std::is_arithmetic<T>::value>::type
+    write(const T& x) {
+        out.write(reinterpret_cast<const char*>(&x), sizeof(T));
+        return;
+    }
+    void write(const std::string& x) {
+        write(static_cast<uint64_t>(x.size()));
+        out.write(x.data(), x.size());
+        return;
+    }
+    template< class eT >
+    void write(const arma::Mat<eT>& x) {
+        write(static_cast<uint64_t>(x.n_rows));
+        write(static_cast<uint64_t>(x.n_cols));
+        out.write(reinterpret_cast<const char*>(x.memptr()),
+                  x.n_elem * sizeof(eT));
+        return;
+    }
+    template< class T >
+    void write(const std::vector<T>& x) {
+        write(static_cast<uint64_t>(x.size()));
+        for (const T& xi : x) write(xi);
+        return;
+    }
+    void write(const std::vector<bool>& x) {
+        write(static_cast<uint64_t>(x.size()));
+        for (size_t i = 0; i < x.size(); i++) write(static_cast<bool>(x[i]));
+        return;
+    }
+    // For objects with `operator<<` but no access to their internals (RNGs):
+    template< class T >
+    void write_streamable(const T& x) {
+        std::ostringstream ss;
+        ss << x;
+        write(ss.str());
+        return;
+    }
+
+    // Finish writing and move to final location; returns false if failed.
+    bool commit() {
+        out.close();
+        if (tmp_file.empty()) return ! out.fail();
+        if (out.fail()) {
+            std::remove(tmp_file.c_str());
+            return false;
+        }
+        if (! replace_file__()) {
+            std::remove(tmp_file.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::string file;
+    std::string tmp_file;
+    std::ofstream out;
+
+    bool replace_file__() const {
+        if (std::rename(tmp_file.c_str(), file.c_str()) == 0) return true;
+#ifdef _WIN32
+        /*
+         On Windows, `rename` fails if `file` already exists, so remove it
+         first (the old version is only lost if the second try fails too).
+         */
+        std::remove(file.c_str());
+        return std::rename(tmp_file.c_str(), file.c_str()) == 0;
+#else
+        return false;
+#endif
+    }
+};
+
+
+
+class CheckpointReader
+{
+public:
+
+    /*
+     `status` is "" if everything worked, otherwise a message about why
+     this checkpoint can't be used.
+     */
+    std::string status;
+
+    CheckpointReader(const std::string& file,
+                     const std::string& engine,
+                     const uint64_t& hash)
+        : status(),
+          in(file, std::ios::binary) {
+        if (! in.good()) {
+            status = "could not be opened";
+            return;
+        }
+        char magic[sizeof(ckpt_magic)];
+        in.read(magic, sizeof(ckpt_magic));
+        if (in.fail() || std::string(magic) != std::string(ckpt_magic)) {
+            status = "is not a checkpoint file";
+            return;
+        }
+        uint32_t version;
+        std::string engine_in;
+        uint64_t hash_in;
+        read(version);
+        read(engine_in);
+        read(hash_in);
+        if (in.fail()) {
+            status = "is incomplete";
+        } else if (version != ckpt_version) {
+            status = "was written by a different version of this package";
+        } else if (engine_in != engine) {
+            status = "was written by " + engine_in + ", not " + engine;
+        } else if (hash_in != hash) {
+            status = "was written using different inputs";
+        }
+    };
+
+    bool good() {
+        if (in.fail() && status.empty()) status = "is incomplete";
+        return status.empty();
+    }
+
+    template< class T >
+    typename std::enable_if<std::is_arithmetic<T>::value>::type
+    read(T& x) {
+        in.read(reinterpret_cast<char*>(&x), sizeof(T));
+        return;
+    }
+    void read(std::string& x) {
+        uint64_t n = 0;
+        read(n);
+        if (in.fail()) return;
+        x.resize(n);
+        in.read(&x[0], n);
+        return;
+    }
+    template< class eT >
+    void read(arma::Mat<eT>& x) {
+        uint64_t nr = 0, nc = 0;
+        read(nr);
+        read(nc);
+        if (in.fail()) return;
+        x.set_size(nr, nc);
+        in.read(reinterpret_cast<char*>(x.memptr()), x.n_elem * sizeof(eT));
+        return;
+    }
+    template< class eT >
+    void read(arma::Col<eT>& x) {
+        arma::Mat<eT> tmp;
+        read(tmp);
+        x = arma::conv_to<arma::Col<eT>>::from(tmp);
+        return;
+    }
+    template< class T >
+    void read(std::vector<T>& x) {
+        uint64_t n = 0;
+        read(n);
+        if (in.fail()) return;
+        x.resize(n);
+        for (T& xi : x) read(xi);
+        return;
+    }
+    void read(std::vector<bool>& x) {
+        uint64_t n = 0;
+        read(n);
+        if (in.fail()) return;
+        x.resize(n);
+        bool xi;
+        for (size_t i = 0; i < n; i++) {
+            read(xi);
+            x[i] = xi;
+        }
+        return;
+    }
+    template< class T >
+    void read_streamable(T& x) {
+        std::string s;
+        read(s);
+        std::istringstream ss(s);
+        ss >> x;
+        return;
+    }
+
+private:
+    std::ifstream in;
+};
+
+
+inline bool file_exists(const std::string& file) {
+    std::ifstream f(file);
+    return f.good();
+}
+
+
+
+/*
+ Trajectory observed so far, kept in its own file next to a checkpoint
+ (`<checkpoint file>.traj`, with the same header).
+ Each checkpoint only appends rows added since the last one, then records
+ how many rows it covers (`save`, before the observer's own `save`), so
+ rows written after the last checkpoint are ignored when resuming.
+ The file is rewritten in full once after resuming (dropping those rows)
+ and after any failed append.
+ Observers without trajectories (anything but `ObserverP`) don't use it.
+ */
+class TrajectoryLog
+{
+public:
+
+    TrajectoryLog(const std::string& checkpoint_file,
+                  const std::string& engine_,
+                  const uint64_t& hash_)
+        : file(checkpoint_file + ".traj"),
+          engine(engine_),
+          hash(hash_),
+          n_saved(0),
+          rewrite(true) {};
+
+    // Returns false if the rows couldn't be written:
+    template< class Obs >
+    bool append(const Obs& /* obs */) {
+        return true;
+    }
+    template< class L, class S >
+    bool append(const ObserverP<L, S>& obs) {
+        bool ok;
+        if (rewrite) {
+            CheckpointWriter writer(file, engine, hash);
+            obs.save_rows(writer, 0U);
+            ok = writer.commit();
+        } else {
+            CheckpointWriter writer(file);
+            obs.save_rows(writer, n_saved);
+            ok = writer.commit();
+        }
+        // (A failed append may leave part of a row, so start over next time)
+        rewrite = ! ok;
+        if (ok) n_saved = obs.n_final_rows();
+        return ok;
+    }
+
+    template< class W >
+    void save(W& w) const {
+        w.write(static_cast<uint64_t>(n_saved));
+        return;
+    }
+
+    // Returns "" if it worked, otherwise why the trajectory can't be used:
+    template< class R, class Obs >
+    std::string load(R& r, Obs& /* obs */) {
+        uint64_t n = 0;
+        r.read(n);
+        n_saved = n;
+        rewrite = true;
+        return "";
+    }
+    template< class R, class L, class S >
+    std::string load(R& r, ObserverP<L, S>& obs) {
+        uint64_t n = 0;
+        r.read(n);
+        if (! r.good()) return "";
+        CheckpointReader rows(file, engine, hash);
+        if (rows.good()) obs.load_rows(rows, n);
+        if (! rows.good()) return "Trajectory file " + file + " " + rows.status;
+        n_saved = n;
+        rewrite = true;
+        return "";
+    }
+
+private:
+    std::string file;
+    std::string engine;
+    uint64_t hash;
+    size_t n_saved;
+    bool rewrite;
+};
+
+
+/*
+ Check checkpoint arguments, and convert `checkpoint_every` (in time units)
+ to the number of steps between checkpoints.
+ */
+inline size_t checkpoint_arg_checks(bool& err,
+                                    const std::string& checkpoint_file,
+                                    const double& checkpoint_every,
+                                    const double& dt) {
+    min_val_check(err, checkpoint_every, "checkpoint_every", 0);
+    if (checkpoint_every <= 0) return 0;
+    if (checkpoint_file.empty()) {
+        Rcout << "checkpoint_file must be provided if checkpoint_every > 0!";
+        Rcout << std::endl;
+        err = true;
+        return 0;
+    }
+    double n_steps = std::round(checkpoint_every / dt);
+    if (n_steps < 1 || std::abs(n_steps * dt - checkpoint_every) > 1e-10) {
+        Rcout << "checkpoint_every is " << std::to_string(checkpoint_every);
+        Rcout << " but should be divisible by dt (";
+        Rcout << std::to_string(dt) << ")!" << std::endl;
+        err = true;
+        return 0;
+    }
+    return static_cast<size_t>(n_steps);
+}
+
+
+
+/*
+ dopri5 where the first-same-as-last derivative is kept outside the stepper
+ so that it can be written to and read from checkpoints.
+ (The internal derivative can be different from a fresh evaluation at the
+ same state when systems change inside their RHS, such as `YB_added`.)
+ */
+struct CheckpointStepper
+{
+    MatStepperType stepper;
+    MatType dxdt;
+    bool dxdt_init;
+
+    CheckpointStepper() : stepper(), dxdt(), dxdt_init(false) {};
+
+    template< class System >
+    void do_step(System system, MatType& x, const double& t, const double& dt) {
+        if (! dxdt_init) {
+            typename boost::numeric::odeint::unwrap_reference<System>::type& sys(system);
+            dxdt.set_size(x.n_rows, x.n_cols);
+            sys(x, dxdt, t);
+            dxdt_init = true;
+        }
+        stepper.do_step(system, x, dxdt, t, dt);
+        return;
+    }
+
+    template< class W >
+    void save(W& w) const {
+        w.write(dxdt);
+        w.write(dxdt_init);
+        return;
+    }
+    template< class R >
+    void load(R& r) {
+        r.read(dxdt);
+        r.read(dxdt_init);
+        return;
+    }
+};
+
+
+
+/*
+ Same as boost's `integrate_const` for steppers with `stepper_tag` (including
+ how times are calculated), but starting at step `step` and calling
+ `save(step)` after every `every` steps (never if `every` is zero).
+ Starting at `step = 0` gives the same results as `integrate_const`.
+ It also stops early (returning false) if `ticker.tick()` returns false,
+ after saving where it stopped when checkpoints are being used.
+ */
+template< class Stepper, class System, class Obs, class Save, class Ticker >
+inline bool integrate_const_from(Stepper& stepper,
+                                 System system,
+                                 MatType& x,
+                                 size_t& step,
+                                 const double& dt,
+                                 const double& max_t,
+                                 Obs& obs,
+                                 const size_t& every,
+                                 Save save,
+                                 Ticker& ticker) {
+    double time = 0.0 + static_cast<double>(step) * dt;
+    while ((time + dt) - max_t <= std::numeric_limits<double>::epsilon()) {
+        obs(x, time);
+        stepper.do_step(system, x, time, dt);
+        ++step;
+        time = 0.0 + static_cast<double>(step) * dt;
+        if (every > 0 && step % every == 0) save(step);
+        if (! ticker.tick()) {
+            if (every > 0 && step % every != 0) save(step);
+            return false;
+        }
+    }
+    obs(x, time);
+    return true;
+}
+
+
+
+/*
+ Integrate a deterministic system using dopri5, optionally resuming from
+ and writing to a checkpoint file.
+ `system` and `obs` both need `save` and `load` methods.
+ Returns false (after printing why) if an existing checkpoint can't be used
+ or if the user interrupted.
+ */
+template< class Sys, class Obs >
+inline bool integrate_checkpoint(Sys& system,
+                                 MatType& x,
+                                 const double& dt,
+                                 const double& max_t,
+                                 Obs& obs,
+                                 const std::string& checkpoint_file,
+                                 const size_t& checkpoint_steps,
+                                 const bool& resume,
+                                 const std::string& engine,
+                                 const uint64_t& hash,
+                                 const bool& show_progress) {
+
+    CheckpointStepper stepper;
+    size_t step = 0;
+    TrajectoryLog log(checkpoint_file, engine, hash);
+
+    if (resume && file_exists(checkpoint_file)) {
+        CheckpointReader reader(checkpoint_file, engine, hash);
+        std::string log_status;
+        if (reader.good()) {
+            uint64_t step_in;
+            reader.read(step_in);
+            step = step_in;
+            reader.read(x);
+            stepper.load(reader);
+            system.load(reader);
+            log_status = log.load(reader, obs);
+            obs.load(reader);
+        }
+        if (! reader.good()) {
+            Rcout << "Checkpoint file " << checkpoint_file << " ";
+            Rcout << reader.status << "!" << std::endl;
+            return false;
+        }
+        if (! log_status.empty()) {
+            Rcout << log_status << "!" << std::endl;
+            return false;
+        }
+    }
+
+    auto save = [&](const size_t& step_) {
+        // The checkpoint can only cover rows that were written:
+        if (! log.append(obs)) {
+            Rcout << "Warning: checkpoint file " << checkpoint_file;
+            Rcout << " could not be written." << std::endl;
+            return;
+        }
+        CheckpointWriter writer(checkpoint_file, engine, hash);
+        writer.write(static_cast<uint64_t>(step_));
+        writer.write(x);
+        stepper.save(writer);
+        system.save(writer);
+        log.save(writer);
+        obs.save(writer);
+        if (! writer.commit()) {
+            Rcout << "Warning: checkpoint file " << checkpoint_file;
+            Rcout << " could not be written." << std::endl;
+        }
+    };
+
+    Progress progress(1U, n_const_steps(dt, max_t), show_progress);
+    progress.add_steps(step);
+    {
+        ProgressTicker ticker(progress, true);
+        integrate_const_from(stepper, std::ref(system), x, step, dt, max_t,
+                             obs, checkpoint_steps, save, ticker);
+    }
+    progress.add_rep();
+
+    return progress.finish();
+}
+
+// Same as above, without checkpoints:
+template< class Sys, class Obs >
+inline bool integrate_interruptible(Sys& system,
+                                    MatType& x,
+                                    const double& dt,
+                                    const double& max_t,
+                                    Obs& obs,
+                                    const bool& show_progress) {
+    return integrate_checkpoint(system, x, dt, max_t, obs, "", 0U, false, "",
+                                0U, show_progress);
+}
+
+
+
+#endif
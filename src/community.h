@@ -0,0 +1,54 @@
+# ifndef __SWEETSOURSONG_COMMUNITY_H
+# define __SWEETSOURSONG_COMMUNITY_H
+
+
+/*
+ Community metrics on plain arrays, so they can be used inside worker
+ threads (where R objects can't be made). The exported versions in
+ util.cpp call these.
+ */
+
+#include <cstddef>
+#include <cmath>
+
+
+// Mean Bray–Curtis dissimilarity over all pairs of the `n` plants:
+inline double bray_curtis_mean(const double* yeast,
+                               const double* bact,
+                               const size_t& n) {
+    double bc_sum = 0, min_y, min_b, denom;
+    for (size_t i = 0; i + 1U < n; i++) {
+        for (size_t j = i+1U; j < n; j++) {
+            min_y = (yeast[i] < yeast[j]) ? yeast[i] : yeast[j];
+            min_b = (bact[i] < bact[j]) ? bact[i] : bact[j];
+            denom = yeast[i] + yeast[j] + bact[i] + bact[j];
+            bc_sum += 1 - (2 * (min_y + min_b)) / denom;
+        }
+    }
+    double n_combos = static_cast<double>(n) * (static_cast<double>(n) - 1) / 2;
+    return bc_sum / n_combos;
+}
+
+
+// Mean Shannon diversity across the `n` plants:
+inline double shannon_mean(const double* yeast,
+                           const double* bact,
+                           const size_t& n,
+                           const double& zero_threshold = 2.220446e-16) {
+    // Do calculation while accounting for zeros:
+    double p_yeast, p_bact, total, H_i, H_mean = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (bact[i] > zero_threshold && yeast[i] > zero_threshold) {
+            total = yeast[i] + bact[i];
+            p_yeast = yeast[i] / total;
+            p_bact = bact[i] / total;
+            H_i = - p_yeast * std::log(p_yeast) - p_bact * std::log(p_bact);
+            H_mean += H_i;
+        }
+    }
+    H_mean /= static_cast<double>(n);
+    return H_mean;
+}
+
+
+#endif
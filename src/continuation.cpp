@@ -0,0 +1,944 @@
+
+/*
+ Continuation of equilibria and bifurcations for the one-plant and
+ constant-F landscape models (see continuation.h).
+ One-parameter runs trace a branch of equilibria as one parameter varies,
+ marking folds and branch points (e.g., transcritical points where yeast
+ or bacteria invade), along with each equilibrium's stability.
+ Two-parameter runs find the first fold or branch point as the first
+ parameter varies, then trace the curve of those points as both vary.
+ Branches stop when they leave the parameter range(s) or when the state
+ is no longer biologically possible.
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "ode.h"
+#include "one_plant.h"
+#include "landscape_constantF.h"
+#include "continuation.h"
+#include "progress.h"
+
+using namespace Rcpp;
+
+
+
+
+// Equilibria of `OnePlantSystemFunction`, with state c(Y, B, N):
+class OnePlantEquilibria
+{
+public:
+
+    size_t n_x;
+    std::vector<std::string> par_names;
+    std::vector<double> pars;
+
+    OnePlantEquilibria(const std::vector<double>& pars_)
+        : n_x(3U),
+          par_names({"m", "R", "d_yp", "d_b0", "d_bp", "g_yp", "g_b0",
+                    "g_bp", "L_0", "P_max", "q", "s_0", "h", "f_0",
+                    "F_tilde", "u"}),
+          pars(pars_),
+          system(make_system__()),
+          x_(),
+          dxdt_() {};
+
+    void operator()(const arma::vec& x, arma::vec& dxdt) {
+        // Rounding can leave densities at boundary equilibria just below zero,
+        // where e.g. `pow(B / F, h)` isn't defined:
+        for (size_t i = 0; i < n_x; i++) x_[i] = std::max(x(i), 0.0);
+        system(x_, dxdt_, 0);
+        dxdt.set_size(n_x);
+        for (size_t i = 0; i < n_x; i++) dxdt(i) = dxdt_[i];
+        return;
+    }
+
+    void set(const size_t& i, const double& value) {
+        if (pars[i] == value) return;
+        pars[i] = value;
+        system = make_system__();
+        return;
+    }
+
+    bool feasible(const arma::vec& x) const {
+        return x.min() >= -feasible_tol;
+    }
+
+    // Pollinator visits at state `x`:
+    double P(const arma::vec& x) const {
+        const OnePlantSystemFunction& s(system);
+        double F = x(0) + x(1) + x(2);
+        double FF_u = std::pow(F / (F + s.F_tilde), s.u);
+        double phi = FF_u / (s.f_0_u + FF_u);
+        double psi = s.s_0_h / (s.s_0_h + std::pow(x(1) / F, s.h));
+        return s.P_max * (s.q * psi + (1-s.q) * phi);
+    }
+
+    // Run to (near) an equilibrium from `x`:
+    void settle(arma::vec& x, const double& settle_t) {
+        if (settle_t <= 0) return;
+        ArrType<3> xx;
+        for (size_t i = 0; i < n_x; i++) xx[i] = x(i);
+        boost::numeric::odeint::integrate_const(
+            ArrStepperType<3>(), std::ref(system), xx, 0.0, settle_t, 0.1);
+        for (size_t i = 0; i < n_x; i++) x(i) = xx[i];
+        return;
+    }
+
+private:
+
+    OnePlantSystemFunction system;
+    ArrType<3> x_;
+    ArrType<3> dxdt_;
+    const double feasible_tol = 1e-8;
+
+    OnePlantSystemFunction make_system__() const {
+        return OnePlantSystemFunction(pars[0], pars[1], pars[2], pars[3],
+                                      pars[4], pars[5], pars[6], pars[7],
+                                      pars[8], pars[9], pars[10], pars[11],
+                                      pars[12], pars[13], pars[14], pars[15]);
+    }
+};
+
+
+
+
+/*
+ Equilibria of `LandscapeConstF`, with state c(Y, B) (i.e., the state
+ matrix by column).
+ Setting a per-plant parameter sets it to the same value at all plants.
+ */
+class ConstFEquilibria
+{
+public:
+
+    size_t n_plants;
+    size_t n_x;
+    std::vector<std::string> par_names;
+
+    ConstFEquilibria(const std::vector<std::vector<double>>& plant_pars_,
+                     const double& u_,
+                     const double& X_)
+        : n_plants(plant_pars_.front().size()),
+          n_x(2U * plant_pars_.front().size()),
+          par_names({"m", "d_yp", "d_b0", "d_bp", "g_yp", "g_b0", "g_bp",
+                    "L_0", "u", "X"}),
+          plant_pars(plant_pars_),
+          u(u_),
+          X(X_),
+          values(par_names.size(), arma::datum::nan),
+          system(make_system__()),
+          x_(n_plants, 2U),
+          dxdt_(n_plants, 2U) {};
+
+    void operator()(const arma::vec& x, arma::vec& dxdt) {
+        // Same as for `OnePlantEquilibria`:
+        for (size_t i = 0; i < n_plants; i++) {
+            x_(i,0) = std::max(x(i), 0.0);
+            x_(i,1) = std::max(x(n_plants + i), 0.0);
+        }
+        system(x_, dxdt_);
+        dxdt.set_size(n_x);
+        for (size_t i = 0; i < n_plants; i++) {
+            dxdt(i) = dxdt_(i,0);
+            dxdt(n_plants + i) = dxdt_(i,1);
+        }
+        return;
+    }
+
+    void set(const size_t& i, const double& value) {
+        if (values[i] == value) return;
+        values[i] = value;
+        if (i < plant_pars.size()) {
+            std::fill(plant_pars[i].begin(), plant_pars[i].end(), value);
+        } else if (i == plant_pars.size()) {
+            u = value;
+        } else X = value;
+        system = make_system__();
+        return;
+    }
+
+    bool feasible(const arma::vec& x) const {
+        for (size_t i = 0; i < n_plants; i++) {
+            const double& Y(x(i));
+            const double& B(x(n_plants + i));
+            if (Y < -feasible_tol || B < -feasible_tol ||
+                (Y + B) > (1 + feasible_tol)) return false;
+        }
+        return true;
+    }
+
+    // Pollinator visits for each plant at state `x`:
+    void P(const arma::vec& x, arma::vec& P_out) {
+        to_mat__(x, x_);
+        system.make_P(P_out, x_);
+        return;
+    }
+
+    // Run to (near) an equilibrium from `x`:
+    void settle(arma::vec& x, const double& settle_t) {
+        if (settle_t <= 0) return;
+        MatType xm(n_plants, 2U);
+        to_mat__(x, xm);
+        boost::numeric::odeint::integrate_const(
+            MatStepperType(), std::ref(system), xm, 0.0, settle_t, 0.1);
+        for (size_t i = 0; i < n_plants; i++) {
+            x(i) = xm(i,0);
+            x(n_plants + i) = xm(i,1);
+        }
+        return;
+    }
+
+private:
+
+    std::vector<std::vector<double>> plant_pars;
+    double u;
+    double X;
+    std::vector<double> values;  // last values set (NaN if never set)
+    LandscapeConstF system;
+    MatType x_;
+    MatType dxdt_;
+    const double feasible_tol = 1e-8;
+
+    LandscapeConstF make_system__() const {
+        return LandscapeConstF(plant_pars[0], plant_pars[1], plant_pars[2],
+                               plant_pars[3], plant_pars[4], plant_pars[5],
+                               plant_pars[6], plant_pars[7], u, X);
+    }
+
+    void to_mat__(const arma::vec& x, MatType& xm) const {
+        for (size_t i = 0; i < n_plants; i++) {
+            xm(i,0) = x(i);
+            xm(i,1) = x(n_plants + i);
+        }
+        return;
+    }
+};
+
+
+
+
+struct CurvePoint {
+    arma::vec z;
+    int type;  // see `ContinuationPoint`
+};
+
+
+
+/*
+ Trace a curve from `z0` in one direction (see `ArclengthContinuation::start`
+ for `k` and `direction`), appending points to `points`.
+ `bounds` contains (index, lower, upper) for parameters in `z` that are
+ limited. If `detect` is true, folds in `z(k)` and branch points are
+ located and added, and if `stop_at_special` is also true, it stops after
+ the first one. `after_step` is called after each successful step.
+ Returns false if interrupted.
+ */
+template< class H, class M, class F >
+inline bool trace_curve(H& h,
+                        M& model,
+                        const arma::vec& z0,
+                        const size_t& k,
+                        const double& direction,
+                        const std::vector<std::vector<double>>& bounds,
+                        const double& ds,
+                        const double& ds_max,
+                        const uint32_t& max_steps,
+                        const bool& detect,
+                        const bool& stop_at_special,
+                        F after_step,
+                        std::vector<CurvePoint>& points) {
+
+    auto inside = [&](const arma::vec& z) {
+        for (const std::vector<double>& b : bounds) {
+            const double& zi(z(static_cast<size_t>(b[0])));
+            if (zi < b[1] || zi > b[2]) return false;
+        }
+        arma::vec x(model.n_x);
+        for (size_t i = 0; i < model.n_x; i++) x(i) = z(i);
+        return model.feasible(x);
+    };
+
+    ArclengthContinuation<H> cont(h, ds, ds * 1e-6, ds_max);
+    if (! cont.start(z0, k, direction)) {
+        Rcout << "Could not start the curve in the ";
+        Rcout << (direction > 0 ? "increasing" : "decreasing");
+        Rcout << " direction (the starting point didn't converge)." << std::endl;
+        return true;
+    }
+    after_step(cont.z);
+
+    for (uint32_t i = 0; i < max_steps; i++) {
+        if (user_interrupt()) {
+            Rcout << "Interrupted by user." << std::endl;
+            return false;
+        }
+        if (! cont.step()) break;
+        after_step(cont.z);
+        if (detect) {
+            int type = cont_regular;
+            arma::vec z_special;
+            if (cont.fold_crossed(k)) {
+                type = cont_fold;
+                z_special = cont.locate([&k](const arma::vec& /* z_ */,
+                                             const arma::vec& t_,
+                                             const double& /* d_ */) {
+                    return t_(k);
+                });
+            } else if (cont.branch_crossed()) {
+                type = cont_branch;
+                z_special = cont.locate([](const arma::vec& /* z_ */,
+                                           const arma::vec& /* t_ */,
+                                           const double& d_) {
+                    return d_;
+                });
+            }
+            if (type != cont_regular) {
+                bool in_bounds = true;
+                for (const std::vector<double>& b : bounds) {
+                    const double& zi(z_special(static_cast<size_t>(b[0])));
+                    in_bounds = in_bounds && zi >= b[1] && zi <= b[2];
+                }
+                if (in_bounds) {
+                    points.push_back(CurvePoint{z_special, type});
+                    if (stop_at_special) return true;
+                }
+            }
+        }
+        if (! inside(cont.z)) break;
+        points.push_back(CurvePoint{cont.z, cont_regular});
+    }
+
+    return true;
+}
+
+
+
+/*
+ Starting point for a one-parameter run: settle from `x0` then polish
+ with Newton's method.
+ */
+template< class M >
+inline bool start_equilibrium(M& model,
+                              const size_t& par,
+                              const double& par_value,
+                              const arma::vec& x0,
+                              const double& settle_t,
+                              arma::vec& z0) {
+    model.set(par, par_value);
+    arma::vec x(x0);
+    model.settle(x, settle_t);
+    if (! polish_equilibrium(model, x) || ! model.feasible(x)) {
+        Rcout << "Could not find a starting equilibrium (try increasing ";
+        Rcout << "settle_t or changing starting values)!" << std::endl;
+        return false;
+    }
+    z0.set_size(model.n_x + 1U);
+    for (size_t i = 0; i < model.n_x; i++) z0(i) = x(i);
+    z0(model.n_x) = par_value;
+    return true;
+}
+
+
+/*
+ Branch of equilibria through `z0` in both directions, ordered along the
+ branch. Returns false if interrupted.
+ */
+template< class M >
+inline bool equilibrium_branch(M& model,
+                               const size_t& par,
+                               const arma::vec& z0,
+                               const double& par_min,
+                               const double& par_max,
+                               const double& ds,
+                               const double& ds_max,
+                               const uint32_t& max_steps,
+                               std::vector<CurvePoint>& points) {
+
+    EquilibriumCurve<M> h(model, par);
+    size_t k = model.n_x;
+    std::vector<std::vector<double>> bounds(1U, {static_cast<double>(k),
+                                                 par_min, par_max});
+    auto no_op = [](const arma::vec& /* z_ */) {};
+
+    std::vector<CurvePoint> backward;
+    if (! trace_curve(h, model, z0, k, -1, bounds, ds, ds_max, max_steps,
+                      true, false, no_op, backward)) return false;
+    std::vector<CurvePoint> forward(1U, CurvePoint{z0, cont_regular});
+    if (! trace_curve(h, model, z0, k, 1, bounds, ds, ds_max, max_steps,
+                      true, false, no_op, forward)) return false;
+
+    points.assign(backward.rbegin(), backward.rend());
+    points.insert(points.end(), forward.begin(), forward.end());
+    return true;
+}
+
+
+/*
+ Trace a curve of folds or branch points (`h` is a `SingularCurve` or
+ `InvasionCurve`) in both directions from `z_start`.
+ */
+template< class H, class M >
+inline bool singular_both_ways(H& h,
+                               M& model,
+                               const arma::vec& z_start,
+                               const int& start_type,
+                               const std::vector<std::vector<double>>& bounds,
+                               const double& ds,
+                               const double& ds_max,
+                               const uint32_t& max_steps,
+                               std::vector<CurvePoint>& points) {
+
+    size_t nx = model.n_x;
+    if (! h.update_borders(z_start)) return false;
+    auto update = [&h](const arma::vec& z_) { h.update_borders(z_); };
+
+    std::vector<CurvePoint> backward;
+    if (! trace_curve(h, model, z_start, nx + 1U, -1, bounds, ds, ds_max,
+                      max_steps, false, false, update, backward)) {
+        return false;
+    }
+    // Borders are reset for the other direction:
+    h.b.reset();
+    if (! h.update_borders(z_start)) return false;
+    std::vector<CurvePoint> forward(1U, CurvePoint{z_start, start_type});
+    if (! trace_curve(h, model, z_start, nx + 1U, 1, bounds, ds, ds_max,
+                      max_steps, false, false, update, forward)) {
+        return false;
+    }
+
+    points.assign(backward.rbegin(), backward.rend());
+    points.insert(points.end(), forward.begin(), forward.end());
+    return true;
+}
+
+
+/*
+ Curve of folds or branch points in parameters `par1` and `par2`, starting
+ at the first one found along the branch of equilibria through `z0` as
+ `par1` varies (looking first in the increasing direction).
+ Returns false if interrupted or if none are found.
+ */
+template< class M >
+inline bool bifurcation_curve(M& model,
+                              const size_t& par1,
+                              const size_t& par2,
+                              const double& par2_value,
+                              const arma::vec& z0,
+                              const double& par1_min,
+                              const double& par1_max,
+                              const double& par2_min,
+                              const double& par2_max,
+                              const double& ds,
+                              const double& ds_max,
+                              const uint32_t& max_steps,
+                              std::vector<CurvePoint>& points) {
+
+    size_t nx = model.n_x;
+    std::vector<CurvePoint> found;
+    {
+        EquilibriumCurve<M> h(model, par1);
+        std::vector<std::vector<double>> bounds(1U, {static_cast<double>(nx),
+                                                     par1_min, par1_max});
+        auto no_op = [](const arma::vec& /* z_ */) {};
+        for (double direction : {1.0, -1.0}) {
+            std::vector<CurvePoint> branch;
+            if (! trace_curve(h, model, z0, nx, direction, bounds, ds, ds_max,
+                              max_steps, true, true, no_op, branch)) {
+                return false;
+            }
+            if (! branch.empty() && branch.back().type != cont_regular) {
+                found.push_back(branch.back());
+                break;
+            }
+        }
+    }
+    if (found.empty()) {
+        Rcout << "No folds or branch points found in the range of the ";
+        Rcout << "first parameter!" << std::endl;
+        return false;
+    }
+
+    arma::vec z_start(nx + 2U);
+    for (size_t i = 0; i <= nx; i++) z_start(i) = found.front().z(i);
+    z_start(nx + 1U) = par2_value;
+    std::vector<std::vector<double>> bounds = {
+        {static_cast<double>(nx), par1_min, par1_max},
+        {static_cast<double>(nx + 1U), par2_min, par2_max}};
+
+    /*
+     Branch points where some variables are zero are where those variables
+     can just invade, and these need their own equations:
+     */
+    std::vector<size_t> zero;
+    if (found.front().type == cont_branch) {
+        for (size_t i = 0; i < nx; i++) {
+            if (std::abs(z_start(i)) <= 1e-8) zero.push_back(i);
+        }
+    }
+    if (! zero.empty()) {
+        for (const size_t& i : zero) z_start(i) = 0;
+        InvasionCurve<M> h(model, par1, par2, zero);
+        return singular_both_ways(h, model, z_start, found.front().type,
+                                  bounds, ds, ds_max, max_steps, points);
+    }
+    SingularCurve<M> h(model, par1, par2);
+    return singular_both_ways(h, model, z_start, found.front().type,
+                              bounds, ds, ds_max, max_steps, points);
+}
+
+
+
+// Index of `par` in `names`, or an error if it isn't there:
+inline size_t par_index(const std::string& par,
+                        const std::vector<std::string>& names,
+                        const std::string& arg_name,
+                        bool& err) {
+    auto it = std::find(names.begin(), names.end(), par);
+    if (it == names.end()) {
+        Rcout << arg_name << " should be one of ";
+        for (size_t i = 0; i < names.size(); i++) {
+            Rcout << (i > 0 ? ", " : "") << names[i];
+        }
+        Rcout << "!" << std::endl;
+        err = true;
+        return 0;
+    }
+    return static_cast<size_t>(it - names.begin());
+}
+
+inline void continuation_arg_checks(bool& err,
+                                    const double& settle_t,
+                                    const double& ds,
+                                    const double& ds_max) {
+    min_val_check(err, settle_t, "settle_t", 0);
+    min_val_check(err, ds, "ds", 0, false);
+    min_val_check(err, ds_max, "ds_max", ds);
+    return;
+}
+inline void par_range_check(bool& err,
+                            const std::string& par,
+                            const double& par_value,
+                            const double& par_min,
+                            const double& par_max) {
+    if (par_value < par_min || par_value > par_max) {
+        Rcout << "The starting value of " << par << " (" << par_value;
+        Rcout << ") should be between its minimum and maximum!" << std::endl;
+        err = true;
+    }
+    return;
+}
+
+
+
+
+// Column names for the parameters in the output:
+inline CharacterVector curve_colnames(const std::vector<std::string>& pars,
+                                      const std::vector<std::string>& others) {
+    CharacterVector cn = CharacterVector::create("point");
+    for (const std::string& p : pars) cn.push_back(p);
+    for (const std::string& o : others) cn.push_back(o);
+    return cn;
+}
+
+
+/*
+ Output for the one-plant model, with columns for the point number,
+ parameter(s), Y, B, N, P, and the type of point (0 = regular, 1 = fold,
+ 2 = branch point).
+ For one-parameter runs, there are also columns for the largest real part
+ of the Jacobian's eigenvalues and whether the equilibrium is stable
+ (NA if the eigenvalues couldn't be found).
+ */
+inline NumericMatrix one_plant_curve_output(OnePlantEquilibria& model,
+                                            const std::vector<size_t>& pars,
+                                            const std::vector<CurvePoint>& points) {
+    size_t nx = model.n_x;
+    size_t np = pars.size();
+    bool stability = np == 1U;
+    std::vector<std::string> par_names;
+    for (const size_t& p : pars) par_names.push_back(model.par_names[p]);
+    std::vector<std::string> others = {"Y", "B", "N", "P"};
+    if (stability) {
+        others.push_back("max_re");
+        others.push_back("stable");
+    }
+    others.push_back("type");
+
+    NumericMatrix output(points.size(), 1U + np + others.size());
+    colnames(output) = curve_colnames(par_names, others);
+    arma::vec x(nx);
+    for (size_t i = 0; i < points.size(); i++) {
+        const arma::vec& z(points[i].z);
+        for (size_t j = 0; j < np; j++) model.set(pars[j], z(nx + j));
+        // Densities just below zero are zero in the model:
+        for (size_t j = 0; j < nx; j++) x(j) = std::max(z(j), 0.0);
+        size_t c = 0;
+        output(i,c++) = i + 1;
+        for (size_t j = 0; j < np; j++) output(i,c++) = z(nx + j);
+        for (size_t j = 0; j < nx; j++) output(i,c++) = x(j);
+        output(i,c++) = model.P(x);
+        if (stability) {
+            double mr = max_real_eigen(model, pars.front(), z);
+            output(i,c++) = mr;
+            output(i,c++) = std::isnan(mr) ? NA_REAL : (mr < 0 ? 1 : 0);
+        }
+        output(i,c++) = points[i].type;
+    }
+    return output;
+}
+
+/*
+ Same as above, but for the constant-F landscape, with one row per point
+ and plant, and a column for plant number instead of N.
+ */
+inline NumericMatrix constF_curve_output(ConstFEquilibria& model,
+                                         const std::vector<size_t>& pars,
+                                         const std::vector<CurvePoint>& points) {
+    size_t nx = model.n_x;
+    size_t n_plants = model.n_plants;
+    size_t np = pars.size();
+    bool stability = np == 1U;
+    std::vector<std::string> par_names;
+    for (const size_t& p : pars) par_names.push_back(model.par_names[p]);
+    std::vector<std::string> others = {"p", "Y", "B", "P"};
+    if (stability) {
+        others.push_back("max_re");
+        others.push_back("stable");
+    }
+    others.push_back("type");
+
+    NumericMatrix output(points.size() * n_plants, 1U + np + others.size());
+    colnames(output) = curve_colnames(par_names, others);
+    arma::vec x(nx), P;
+    size_t r = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        const arma::vec& z(points[i].z);
+        for (size_t j = 0; j < np; j++) model.set(pars[j], z(nx + j));
+        // Densities just below zero are zero in the model:
+        for (size_t j = 0; j < nx; j++) x(j) = std::max(z(j), 0.0);
+        model.P(x, P);
+        double mr = stability ? max_real_eigen(model, pars.front(), z) : 0;
+        for (size_t k = 0; k < n_plants; k++, r++) {
+            size_t c = 0;
+            output(r,c++) = i + 1;
+            for (size_t j = 0; j < np; j++) output(r,c++) = z(nx + j);
+            output(r,c++) = k;
+            output(r,c++) = x(k);
+            output(r,c++) = x(n_plants + k);
+            output(r,c++) = P(k);
+            if (stability) {
+                output(r,c++) = mr;
+                output(r,c++) = std::isnan(mr) ? NA_REAL : (mr < 0 ? 1 : 0);
+            }
+            output(r,c++) = points[i].type;
+        }
+    }
+    return output;
+}
+
+
+
+
+/*
+ Trace equilibria of `one_plant_ode` as parameter `par` (e.g., "P_max")
+ varies between `par_min` and `par_max`, starting from the equilibrium
+ reached after running for `settle_t` days from `Y0`, `B0`, and `N0`
+ at the given parameter values.
+ `ds` and `ds_max` are the starting and maximum step sizes along the
+ branch, and `max_steps` is the maximum steps in each direction.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix one_plant_continuation(const double& m,
+                                     const double& R,
+                                     const double& d_yp,
+                                     const double& d_b0,
+                                     const double& d_bp,
+                                     const double& g_yp,
+                                     const double& g_b0,
+                                     const double& g_bp,
+                                     const double& L_0,
+                                     const double& P_max,
+                                     const double& q,
+                                     const double& s_0,
+                                     const double& h,
+                                     const double& f_0,
+                                     const double& F_tilde,
+                                     const double& u,
+                                     const std::string& par,
+                                     const double& par_min,
+                                     const double& par_max,
+                                     const double& Y0 = 1.0,
+                                     const double& B0 = 1.0,
+                                     const double& N0 = 1.0,
+                                     const double& settle_t = 1000.0,
+                                     const double& ds = 0.01,
+                                     const double& ds_max = 0.1,
+                                     const uint32_t& max_steps = 10000) {
+
+    OnePlantEquilibria model({m, R, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                             L_0, P_max, q, s_0, h, f_0, F_tilde, u});
+
+    /*
+     I can't just use 'stop()' because it causes a segfault (or similar).
+     The system below is my workaround.
+     */
+    bool err = false;
+    size_t k = par_index(par, model.par_names, "par", err);
+    if (err) return NumericMatrix(0,0);
+    continuation_arg_checks(err, settle_t, ds, ds_max);
+    par_range_check(err, par, model.pars[k], par_min, par_max);
+    if (err) return NumericMatrix(0,0);
+
+    arma::vec z0;
+    if (! start_equilibrium(model, k, model.pars[k], {Y0, B0, N0}, settle_t,
+                            z0)) return NumericMatrix(0,0);
+
+    std::vector<CurvePoint> points;
+    if (! equilibrium_branch(model, k, z0, par_min, par_max, ds, ds_max,
+                             max_steps, points)) return NumericMatrix(0,0);
+
+    return one_plant_curve_output(model, {k}, points);
+}
+
+
+/*
+ Trace the curve of folds or branch points for `one_plant_ode` in
+ parameters `par` and `par2`, starting from the first one found as `par`
+ varies (see `one_plant_continuation`).
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix one_plant_bifurcation_curve(const double& m,
+                                          const double& R,
+                                          const double& d_yp,
+                                          const double& d_b0,
+                                          const double& d_bp,
+                                          const double& g_yp,
+                                          const double& g_b0,
+                                          const double& g_bp,
+                                          const double& L_0,
+                                          const double& P_max,
+                                          const double& q,
+                                          const double& s_0,
+                                          const double& h,
+                                          const double& f_0,
+                                          const double& F_tilde,
+                                          const double& u,
+                                          const std::string& par,
+                                          const double& par_min,
+                                          const double& par_max,
+                                          const std::string& par2,
+                                          const double& par2_min,
+                                          const double& par2_max,
+                                          const double& Y0 = 1.0,
+                                          const double& B0 = 1.0,
+                                          const double& N0 = 1.0,
+                                          const double& settle_t = 1000.0,
+                                          const double& ds = 0.01,
+                                          const double& ds_max = 0.1,
+                                          const uint32_t& max_steps = 10000) {
+
+    OnePlantEquilibria model({m, R, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                             L_0, P_max, q, s_0, h, f_0, F_tilde, u});
+
+    bool err = false;
+    size_t k = par_index(par, model.par_names, "par", err);
+    size_t k2 = par_index(par2, model.par_names, "par2", err);
+    if (err) return NumericMatrix(0,0);
+    if (k == k2) {
+        Rcout << "par and par2 should be different!" << std::endl;
+        return NumericMatrix(0,0);
+    }
+    continuation_arg_checks(err, settle_t, ds, ds_max);
+    par_range_check(err, par, model.pars[k], par_min, par_max);
+    par_range_check(err, par2, model.pars[k2], par2_min, par2_max);
+    if (err) return NumericMatrix(0,0);
+
+    arma::vec z0;
+    if (! start_equilibrium(model, k, model.pars[k], {Y0, B0, N0}, settle_t,
+                            z0)) return NumericMatrix(0,0);
+
+    std::vector<CurvePoint> points;
+    if (! bifurcation_curve(model, k, k2, model.pars[k2], z0, par_min,
+                            par_max, par2_min, par2_max, ds, ds_max,
+                            max_steps, points)) return NumericMatrix(0,0);
+
+    return one_plant_curve_output(model, {k, k2}, points);
+}
+
+
+
+
+// Shared by both constant-F functions below:
+inline bool constF_continuation_setup(const std::vector<double>& m,
+                                      const std::vector<double>& d_yp,
+                                      const std::vector<double>& d_b0,
+                                      const std::vector<double>& d_bp,
+                                      const std::vector<double>& g_yp,
+                                      const std::vector<double>& g_b0,
+                                      const std::vector<double>& g_bp,
+                                      const std::vector<double>& L_0,
+                                      const double& u,
+                                      const double& X,
+                                      const std::vector<double>& Y0,
+                                      const std::vector<double>& B0,
+                                      const double& settle_t,
+                                      arma::vec& x0) {
+    bool err = lanscape_constF_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0,
+                                          g_bp, L_0, u, X, Y0, B0, 0.1,
+                                          std::max(settle_t, 1.0));
+    if (err) return false;
+    size_t np = m.size();
+    x0.set_size(2U * np);
+    for (size_t i = 0; i < np; i++) {
+        x0(i) = Y0[i];
+        x0(np + i) = B0[i];
+    }
+    return true;
+}
+
+// Value of parameter `k` (per-plant ones should be the same at all plants):
+inline double constF_par_value(const std::vector<std::vector<double>>& plant_pars,
+                               const double& u,
+                               const double& X,
+                               const size_t& k,
+                               const std::string& par,
+                               bool& err) {
+    if (k == plant_pars.size()) return u;
+    if (k > plant_pars.size()) return X;
+    const std::vector<double>& v(plant_pars[k]);
+    if (*std::min_element(v.begin(), v.end()) !=
+        *std::max_element(v.begin(), v.end())) {
+        Rcout << par << " should be the same for all plants to vary it!";
+        Rcout << std::endl;
+        err = true;
+    }
+    return v.front();
+}
+
+
+
+/*
+ Same as `one_plant_continuation`, but for `landscape_constantF_ode`.
+ Per-plant parameters can only be varied if they're the same for all
+ plants, and they're kept that way.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_constantF_continuation(const std::vector<double>& m,
+                                               const std::vector<double>& d_yp,
+                                               const std::vector<double>& d_b0,
+                                               const std::vector<double>& d_bp,
+                                               const std::vector<double>& g_yp,
+                                               const std::vector<double>& g_b0,
+                                               const std::vector<double>& g_bp,
+                                               const std::vector<double>& L_0,
+                                               const double& u,
+                                               const double& X,
+                                               const std::vector<double>& Y0,
+                                               const std::vector<double>& B0,
+                                               const std::string& par,
+                                               const double& par_min,
+                                               const double& par_max,
+                                               const double& settle_t = 1000.0,
+                                               const double& ds = 0.01,
+                                               const double& ds_max = 0.1,
+                                               const uint32_t& max_steps = 10000) {
+
+    arma::vec x0;
+    if (! constF_continuation_setup(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                    L_0, u, X, Y0, B0, settle_t, x0)) {
+        return NumericMatrix(0,0);
+    }
+    std::vector<std::vector<double>> plant_pars = {m, d_yp, d_b0, d_bp, g_yp,
+                                                   g_b0, g_bp, L_0};
+    ConstFEquilibria model(plant_pars, u, X);
+
+    bool err = false;
+    size_t k = par_index(par, model.par_names, "par", err);
+    if (err) return NumericMatrix(0,0);
+    double par_value = constF_par_value(plant_pars, u, X, k, par, err);
+    continuation_arg_checks(err, settle_t, ds, ds_max);
+    par_range_check(err, par, par_value, par_min, par_max);
+    if (err) return NumericMatrix(0,0);
+
+    arma::vec z0;
+    if (! start_equilibrium(model, k, par_value, x0, settle_t, z0)) {
+        return NumericMatrix(0,0);
+    }
+
+    std::vector<CurvePoint> points;
+    if (! equilibrium_branch(model, k, z0, par_min, par_max, ds, ds_max,
+                             max_steps, points)) return NumericMatrix(0,0);
+
+    return constF_curve_output(model, {k}, points);
+}
+
+
+// Same as `one_plant_bifurcation_curve`, but for `landscape_constantF_ode`:
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_constantF_bifurcation_curve(const std::vector<double>& m,
+                                                    const std::vector<double>& d_yp,
+                                                    const std::vector<double>& d_b0,
+                                                    const std::vector<double>& d_bp,
+                                                    const std::vector<double>& g_yp,
+                                                    const std::vector<double>& g_b0,
+                                                    const std::vector<double>& g_bp,
+                                                    const std::vector<double>& L_0,
+                                                    const double& u,
+                                                    const double& X,
+                                                    const std::vector<double>& Y0,
+                                                    const std::vector<double>& B0,
+                                                    const std::string& par,
+                                                    const double& par_min,
+                                                    const double& par_max,
+                                                    const std::string& par2,
+                                                    const double& par2_min,
+                                                    const double& par2_max,
+                                                    const double& settle_t = 1000.0,
+                                                    const double& ds = 0.01,
+                                                    const double& ds_max = 0.1,
+                                                    const uint32_t& max_steps = 10000) {
+
+    arma::vec x0;
+    if (! constF_continuation_setup(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                    L_0, u, X, Y0, B0, settle_t, x0)) {
+        return NumericMatrix(0,0);
+    }
+    std::vector<std::vector<double>> plant_pars = {m, d_yp, d_b0, d_bp, g_yp,
+                                                   g_b0, g_bp, L_0};
+    ConstFEquilibria model(plant_pars, u, X);
+
+    bool err = false;
+    size_t k = par_index(par, model.par_names, "par", err);
+    size_t k2 = par_index(par2, model.par_names, "par2", err);
+    if (err) return NumericMatrix(0,0);
+    if (k == k2) {
+        Rcout << "par and par2 should be different!" << std::endl;
+        return NumericMatrix(0,0);
+    }
+    double par_value = constF_par_value(plant_pars, u, X, k, par, err);
+    double par2_value = constF_par_value(plant_pars, u, X, k2, par2, err);
+    continuation_arg_checks(err, settle_t, ds, ds_max);
+    par_range_check(err, par, par_value, par_min, par_max);
+    par_range_check(err, par2, par2_value, par2_min, par2_max);
+    if (err) return NumericMatrix(0,0);
+
+    arma::vec z0;
+    if (! start_equilibrium(model, k, par_value, x0, settle_t, z0)) {
+        return NumericMatrix(0,0);
+    }
+
+    std::vector<CurvePoint> points;
+    if (! bifurcation_curve(model, k, k2, par2_value, z0, par_min,
+                            par_max, par2_min, par2_max, ds, ds_max,
+                            max_steps, points)) return NumericMatrix(0,0);
+
+    return constF_curve_output(model, {k, k2}, points);
+}
@@ -0,0 +1,614 @@
+# ifndef __SWEETSOURSONG_CONTINUATION_H
+# define __SWEETSOURSONG_CONTINUATION_H
+
+
+/*
+ Pseudo-arclength continuation of curves of solutions to H(z) = 0, where
+ H takes n+1 unknowns and returns n values (Keller 1977; Allgower and
+ Georg 2003).
+ For branches of equilibria, z is the state plus one parameter and H is the
+ system's derivatives (see `EquilibriumCurve`).
+ For curves of bifurcations, z is the state plus two parameters and H also
+ includes a test function that's zero where the Jacobian with respect to
+ the state is singular (see `SingularCurve` and `InvasionCurve`).
+ Jacobians use finite differences, so systems only have to provide H
+ (see `fd_jacobian` for where they don't have to be defined).
+
+ Systems (`M` below) need the following:
+   - `n_x`: the number of state variables
+   - `void operator()(const arma::vec& x, arma::vec& dxdt)`
+   - `void set(const size_t& i, const double& value)`: set parameter `i`
+   - `bool feasible(const arma::vec& x)`: whether state `x` is biologically
+     possible (e.g., no negative densities)
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <algorithm>
+
+
+using namespace Rcpp;
+
+
+
+// Types of points along a curve:
+enum ContinuationPoint {
+    cont_regular = 0,
+    cont_fold = 1,      // parameter turns around (saddle-node)
+    cont_branch = 2     // another branch crosses (e.g., transcritical)
+};
+
+
+
+
+/*
+ Finite-difference Jacobian of `h` at `z`, where `h` has `n` outputs.
+ Differences are central, except for components within a step of zero
+ (e.g., densities at boundary equilibria, which Newton's method can leave
+ just below zero), which use second-order forward differences so `h`
+ doesn't have to be defined for negative values.
+ Where a central difference gives non-finite values (e.g., stepping past
+ another limit, such as N = 1 - Y - B < 0), it uses the side that doesn't.
+ */
+template< class H >
+inline void fd_jacobian(H& h,
+                        const arma::vec& z,
+                        const size_t& n,
+                        arma::mat& J) {
+    // Balances truncation and rounding errors for central differences:
+    const double rel_step = std::cbrt(std::numeric_limits<double>::epsilon());
+    J.set_size(n, z.n_elem);
+    arma::vec z_step(z);
+    arma::vec h0(n), h_plus(n), h_minus(n), h_plus2(n), h_minus2(n);
+    bool h0_done = false;
+    for (size_t j = 0; j < z.n_elem; j++) {
+        double step = rel_step * std::max(1.0, std::abs(z(j)));
+        // Which side(s) to use (-1 backward, 0 central, 1 forward):
+        int side = (std::abs(z(j)) < step) ? 1 : 0;
+        if (side == 0) {
+            z_step(j) = z(j) + step;
+            h(z_step, h_plus);
+            z_step(j) = z(j) - step;
+            h(z_step, h_minus);
+            if (! h_plus.is_finite()) {
+                side = -1;
+            } else if (! h_minus.is_finite()) side = 1;
+        } else {
+            z_step(j) = z(j) + step;
+            h(z_step, h_plus);
+        }
+        if (side != 0 && ! h0_done) {
+            h(z, h0);
+            h0_done = true;
+        }
+        if (side == 1) {
+            z_step(j) = z(j) + 2 * step;
+            h(z_step, h_plus2);
+        } else if (side == -1) {
+            z_step(j) = z(j) - 2 * step;
+            h(z_step, h_minus2);
+        }
+        z_step(j) = z(j);
+        for (size_t i = 0; i < n; i++) {
+            if (side == 0) {
+                J(i,j) = (h_plus(i) - h_minus(i)) / (2 * step);
+            } else if (side == 1) {
+                J(i,j) = (-3 * h0(i) + 4 * h_plus(i) - h_plus2(i)) / (2 * step);
+            } else {
+                J(i,j) = (3 * h0(i) - 4 * h_minus(i) + h_minus2(i)) / (2 * step);
+            }
+        }
+    }
+    return;
+}
+
+
+
+
+/*
+ Steps along the curve through `z` in the direction of `tangent`.
+ After each successful `step`, the previous point is kept so that
+ bifurcations between the two can be located.
+ */
+template< class H >
+class ArclengthContinuation
+{
+public:
+
+    H& h;
+    size_t n;           // number of equations
+    arma::vec z;        // current point
+    arma::vec tangent;  // unit tangent at `z`
+    double aug_det;     // determinant of the Jacobian bordered by `tangent`
+    double ds;          // current step size
+
+    ArclengthContinuation(H& h_,
+                          const double& ds_,
+                          const double& ds_min_,
+                          const double& ds_max_)
+        : h(h_),
+          n(h_.n_eq()),
+          z(),
+          tangent(),
+          aug_det(0),
+          ds(ds_),
+          ds_min(ds_min_),
+          ds_max(ds_max_),
+          z_prev(),
+          tangent_prev(),
+          aug_det_prev(0),
+          ds_prev(0) {};
+
+    /*
+     Correct `z0` onto the curve while keeping `z0(k)` fixed, then set the
+     tangent so that `z(k)` increases if `direction` is positive.
+     Returns false if the correction didn't converge.
+     */
+    bool start(const arma::vec& z0, const size_t& k, const double& direction) {
+        arma::vec e_k(z0.n_elem, arma::fill::zeros);
+        e_k(k) = 1;
+        size_t iters;
+        z = z0;
+        if (! correct__(z0, e_k, 0, z, iters)) return false;
+        if (! tangent__(z, e_k, tangent, aug_det)) return false;
+        if ((tangent(k) < 0) == (direction > 0)) {
+            tangent *= -1.0;
+            aug_det *= -1.0;
+        }
+        return true;
+    }
+
+    /*
+     Take one predictor-corrector step, reducing the step size until the
+     corrector converges without turning sharply.
+     Returns false if that requires a step smaller than `ds_min`.
+     */
+    bool step() {
+        arma::vec z_new, t_new;
+        double det_new;
+        size_t iters;
+        while (ds >= ds_min) {
+            if (correct__(z, tangent, ds, z_new, iters) &&
+                tangent__(z_new, tangent, t_new, det_new) &&
+                arma::dot(t_new, tangent) > min_cos) {
+                z_prev = z;
+                tangent_prev = tangent;
+                aug_det_prev = aug_det;
+                ds_prev = ds;
+                z = z_new;
+                tangent = t_new;
+                aug_det = det_new;
+                if (iters <= 3U) ds = std::min(ds * 1.5, ds_max);
+                return true;
+            }
+            ds /= 2;
+        }
+        return false;
+    }
+
+    // Whether the parameter `z(k)` turned around in the last step:
+    bool fold_crossed(const size_t& k) const {
+        return (tangent_prev(k) > 0) != (tangent(k) > 0);
+    }
+    // Whether another branch crossed in the last step:
+    bool branch_crossed() const {
+        return (aug_det_prev > 0) != (aug_det > 0);
+    }
+
+    /*
+     Find where `test(z, tangent, aug_det)` is zero between the previous
+     and current points using the Illinois version of regula falsi on
+     arclength. Returns the best point found.
+     */
+    template< class F >
+    arma::vec locate(F test) {
+        double s0 = 0, s1 = ds_prev;
+        double f0 = test(z_prev, tangent_prev, aug_det_prev);
+        double f1 = test(z, tangent, aug_det);
+        arma::vec z_best(z), z_s, t_s;
+        double det_s;
+        size_t iters;
+        int last_side = 0;
+        for (size_t it = 0; it < max_locate; it++) {
+            if (f1 == f0) break;
+            double s = s1 - f1 * (s1 - s0) / (f1 - f0);
+            if (! correct__(z_prev, tangent_prev, s, z_s, iters)) break;
+            if (! tangent__(z_s, tangent_prev, t_s, det_s)) break;
+            z_best = z_s;
+            double fs = test(z_s, t_s, det_s);
+            if (fs == 0 || std::abs(s1 - s0) < locate_tol * ds_prev) break;
+            if ((fs > 0) == (f0 > 0)) {
+                s0 = s;
+                f0 = fs;
+                if (last_side == -1) f1 /= 2;
+                last_side = -1;
+            } else {
+                s1 = s;
+                f1 = fs;
+                if (last_side == 1) f0 /= 2;
+                last_side = 1;
+            }
+        }
+        return z_best;
+    }
+
+private:
+
+    double ds_min;
+    double ds_max;
+    arma::vec z_prev;
+    arma::vec tangent_prev;
+    double aug_det_prev;
+    double ds_prev;
+    const double min_cos = 0.9;  // minimum cosine between successive tangents
+    const double newton_tol = 1e-8;
+    const size_t max_newton = 10;
+    const size_t max_locate = 20;
+    const double locate_tol = 1e-6;
+
+    /*
+     Newton's method for H(z) = 0 on the hyperplane through `z0 + s * t`
+     that's perpendicular to `t`.
+     */
+    bool correct__(const arma::vec& z0,
+                   const arma::vec& t,
+                   const double& s,
+                   arma::vec& z_out,
+                   size_t& iters) {
+        size_t m = z0.n_elem;
+        arma::vec z_pred = z0 + s * t;
+        z_out = z_pred;
+        arma::mat J, A(m, m);
+        arma::vec rhs(m), h_z(n), dz;
+        for (iters = 1; iters <= max_newton; iters++) {
+            h(z_out, h_z);
+            fd_jacobian(h, z_out, n, J);
+            for (size_t j = 0; j < m; j++) {
+                for (size_t i = 0; i < n; i++) A(i,j) = J(i,j);
+                A(n,j) = t(j);
+            }
+            for (size_t i = 0; i < n; i++) rhs(i) = -h_z(i);
+            rhs(n) = -arma::dot(t, z_out - z_pred);
+            if (! arma::solve(dz, A, rhs)) return false;
+            z_out += dz;
+            if (! z_out.is_finite()) return false;
+            if (arma::norm(dz) <= newton_tol * (1 + arma::norm(z_out))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Unit tangent at `z` pointing the same way as `t_old`:
+    bool tangent__(const arma::vec& z_,
+                   const arma::vec& t_old,
+                   arma::vec& t_new,
+                   double& det) {
+        size_t m = z_.n_elem;
+        arma::mat J, A(m, m);
+        fd_jacobian(h, z_, n, J);
+        for (size_t j = 0; j < m; j++) {
+            for (size_t i = 0; i < n; i++) A(i,j) = J(i,j);
+            A(n,j) = t_old(j);
+        }
+        arma::vec rhs(m, arma::fill::zeros);
+        rhs(n) = 1;
+        if (! arma::solve(t_new, A, rhs)) return false;
+        t_new /= arma::norm(t_new);
+        // Use the new tangent as the border so the sign is comparable:
+        for (size_t j = 0; j < m; j++) A(n,j) = t_new(j);
+        det = arma::det(A);
+        return true;
+    }
+};
+
+
+
+
+/*
+ H(z) = dx/dt for state x and parameter `par`, with z = c(x, par).
+ */
+template< class M >
+class EquilibriumCurve
+{
+public:
+
+    M& model;
+    size_t par;
+
+    EquilibriumCurve(M& model_, const size_t& par_)
+        : model(model_), par(par_), x(model_.n_x) {};
+
+    size_t n_eq() const { return model.n_x; }
+
+    void operator()(const arma::vec& z, arma::vec& out) {
+        for (size_t i = 0; i < model.n_x; i++) x(i) = z(i);
+        model.set(par, z(model.n_x));
+        model(x, out);
+        return;
+    }
+
+private:
+    arma::vec x;
+};
+
+
+
+
+/*
+ Test function `g` from the bordered system
+     [ A    b ] [ v ]   [ 0 ]
+     [ c^T  0 ] [ g ] = [ 1 ]
+ which is zero exactly when A is singular (Govaerts 2000).
+ If `transpose` is true, this uses A^T and swaps `b` and `c`.
+ */
+inline double bordered_test(const arma::mat& A,
+                            const arma::vec& b,
+                            const arma::vec& c,
+                            const bool& transpose,
+                            arma::vec& v) {
+    size_t n = A.n_rows;
+    arma::mat Ab(n + 1U, n + 1U, arma::fill::zeros);
+    for (size_t j = 0; j < n; j++) {
+        for (size_t i = 0; i < n; i++) {
+            Ab(i,j) = transpose ? A(j,i) : A(i,j);
+        }
+        Ab(j,n) = transpose ? c(j) : b(j);
+        Ab(n,j) = transpose ? b(j) : c(j);
+    }
+    arma::vec rhs(n + 1U, arma::fill::zeros);
+    rhs(n) = 1;
+    arma::vec sol;
+    if (! arma::solve(sol, Ab, rhs)) return arma::datum::nan;
+    v.set_size(n);
+    for (size_t i = 0; i < n; i++) v(i) = sol(i);
+    return sol(n);
+}
+
+/*
+ Set `b` and `c` to (approximate) left and right null vectors of `A`,
+ which should be close to singular.
+ The first time (when `b` is empty) this uses inverse iteration, and after
+ that it uses the solutions of the bordered systems with the old borders.
+ */
+inline bool update_null_borders(const arma::mat& A,
+                                arma::vec& b,
+                                arma::vec& c) {
+    size_t n = A.n_rows;
+    if (b.n_elem != n) {
+        arma::mat At = A.t();
+        c.ones(n);
+        b.ones(n);
+        for (size_t it = 0; it < 5U; it++) {
+            arma::vec c_new, b_new;
+            if (! arma::solve(c_new, A, c)) return false;
+            if (! arma::solve(b_new, At, b)) return false;
+            c = c_new / arma::norm(c_new);
+            b = b_new / arma::norm(b_new);
+        }
+        return true;
+    }
+    arma::vec v, w;
+    bordered_test(A, b, c, false, v);
+    bordered_test(A, b, c, true, w);
+    if (! v.is_finite() || ! w.is_finite()) return false;
+    c = v / arma::norm(v);
+    b = w / arma::norm(w);
+    return true;
+}
+
+
+
+
+/*
+ H(z) = c(dx/dt, g) for state x and parameters `par1` and `par2`,
+ with z = c(x, par1, par2).
+ `g` is the bordered test function for J_x (see `bordered_test`), so it's
+ zero at both folds and transcritical points.
+ Call `update_borders` after each step so `b` and `c` stay close to the
+ left and right null vectors of J_x.
+ */
+template< class M >
+class SingularCurve
+{
+public:
+
+    M& model;
+    size_t par1;
+    size_t par2;
+    arma::vec b;
+    arma::vec c;
+
+    SingularCurve(M& model_, const size_t& par1_, const size_t& par2_)
+        : model(model_), par1(par1_), par2(par2_), b(), c(),
+          eq(model_, par1_) {};
+
+    size_t n_eq() const { return model.n_x + 1U; }
+
+    void operator()(const arma::vec& z, arma::vec& out) {
+        size_t nx = model.n_x;
+        arma::vec z_eq = set_z__(z);
+        arma::vec f(nx);
+        eq(z_eq, f);
+        out.set_size(nx + 1U);
+        for (size_t i = 0; i < nx; i++) out(i) = f(i);
+        arma::vec v;
+        out(nx) = bordered_test(jac_x__(z_eq), b, c, false, v);
+        return;
+    }
+
+    // Keep `b` and `c` close to the null vectors of J_x at `z`:
+    bool update_borders(const arma::vec& z) {
+        arma::vec z_eq = set_z__(z);
+        return update_null_borders(jac_x__(z_eq), b, c);
+    }
+
+private:
+    EquilibriumCurve<M> eq;
+
+    // Set `par2` and return c(x, par1):
+    arma::vec set_z__(const arma::vec& z) {
+        size_t nx = model.n_x;
+        model.set(par2, z(nx + 1U));
+        arma::vec z_eq(nx + 1U);
+        for (size_t i = 0; i <= nx; i++) z_eq(i) = z(i);
+        return z_eq;
+    }
+
+    arma::mat jac_x__(const arma::vec& z_eq) {
+        arma::mat J;
+        fd_jacobian(eq, z_eq, model.n_x, J);
+        size_t nx = model.n_x;
+        return J.submat(0, 0, nx - 1U, nx - 1U);
+    }
+};
+
+
+
+
+/*
+ Curve of transcritical points on a boundary where the state variables in
+ `zero` are all zero (e.g., where one microbe is absent and can just invade).
+ There, dx/dt for those variables is zero for any parameters, so the
+ equations in `SingularCurve` are degenerate.
+ Instead, with z = c(x, par1, par2), this uses
+     H(z) = c(dx/dt for the other variables, x[zero], g)
+ where `g` is the bordered test function for the block of J_x for the
+ variables in `zero` (i.e., the invasion growth rates).
+ That block uses one-sided differences into positive values, so systems
+ don't have to be defined for negative densities.
+ */
+template< class M >
+class InvasionCurve
+{
+public:
+
+    M& model;
+    size_t par1;
+    size_t par2;
+    std::vector<size_t> zero;
+    arma::vec b;
+    arma::vec c;
+
+    InvasionCurve(M& model_, const size_t& par1_, const size_t& par2_,
+                  const std::vector<size_t>& zero_)
+        : model(model_), par1(par1_), par2(par2_), zero(zero_), b(), c(),
+          x(model_.n_x), f(model_.n_x) {};
+
+    size_t n_eq() const { return model.n_x + 1U; }
+
+    void operator()(const arma::vec& z, arma::vec& out) {
+        size_t nx = model.n_x;
+        set_z__(z);
+        model(x, f);
+        out.set_size(nx + 1U);
+        for (size_t i = 0; i < nx; i++) out(i) = f(i);
+        for (const size_t& i : zero) out(i) = z(i);
+        arma::vec v;
+        out(nx) = bordered_test(invasion_jac__(), b, c, false, v);
+        return;
+    }
+
+    // Keep `b` and `c` close to the null vectors of the invasion block:
+    bool update_borders(const arma::vec& z) {
+        set_z__(z);
+        return update_null_borders(invasion_jac__(), b, c);
+    }
+
+private:
+    arma::vec x;
+    arma::vec f;
+
+    // Set both parameters and `x` (with variables in `zero` at zero):
+    void set_z__(const arma::vec& z) {
+        size_t nx = model.n_x;
+        model.set(par1, z(nx));
+        model.set(par2, z(nx + 1U));
+        for (size_t i = 0; i < nx; i++) x(i) = z(i);
+        for (const size_t& i : zero) x(i) = 0;
+        return;
+    }
+
+    /*
+     Block of J_x for the variables in `zero`, at `x`.
+     Uses second-order forward differences, since these derivatives are
+     differentiated again for the Jacobian of H.
+     */
+    arma::mat invasion_jac__() {
+        const double step = std::cbrt(std::numeric_limits<double>::epsilon());
+        size_t nz = zero.size();
+        arma::mat A(nz, nz);
+        arma::vec x_step(x);
+        arma::vec f0(model.n_x), f1(model.n_x), f2(model.n_x);
+        model(x, f0);
+        for (size_t j = 0; j < nz; j++) {
+            x_step(zero[j]) = step;
+            model(x_step, f1);
+            x_step(zero[j]) = 2 * step;
+            model(x_step, f2);
+            x_step(zero[j]) = 0;
+            for (size_t i = 0; i < nz; i++) {
+                size_t k = zero[i];
+                A(i,j) = (-3 * f0(k) + 4 * f1(k) - f2(k)) / (2 * step);
+            }
+        }
+        return A;
+    }
+};
+
+
+
+
+
+/*
+ Largest real part of the eigenvalues of J_x for a model at state `x`
+ (with parameters already set). Negative means the equilibrium is stable.
+ */
+template< class M >
+inline double max_real_eigen(M& model, const size_t& par, const arma::vec& z) {
+    EquilibriumCurve<M> eq(model, par);
+    arma::mat J;
+    fd_jacobian(eq, z, model.n_x, J);
+    size_t nx = model.n_x;
+    arma::mat J_x(nx, nx);
+    for (size_t j = 0; j < nx; j++) {
+        for (size_t i = 0; i < nx; i++) J_x(i,j) = J(i,j);
+    }
+    arma::cx_vec eigval;
+    if (! arma::eig_gen(eigval, J_x)) return arma::datum::nan;
+    double mx = -arma::datum::inf;
+    for (size_t i = 0; i < eigval.n_elem; i++) {
+        mx = std::max(mx, std::real(eigval(i)));
+    }
+    return mx;
+}
+
+
+
+/*
+ Newton's method for an equilibrium with parameters fixed, starting at `x`
+ (e.g., after integrating for a while).
+ */
+template< class M >
+inline bool polish_equilibrium(M& model, arma::vec& x) {
+    size_t nx = model.n_x;
+    arma::vec f(nx), dx;
+    arma::mat J;
+    auto rhs = [&model](const arma::vec& x_, arma::vec& f_) { model(x_, f_); };
+    for (size_t it = 0; it < 50U; it++) {
+        model(x, f);
+        fd_jacobian(rhs, x, nx, J);
+        if (! arma::solve(dx, J, f)) return false;
+        x -= dx;
+        if (! x.is_finite()) return false;
+        if (arma::norm(dx) <= 1e-10 * (1 + arma::norm(x))) return true;
+    }
+    return false;
+}
+
+
+
+#endif
@@ -0,0 +1,342 @@
+# ifndef __SWEETSOURSONG_ENSEMBLE_H
+# define __SWEETSOURSONG_ENSEMBLE_H
+
+
+/*
+ Summaries across reps (means, variances, and quantiles for each time point,
+ plant, and variable) that are updated one rep at a time, so reps don't
+ have to be stored.
+ Each running chunk of reps adds to its own accumulator, and all of them
+ are merged at the end.
+ Means and variances use Welford's method (merged using Chan et al.'s
+ formula), and quantiles use a merging t-digest (Dunning 2019).
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <cstdio>
+
+
+using namespace Rcpp;
+
+
+
+
+/*
+ t-digest for quantiles of one variable.
+ Smaller `compression` uses less memory but gives less accurate quantiles,
+ especially in the middle of the distribution (tails are always the most
+ accurate). Each digest keeps up to about `compression` centroids plus a
+ buffer of the same size, so memory can add up when there are many
+ time points and plants.
+ */
+class TDigest
+{
+public:
+
+    TDigest(const double& compression_ = 100)
+        : compression(compression_),
+          means(),
+          weights(),
+          buffer(),
+          total(0),
+          min_x(std::numeric_limits<double>::infinity()),
+          max_x(-std::numeric_limits<double>::infinity()) {};
+
+    void add(const double& x, const double& w = 1) {
+        buffer.push_back(std::make_pair(x, w));
+        if (x < min_x) min_x = x;
+        if (x > max_x) max_x = x;
+        if (buffer.size() >= static_cast<size_t>(compression)) compress();
+        return;
+    }
+
+    void merge(const TDigest& other) {
+        for (size_t i = 0; i < other.means.size(); i++) {
+            buffer.push_back(std::make_pair(other.means[i], other.weights[i]));
+        }
+        buffer.insert(buffer.end(), other.buffer.begin(), other.buffer.end());
+        if (other.min_x < min_x) min_x = other.min_x;
+        if (other.max_x > max_x) max_x = other.max_x;
+        compress();
+        return;
+    }
+
+    // Combine buffered values with existing centroids:
+    void compress() {
+        if (buffer.empty()) return;
+        for (size_t i = 0; i < means.size(); i++) {
+            buffer.push_back(std::make_pair(means[i], weights[i]));
+        }
+        std::sort(buffer.begin(), buffer.end());
+        total = 0;
+        for (const auto& b : buffer) total += b.second;
+        means.clear();
+        weights.clear();
+        // Centroids can grow until they span one unit of the scale function:
+        double w_so_far = 0;
+        double k_lower = k_scale__(0);
+        double mean = buffer.front().first;
+        double w = buffer.front().second;
+        for (size_t i = 1; i < buffer.size(); i++) {
+            const double& x_i(buffer[i].first);
+            const double& w_i(buffer[i].second);
+            if ((k_scale__((w_so_far + w + w_i) / total) - k_lower) <= 1) {
+                w += w_i;
+                mean += (x_i - mean) * w_i / w;
+            } else {
+                means.push_back(mean);
+                weights.push_back(w);
+                w_so_far += w;
+                k_lower = k_scale__(w_so_far / total);
+                mean = x_i;
+                w = w_i;
+            }
+        }
+        means.push_back(mean);
+        weights.push_back(w);
+        buffer.clear();
+        return;
+    }
+
+    /*
+     `q` should be in [0,1]. Only call after `compress`.
+     Each centroid is centered on the middle of the (0-based) ranks of the
+     values in it, and quantiles are interpolated between centers, so this
+     is the same as R's default quantile type (7) when all centroids are
+     single values.
+     */
+    double quantile(const double& q) const {
+        if (means.empty()) return NA_REAL;
+        double target = q * (total - 1);
+        double c_prev = (weights.front() - 1) / 2;
+        if (target <= c_prev) {
+            if (c_prev <= 0) return means.front();
+            return min_x + (means.front() - min_x) * target / c_prev;
+        }
+        double cum = weights.front();
+        double c_i;
+        for (size_t i = 1; i < means.size(); i++) {
+            c_i = cum + (weights[i] - 1) / 2;
+            if (target <= c_i) {
+                return means[i-1] + (means[i] - means[i-1]) *
+                    (target - c_prev) / (c_i - c_prev);
+            }
+            c_prev = c_i;
+            cum += weights[i];
+        }
+        double last = total - 1;
+        if (last <= c_prev) return means.back();
+        return means.back() + (max_x - means.back()) *
+            (target - c_prev) / (last - c_prev);
+    }
+
+private:
+    double compression;
+    std::vector<double> means;
+    std::vector<double> weights;
+    std::vector<std::pair<double,double>> buffer;
+    double total;
+    double min_x;
+    double max_x;
+
+    double k_scale__(const double& q) const {
+        double qq = std::min(std::max(q, 0.0), 1.0);
+        return compression / (2 * M_PI) * std::asin(2 * qq - 1);
+    }
+};
+
+
+
+
+/*
+ Accumulator for `n_vars` variables for each of `n_plants` plants at each of
+ `n_times` time points. Cells are indexed by (time, plant, variable),
+ with variable changing fastest.
+ */
+class EnsembleAccumulator
+{
+public:
+
+    size_t n_times;
+    size_t n_plants;
+    size_t n_vars;
+    std::vector<double> time;
+    std::vector<double> n;      // number of reps at each time point
+    std::vector<double> mean;
+    std::vector<double> M2;     // sums of squared differences from the mean
+    std::vector<TDigest> digests;  // empty if no quantiles wanted
+
+    EnsembleAccumulator(const size_t& n_times_,
+                        const size_t& n_plants_,
+                        const size_t& n_vars_,
+                        const bool& quantiles,
+                        const double& compression)
+        : n_times(n_times_),
+          n_plants(n_plants_),
+          n_vars(n_vars_),
+          time(n_times_, 0.0),
+          n(n_times_, 0.0),
+          mean(n_times_ * n_plants_ * n_vars_, 0.0),
+          M2(n_times_ * n_plants_ * n_vars_, 0.0),
+          digests((quantiles ? n_times_ * n_plants_ * n_vars_ : 0U),
+                  TDigest(compression)) {};
+
+    // Add one rep's value for a cell:
+    void add(const size_t& t, const size_t& i, const size_t& j,
+             const double& x) {
+        size_t c = cell(t, i, j);
+        // `n[t]` is incremented before these are called (see `add_time`):
+        double d = x - mean[c];
+        mean[c] += d / n[t];
+        M2[c] += d * (x - mean[c]);
+        if (! digests.empty()) digests[c].add(x);
+        return;
+    }
+    // Call once for time point `t` before adding its cells:
+    void add_time(const size_t& t, const double& time_) {
+        time[t] = time_;
+        n[t] += 1;
+        return;
+    }
+
+    void merge(EnsembleAccumulator& other) {
+        for (size_t t = 0; t < n_times; t++) {
+            double na = n[t], nb = other.n[t];
+            if (nb == 0) continue;
+            time[t] = other.time[t];
+            double nab = na + nb;
+            for (size_t i = 0; i < n_plants; i++) {
+                for (size_t j = 0; j < n_vars; j++) {
+                    size_t c = cell(t, i, j);
+                    double d = other.mean[c] - mean[c];
+                    mean[c] += d * nb / nab;
+                    M2[c] += other.M2[c] + d * d * na * nb / nab;
+                    if (! digests.empty()) digests[c].merge(other.digests[c]);
+                }
+            }
+            n[t] = nab;
+        }
+        return;
+    }
+
+    double sd(const size_t& t, const size_t& i, const size_t& j) const {
+        if (n[t] < 2) return NA_REAL;
+        return std::sqrt(M2[cell(t, i, j)] / (n[t] - 1));
+    }
+
+    size_t cell(const size_t& t, const size_t& i, const size_t& j) const {
+        return (t * n_plants + i) * n_vars + j;
+    }
+};
+
+
+
+
+/*
+ Accumulators lent to chunks of reps as they start, so there's never more
+ of them than chunks running at once.
+ */
+class AccumulatorPool
+{
+public:
+
+    AccumulatorPool(const EnsembleAccumulator& proto_)
+        : proto(proto_), items(), available(), mtx() {};
+
+    EnsembleAccumulator* checkout() {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (available.empty()) {
+            items.emplace_back(new EnsembleAccumulator(proto));
+            return items.back().get();
+        }
+        EnsembleAccumulator* a = available.back();
+        available.pop_back();
+        return a;
+    }
+    void checkin(EnsembleAccumulator* a) {
+        std::lock_guard<std::mutex> lock(mtx);
+        available.push_back(a);
+        return;
+    }
+
+    // Merge all into the first one and return it (only call after running):
+    EnsembleAccumulator& merged() {
+        if (items.empty()) items.emplace_back(new EnsembleAccumulator(proto));
+        for (size_t k = 1; k < items.size(); k++) items[0]->merge(*items[k]);
+        for (TDigest& d : items[0]->digests) d.compress();
+        return *items[0];
+    }
+
+private:
+    EnsembleAccumulator proto;
+    std::vector<std::unique_ptr<EnsembleAccumulator>> items;
+    std::vector<EnsembleAccumulator*> available;
+    std::mutex mtx;
+};
+
+
+
+
+/*
+ Output with one row per time point and plant, with columns for the number
+ of reps, then means and SDs for each variable, then quantiles for each
+ variable (e.g., `Y_q0.05`).
+ */
+inline NumericMatrix ensemble_output(const EnsembleAccumulator& acc,
+                                     const std::vector<std::string>& var_names,
+                                     const std::vector<double>& quantiles) {
+
+    size_t n_times = 0;
+    while (n_times < acc.n_times && acc.n[n_times] > 0) n_times++;
+    size_t nv = acc.n_vars;
+    size_t nq = acc.digests.empty() ? 0U : quantiles.size();
+
+    NumericMatrix output(n_times * acc.n_plants, 3U + nv * (2U + nq));
+    CharacterVector cn = CharacterVector::create("t", "p", "n");
+    for (size_t j = 0; j < nv; j++) {
+        cn.push_back(var_names[j] + "_mean");
+        cn.push_back(var_names[j] + "_sd");
+    }
+    char buffer[50];
+    for (size_t j = 0; j < nv; j++) {
+        for (size_t h = 0; h < nq; h++) {
+            std::snprintf(buffer, sizeof(buffer), "%s_q%g",
+                          var_names[j].c_str(), quantiles[h]);
+            cn.push_back(std::string(buffer));
+        }
+    }
+    colnames(output) = cn;
+
+    size_t r = 0;
+    for (size_t t = 0; t < n_times; t++) {
+        for (size_t i = 0; i < acc.n_plants; i++) {
+            output(r,0) = acc.time[t];
+            output(r,1) = i;
+            output(r,2) = acc.n[t];
+            for (size_t j = 0; j < nv; j++) {
+                output(r,3U+2U*j) = acc.mean[acc.cell(t, i, j)];
+                output(r,4U+2U*j) = acc.sd(t, i, j);
+            }
+            for (size_t j = 0; j < nv; j++) {
+                const TDigest& d(acc.digests[acc.cell(t, i, j)]);
+                for (size_t h = 0; h < nq; h++) {
+                    output(r,3U+2U*nv+j*nq+h) = d.quantile(quantiles[h]);
+                }
+            }
+            r++;
+        }
+    }
+
+    return output;
+}
+
+
+
+#endif
@@ -0,0 +1,126 @@
+
+/*
+ Fitting `landscape_constantF_ode` and `landscape_ode` to field surveys
+ (see fit.h).
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <string>
+
+#include "ode.h"
+#include "landscape.h"
+#include "landscape_constantF.h"
+#include "fit.h"
+
+using namespace Rcpp;
+
+
+
+
+/*
+ Fit parameters of `landscape_constantF_ode` to survey counts.
+ `obs` has columns for time (multiples of `dt`), plant (starting at 0),
+ number of flowers sampled, and the numbers of those dominated by yeast
+ and by bacteria (either can be NA).
+ `fit_pars` can include any of m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0,
+ u, and X, and the other arguments give their starting values.
+ Each fitted parameter is multiplied by one factor at all plants.
+ `family` is "multinomial" or "dirmultinomial", and `phi` is the starting
+ precision for Dirichlet-multinomial fits (larger is closer to
+ multinomial).
+ Returns one row per plant with fitted values, and with the
+ log-likelihood (`loglik`), `n_evals`, `converged`, and `phi` (for
+ Dirichlet-multinomial fits) as attributes.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_constantF_fit(const std::vector<double>& m,
+                                      const std::vector<double>& d_yp,
+                                      const std::vector<double>& d_b0,
+                                      const std::vector<double>& d_bp,
+                                      const std::vector<double>& g_yp,
+                                      const std::vector<double>& g_b0,
+                                      const std::vector<double>& g_bp,
+                                      const std::vector<double>& L_0,
+                                      const double& u,
+                                      const double& X,
+                                      const std::vector<double>& Y0,
+                                      const std::vector<double>& B0,
+                                      const NumericMatrix& obs,
+                                      const std::vector<std::string>& fit_pars,
+                                      const std::string& family = "multinomial",
+                                      const double& phi = 10,
+                                      const double& dt = 0.1,
+                                      const uint32_t& max_evals = 1000,
+                                      const double& tol = 1e-8,
+                                      const bool& show_progress = false) {
+
+    // (`max_t` comes from the survey times, so it isn't checked here.)
+    bool err = lanscape_constF_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                          L_0, u, X, Y0, B0, dt,
+                                          std::max(1.0, 2 * dt));
+    if (err) return NumericMatrix(0,0);
+
+    ConstFFitModel model(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X,
+                         Y0, B0);
+
+    return fit_surveys(model, obs, fit_pars, family, phi, dt, max_evals, tol,
+                       show_progress);
+}
+
+
+
+/*
+ Same as `landscape_constantF_fit`, but for `landscape_ode`, where
+ proportions are Y / F and B / F.
+ `fit_pars` can include any of m, R, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+ L_0, P_max, u, q, W, and w.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_fit(const std::vector<double>& m,
+                            const std::vector<double>& R,
+                            const std::vector<double>& d_yp,
+                            const std::vector<double>& d_b0,
+                            const std::vector<double>& d_bp,
+                            const std::vector<double>& g_yp,
+                            const std::vector<double>& g_b0,
+                            const std::vector<double>& g_bp,
+                            const std::vector<double>& L_0,
+                            const std::vector<double>& P_max,
+                            const double& u,
+                            const double& q,
+                            const std::vector<double>& W,
+                            const double& w,
+                            const arma::mat& z,
+                            const double& min_F_for_P,
+                            const std::vector<double>& Y0,
+                            const std::vector<double>& B0,
+                            const std::vector<double>& N0,
+                            const NumericMatrix& obs,
+                            const std::vector<std::string>& fit_pars,
+                            const std::string& family = "multinomial",
+                            const double& phi = 10,
+                            const double& dt = 0.1,
+                            const uint32_t& max_evals = 1000,
+                            const double& tol = 1e-8,
+                            const bool& show_progress = false) {
+
+    size_t np = z.n_rows;
+    // (`max_t` comes from the survey times, so it isn't checked here.)
+    bool err = lanscape_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                   L_0, P_max, u, q, W, w, z, min_F_for_P,
+                                   Y0, B0, dt, std::max(1.0, 2 * dt));
+    len_check(err, R, "R", np);
+    len_check(err, N0, "N0", np);
+    min_val_check(err, R, "R", 0);
+    min_val_check(err, N0, "N0", 0);
+    if (err) return NumericMatrix(0,0);
+
+    LandscapeFitModel model(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max,
+                            u, q, W, w, z, min_F_for_P, R, Y0, B0, N0);
+
+    return fit_surveys(model, obs, fit_pars, family, phi, dt, max_evals, tol,
+                       show_progress);
+}
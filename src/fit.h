@@ -0,0 +1,677 @@
+# ifndef __SWEETSOURSONG_FIT_H
+# define __SWEETSOURSONG_FIT_H
+
+
+/*
+ Fitting the landscape models to field surveys.
+
+ Surveys are counts of flowers (out of the number sampled at a plant) that
+ were dominated by yeast and by bacteria. Each survey is multinomial (or
+ Dirichlet-multinomial, for extra variation among flowers) over flowers
+ with yeast, with bacteria, and with neither, with probabilities equal to
+ the model's proportions at that plant and time.
+
+ The negative log-likelihood is minimized by Nelder-Mead on the log scale,
+ so parameters stay positive. Each fitted parameter is multiplied by one
+ factor at all plants, so differences among plants in the starting values
+ are kept.
+ One system and one stepper are made per fit and reused for every
+ evaluation, and each evaluation only integrates to the last survey.
+
+ Models (`M` below) are systems with these added:
+   - `par_names`: names of the parameters that can be fitted
+   - `void set(const size_t& k, const double& scale)`: set parameter `k`
+     to `scale` times its starting value(s)
+   - `bool can_scale(const size_t& k)`: whether any starting value for
+     parameter `k` is above zero
+   - `std::vector<double> values(const size_t& k)`: current values of
+     parameter `k` for each plant
+   - `x0`: the starting state
+   - `void props(const MatType& x, const size_t& i, double& Y, double& B)`:
+     proportions of flowers with yeast and bacteria at plant `i`
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <memory>
+
+#include "ode.h"
+#include "landscape.h"
+#include "landscape_constantF.h"
+#include "checkpoint.h"
+#include "progress.h"
+
+
+using namespace Rcpp;
+
+
+
+/*
+ Log-likelihood for `Y` flowers with yeast and `B` with bacteria out of `n`
+ sampled, where the model's proportions are `pY` and `pB`. These are
+ exclusive categories of one sample (the rest have neither), so this is
+ multinomial over (Y, B, n - Y - B), or Dirichlet-multinomial with
+ concentrations `pY * phi`, `pB * phi`, and `(1 - pY - pB) * phi` if `phi`
+ is above zero.
+ If `Y` or `B` is NA, it's merged into the rest, so this becomes binomial
+ (or beta-binomial) for the other count.
+ */
+inline double survey_loglik(const double& Y, const double& B,
+                            const double& n, double pY, double pB,
+                            const double& phi) {
+    const double p_min = 1e-12;
+    pY = std::max(pY, p_min);
+    pB = std::max(pB, p_min);
+    double pN = std::max(1 - pY - pB, p_min);
+    double p_sum = pY + pB + pN;
+    double k[3], p[3];
+    size_t n_cat = 0;
+    double k_rest = n, p_rest = 1;
+    if (! std::isnan(Y)) {
+        k[n_cat] = Y;
+        p[n_cat] = pY / p_sum;
+        k_rest -= Y;
+        p_rest -= p[n_cat];
+        n_cat++;
+    }
+    if (! std::isnan(B)) {
+        k[n_cat] = B;
+        p[n_cat] = pB / p_sum;
+        k_rest -= B;
+        p_rest -= p[n_cat];
+        n_cat++;
+    }
+    if (n_cat == 0) return 0;
+    k[n_cat] = k_rest;
+    p[n_cat] = std::max(p_rest, p_min / p_sum);
+    n_cat++;
+
+    double ll = std::lgamma(n + 1);
+    if (phi > 0) ll += std::lgamma(phi) - std::lgamma(n + phi);
+    for (size_t c = 0; c < n_cat; c++) {
+        ll -= std::lgamma(k[c] + 1);
+        if (phi > 0) {
+            double a = p[c] * phi;
+            ll += std::lgamma(k[c] + a) - std::lgamma(a);
+        } else ll += k[c] * std::log(p[c]);
+    }
+    return ll;
+}
+
+
+
+
+/*
+ Survey counts stored by output time step.
+ `obs` has columns for time (multiples of `dt`), plant (starting at 0),
+ number of flowers sampled, and numbers dominated by yeast and by bacteria
+ (either can be NA).
+ */
+class SurveyCounts
+{
+public:
+
+    size_t last_step;
+
+    SurveyCounts(const NumericMatrix& obs,
+                 const size_t& n_plants,
+                 const double& dt,
+                 bool& err)
+        : last_step(0), by_step() {
+
+        if (obs.ncol() != 5) {
+            Rcout << "obs should have 5 columns (t, p, n, Y, and B)!" << std::endl;
+            err = true;
+            return;
+        }
+        if (obs.nrow() == 0) {
+            Rcout << "obs should have at least one row!" << std::endl;
+            err = true;
+            return;
+        }
+        for (size_t r = 0; r < static_cast<size_t>(obs.nrow()); r++) {
+            double t = obs(r,0), p = obs(r,1), n = obs(r,2);
+            double Y = obs(r,3), B = obs(r,4);
+            double k = std::round(t / dt);
+            if (! (k >= 0) || ! same_time(k * dt, t)) {
+                Rcout << "Survey times should be non-negative multiples of dt ";
+                Rcout << "(row " << (r + 1U) << ")!" << std::endl;
+                err = true;
+                return;
+            }
+            if (! (p >= 0 && p < static_cast<double>(n_plants)) ||
+                p != std::floor(p)) {
+                Rcout << "Survey plants should be integers from 0 to the ";
+                Rcout << "number of plants minus one (row " << (r + 1U);
+                Rcout << ")!" << std::endl;
+                err = true;
+                return;
+            }
+            bool bad_n = ! (n >= 0) || n != std::floor(n);
+            bool bad_Y = ! std::isnan(Y) &&
+                (! (Y >= 0 && Y <= n) || Y != std::floor(Y));
+            bool bad_B = ! std::isnan(B) &&
+                (! (B >= 0 && B <= n) || B != std::floor(B));
+            if (! bad_Y && ! bad_B && ! std::isnan(Y) && ! std::isnan(B)) {
+                bad_Y = (Y + B) > n;
+            }
+            if (bad_n || bad_Y || bad_B) {
+                Rcout << "Survey counts should be integers, with Y and B ";
+                Rcout << "between 0 and n and Y + B <= n (row " << (r + 1U);
+                Rcout << ")!" << std::endl;
+                err = true;
+                return;
+            }
+            size_t ks = static_cast<size_t>(k);
+            if (ks >= by_step.size()) by_step.resize(ks + 1U);
+            by_step[ks].push_back(Survey{static_cast<size_t>(p), n, Y, B});
+            last_step = std::max(last_step, ks);
+        }
+    };
+
+    // Log-likelihood for surveys at step `k` (see `survey_loglik`):
+    template< class M >
+    double loglik(const size_t& k, const MatType& x, const M& model,
+                  const double& phi) const {
+        if (k >= by_step.size()) return 0;
+        double ll = 0;
+        double pY, pB;
+        for (const Survey& s : by_step[k]) {
+            model.props(x, s.plant, pY, pB);
+            ll += survey_loglik(s.Y, s.B, s.n, pY, pB, phi);
+        }
+        return ll;
+    }
+
+private:
+
+    struct Survey {
+        size_t plant;
+        double n;
+        double Y;
+        double B;
+    };
+    std::vector<std::vector<Survey>> by_step;
+};
+
+
+
+
+/*
+ Nelder-Mead minimization of `f` starting at `x` with initial steps of
+ `step` along each axis (Nelder and Mead 1965, with the usual
+ coefficients). Stops when the spread of values in the simplex is less
+ than `tol` (relative to the best) and the simplex is smaller than
+ `sqrt(tol)` along every axis, after `max_evals` evaluations, or when
+ `stop()` returns true.
+ On return, `x` and `fx` are the best point and its value.
+ Returns whether it converged.
+ */
+template< class F, class Stop >
+inline bool nelder_mead(F f,
+                        arma::vec& x,
+                        double& fx,
+                        const double& step,
+                        const size_t& max_evals,
+                        const double& tol,
+                        size_t& n_evals,
+                        Stop stop) {
+
+    size_t n = x.n_elem;
+    auto f_ = [&](const arma::vec& x_) {
+        n_evals++;
+        double y = f(x_);
+        return std::isfinite(y) ? y : std::numeric_limits<double>::infinity();
+    };
+
+    n_evals = 0;
+    fx = f_(x);
+    if (n == 0 || max_evals <= 1U || stop()) return false;
+
+    std::vector<arma::vec> pts(n + 1U, x);
+    std::vector<double> vals(n + 1U, fx);
+    for (size_t i = 0; i < n; i++) {
+        pts[i+1U](i) += step;
+        vals[i+1U] = f_(pts[i+1U]);
+    }
+
+    std::vector<size_t> order(n + 1U);
+    bool converged = false;
+    while (n_evals < max_evals && ! stop()) {
+
+        for (size_t i = 0; i <= n; i++) order[i] = i;
+        std::sort(order.begin(), order.end(),
+                  [&vals](const size_t& a, const size_t& b) {
+                      return vals[a] < vals[b];
+                  });
+        const size_t& best(order.front());
+        const size_t& worst(order.back());
+        const size_t& second(order[n - 1U]);
+
+        double size = 0;
+        for (size_t i = 0; i <= n; i++) {
+            size = std::max(size, arma::abs(pts[i] - pts[best]).max());
+        }
+        if (std::abs(vals[worst] - vals[best]) <=
+                tol * (std::abs(vals[best]) + tol) &&
+            size <= std::sqrt(tol)) {
+            converged = true;
+            break;
+        }
+
+        arma::vec centroid(n, arma::fill::zeros);
+        for (size_t i = 0; i <= n; i++) {
+            if (i != worst) centroid += pts[i];
+        }
+        centroid /= static_cast<double>(n);
+
+        arma::vec xr = centroid + (centroid - pts[worst]);
+        double fr = f_(xr);
+        if (fr < vals[best]) {
+            arma::vec xe = centroid + 2 * (centroid - pts[worst]);
+            double fe = f_(xe);
+            if (fe < fr) {
+                pts[worst] = xe;
+                vals[worst] = fe;
+            } else {
+                pts[worst] = xr;
+                vals[worst] = fr;
+            }
+            continue;
+        }
+        if (fr < vals[second]) {
+            pts[worst] = xr;
+            vals[worst] = fr;
+            continue;
+        }
+        // Contract (outside if the reflected point is better):
+        bool outside = fr < vals[worst];
+        arma::vec xc = outside ? arma::vec(centroid + 0.5 * (xr - centroid)) :
+            arma::vec(centroid + 0.5 * (pts[worst] - centroid));
+        double fc = f_(xc);
+        if (fc < (outside ? fr : vals[worst])) {
+            pts[worst] = xc;
+            vals[worst] = fc;
+            continue;
+        }
+        // Shrink toward the best:
+        for (size_t i = 0; i <= n; i++) {
+            if (i == best) continue;
+            pts[i] = pts[best] + 0.5 * (pts[i] - pts[best]);
+            vals[i] = f_(pts[i]);
+        }
+    }
+
+    size_t b = 0;
+    for (size_t i = 1; i <= n; i++) if (vals[i] < vals[b]) b = i;
+    x = pts[b];
+    fx = vals[b];
+    return converged;
+}
+
+
+
+
+/*
+ Negative log-likelihood of the surveys for a model, as a function of the
+ log scaling factors of the fitted parameters (then log(phi) for
+ Dirichlet-multinomial fits).
+ */
+template< class M >
+class SurveyFit
+{
+public:
+
+    SurveyFit(M& model_,
+              const SurveyCounts& counts_,
+              const std::vector<size_t>& pars_,
+              const bool& dir_mult_,
+              const double& dt_,
+              Progress& progress_)
+        : model(model_),
+          counts(counts_),
+          pars(pars_),
+          dir_mult(dir_mult_),
+          dt(dt_),
+          progress(progress_),
+          ticker(progress_, true),
+          stepper(),
+          x() {};
+
+    size_t n_eta() const { return pars.size() + (dir_mult ? 1U : 0U); }
+
+    double operator()(const arma::vec& eta) {
+        for (size_t j = 0; j < pars.size(); j++) {
+            model.set(pars[j], std::exp(eta(j)));
+        }
+        double phi = dir_mult ? std::exp(eta(pars.size())) : 0;
+        x = model.x0;
+        // Starting over, so derivatives at the start need recalculating:
+        stepper.dxdt_init = false;
+        double ll = 0;
+        for (size_t k = 0; k <= counts.last_step; k++) {
+            ll += counts.loglik(k, x, model, phi);
+            if (! std::isfinite(ll)) return arma::datum::inf;
+            if (k == counts.last_step) break;
+            stepper.do_step(std::ref(model), x,
+                            0.0 + static_cast<double>(k) * dt, dt);
+            if (! ticker.tick()) return arma::datum::nan;
+        }
+        return -ll;
+    }
+
+    void flush() {
+        ticker.flush();
+        return;
+    }
+
+private:
+    M& model;
+    const SurveyCounts& counts;
+    std::vector<size_t> pars;
+    bool dir_mult;
+    double dt;
+    Progress& progress;
+    ProgressTicker ticker;
+    CheckpointStepper stepper;
+    MatType x;
+};
+
+
+
+
+// Constant-F landscape (see `LandscapeConstF`) for fitting:
+class ConstFFitModel : public LandscapeConstF
+{
+public:
+
+    const std::vector<std::string> par_names = {"m", "d_yp", "d_b0", "d_bp",
+                                                "g_yp", "g_b0", "g_bp", "L_0",
+                                                "u", "X"};
+    MatType x0;
+
+    ConstFFitModel(const std::vector<double>& m_,
+                   const std::vector<double>& d_yp_,
+                   const std::vector<double>& d_b0_,
+                   const std::vector<double>& d_bp_,
+                   const std::vector<double>& g_yp_,
+                   const std::vector<double>& g_b0_,
+                   const std::vector<double>& g_bp_,
+                   const std::vector<double>& L_0_,
+                   const double& u_,
+                   const double& X_,
+                   const std::vector<double>& Y0,
+                   const std::vector<double>& B0)
+        : LandscapeConstF(m_, d_yp_, d_b0_, d_bp_, g_yp_, g_b0_, g_bp_, L_0_,
+                          u_, X_),
+          x0(m_.size(), 2U),
+          start({m_, d_yp_, d_b0_, d_bp_, g_yp_, g_b0_, g_bp_, L_0_, {u_},
+                 {X_}}) {
+        for (size_t i = 0; i < n_plants; i++) {
+            x0(i,0) = Y0[i];
+            x0(i,1) = B0[i];
+        }
+    };
+
+    void set(const size_t& k, const double& scale) {
+        std::vector<double>* target = nullptr;
+        switch (k) {
+        case 0U: target = &m; break;
+        case 1U: target = &d_yp; break;
+        case 2U: target = &d_b0; break;
+        case 3U: target = &d_bp; break;
+        case 4U: target = &g_yp; break;
+        case 5U: target = &g_b0; break;
+        case 6U: target = &g_bp; break;
+        case 7U: target = &L_0; break;
+        case 8U: u = start[k].front() * scale; return;
+        case 9U: X = start[k].front() * scale; return;
+        default: return;
+        }
+        for (size_t i = 0; i < n_plants; i++) {
+            (*target)[i] = start[k][i] * scale;
+        }
+        return;
+    }
+
+    bool can_scale(const size_t& k) const {
+        return *std::max_element(start[k].begin(), start[k].end()) > 0;
+    }
+
+    std::vector<double> values(const size_t& k) const {
+        switch (k) {
+        case 0U: return m;
+        case 1U: return d_yp;
+        case 2U: return d_b0;
+        case 3U: return d_bp;
+        case 4U: return g_yp;
+        case 5U: return g_b0;
+        case 6U: return g_bp;
+        case 7U: return L_0;
+        case 8U: return std::vector<double>(n_plants, u);
+        default: return std::vector<double>(n_plants, X);
+        }
+    }
+
+    void props(const MatType& x, const size_t& i, double& Y, double& B) const {
+        Y = x(i,0);
+        B = x(i,1);
+        return;
+    }
+
+private:
+    std::vector<std::vector<double>> start;
+};
+
+
+
+// Non-seasonal landscape (see `NonSeasonalLandscape`) for fitting:
+class LandscapeFitModel : public NonSeasonalLandscape
+{
+public:
+
+    const std::vector<std::string> par_names = {"m", "R", "d_yp", "d_b0",
+                                                "d_bp", "g_yp", "g_b0",
+                                                "g_bp", "L_0", "P_max", "u",
+                                                "q", "W", "w"};
+    MatType x0;
+
+    LandscapeFitModel(const std::vector<double>& m_,
+                      const std::vector<double>& d_yp_,
+                      const std::vector<double>& d_b0_,
+                      const std::vector<double>& d_bp_,
+                      const std::vector<double>& g_yp_,
+                      const std::vector<double>& g_b0_,
+                      const std::vector<double>& g_bp_,
+                      const std::vector<double>& L_0_,
+                      const std::vector<double>& P_max_,
+                      const double& u_,
+                      const double& q_,
+                      const std::vector<double>& W_,
+                      const double& w_,
+                      const arma::mat& z_,
+                      const double& min_F_for_P_,
+                      const std::vector<double>& R_,
+                      const std::vector<double>& Y0,
+                      const std::vector<double>& B0,
+                      const std::vector<double>& N0)
+        : NonSeasonalLandscape(m_, d_yp_, d_b0_, d_bp_, g_yp_, g_b0_, g_bp_,
+                               L_0_, P_max_, u_, q_, W_, w_, z_, min_F_for_P_,
+                               R_),
+          x0(z_.n_rows, 3U),
+          start(),
+          z(z_),
+          w(w_) {
+        for (size_t i = 0; i < n_plants; i++) {
+            x0(i,0) = Y0[i];
+            x0(i,1) = B0[i];
+            x0(i,2) = N0[i];
+        }
+        start = {m, R, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max,
+                 arma::vec(1U).fill(u), arma::vec(1U).fill(q), W,
+                 arma::vec(1U).fill(w_)};
+    };
+
+    void set(const size_t& k, const double& scale) {
+        arma::vec* target = nullptr;
+        switch (k) {
+        case 0U: target = &m; break;
+        case 1U: target = &R; break;
+        case 2U: target = &d_yp; break;
+        case 3U: target = &d_b0; break;
+        case 4U: target = &d_bp; break;
+        case 5U: target = &g_yp; break;
+        case 6U: target = &g_b0; break;
+        case 7U: target = &g_bp; break;
+        case 8U: target = &L_0; break;
+        case 9U: target = &P_max; break;
+        case 10U: u = start[k](0) * scale; return;
+        case 11U: q = start[k](0) * scale; return;
+        case 12U: target = &W; break;
+        case 13U: set_w__(start[k](0) * scale); return;
+        default: return;
+        }
+        *target = start[k] * scale;
+        return;
+    }
+
+    bool can_scale(const size_t& k) const {
+        return start[k].max() > 0;
+    }
+
+    std::vector<double> values(const size_t& k) const {
+        switch (k) {
+        case 0U: return arma::conv_to<std::vector<double>>::from(m);
+        case 1U: return arma::conv_to<std::vector<double>>::from(R);
+        case 2U: return arma::conv_to<std::vector<double>>::from(d_yp);
+        case 3U: return arma::conv_to<std::vector<double>>::from(d_b0);
+        case 4U: return arma::conv_to<std::vector<double>>::from(d_bp);
+        case 5U: return arma::conv_to<std::vector<double>>::from(g_yp);
+        case 6U: return arma::conv_to<std::vector<double>>::from(g_b0);
+        case 7U: return arma::conv_to<std::vector<double>>::from(g_bp);
+        case 8U: return arma::conv_to<std::vector<double>>::from(L_0);
+        case 9U: return arma::conv_to<std::vector<double>>::from(P_max);
+        case 10U: return std::vector<double>(n_plants, u);
+        case 11U: return std::vector<double>(n_plants, q);
+        case 12U: return arma::conv_to<std::vector<double>>::from(W);
+        default: return std::vector<double>(n_plants, w);
+        }
+    }
+
+    void props(const MatType& x, const size_t& i, double& Y, double& B) const {
+        double F = x(i,0) + x(i,1) + x(i,2);
+        Y = F > 0 ? x(i,0) / F : 0;
+        B = F > 0 ? x(i,1) / F : 0;
+        return;
+    }
+
+private:
+    std::vector<arma::vec> start;
+    arma::mat z;
+    double w;
+
+    // Only re-make the dispersal matrix when `w` changes:
+    void set_w__(const double& w_) {
+        if (w_ == w) return;
+        w = w_;
+        arma::mat Phi_(n_plants, n_plants);
+        fill_Phi__(Phi_, w, z);
+        Phi = std::make_shared<const arma::mat>(std::move(Phi_));
+        return;
+    }
+};
+
+
+
+
+/*
+ Fit `model` to `obs` (see `SurveyCounts`) and return one row per plant
+ with the fitted values of each parameter in `fit_pars`, with the
+ log-likelihood, number of evaluations, whether it converged, and
+ (for Dirichlet-multinomial fits) `phi` as attributes.
+ With `max_evals` of 0 or 1, this just returns the log-likelihood at the
+ starting values.
+ */
+template< class M >
+inline NumericMatrix fit_surveys(M& model,
+                                 const NumericMatrix& obs,
+                                 const std::vector<std::string>& fit_pars,
+                                 const std::string& family,
+                                 const double& phi,
+                                 const double& dt,
+                                 const uint32_t& max_evals,
+                                 const double& tol,
+                                 const bool& show_progress) {
+
+    bool err = false;
+    SurveyCounts counts(obs, model.n_plants, dt, err);
+    std::vector<size_t> pars;
+    for (const std::string& p : fit_pars) {
+        size_t k = 0;
+        while (k < model.par_names.size() && model.par_names[k] != p) k++;
+        if (k == model.par_names.size()) {
+            Rcout << p << " is not a parameter that can be fitted! ";
+            Rcout << "They should be one of ";
+            for (size_t j = 0; j < model.par_names.size(); j++) {
+                Rcout << model.par_names[j];
+                Rcout << (j + 1U < model.par_names.size() ? ", " : "!");
+            }
+            Rcout << std::endl;
+            err = true;
+        } else if (! model.can_scale(k)) {
+            Rcout << "Starting values for " << p << " should include one ";
+            Rcout << "above zero for it to be fitted!" << std::endl;
+            err = true;
+        } else pars.push_back(k);
+    }
+    if (family != "multinomial" && family != "dirmultinomial") {
+        Rcout << "family must be \"multinomial\" or \"dirmultinomial\"!";
+        Rcout << std::endl;
+        err = true;
+    }
+    bool dir_mult = family == "dirmultinomial";
+    if (dir_mult) min_val_check(err, phi, "phi", 0, false);
+    min_val_check(err, tol, "tol", 0, false);
+    if (err) return NumericMatrix(0,0);
+
+    Progress progress(1U, std::max(max_evals, 1U) * counts.last_step,
+                      show_progress);
+    SurveyFit<M> nll(model, counts, pars, dir_mult, dt, progress);
+    arma::vec eta(nll.n_eta(), arma::fill::zeros);
+    if (dir_mult) eta(eta.n_elem - 1U) = std::log(phi);
+    double f_min;
+    size_t n_evals;
+    // Steps are on the log scale, so this starts by changing values by 50%:
+    bool converged = nelder_mead(std::ref(nll), eta, f_min, std::log(1.5),
+                                 max_evals, tol, n_evals,
+                                 [&progress]() { return progress.cancelled(); });
+    nll.flush();
+    if (! progress.finish()) return NumericMatrix(0,0);
+    // Leave the model at the best values:
+    nll(eta);
+
+    NumericMatrix output(model.n_plants, 1U + pars.size());
+    CharacterVector cn = CharacterVector::create("p");
+    for (const size_t& k : pars) cn.push_back(model.par_names[k]);
+    colnames(output) = cn;
+    for (size_t j = 0; j < pars.size(); j++) {
+        std::vector<double> v = model.values(pars[j]);
+        for (size_t i = 0; i < model.n_plants; i++) output(i,j+1U) = v[i];
+    }
+    for (size_t i = 0; i < model.n_plants; i++) output(i,0) = i;
+    output.attr("loglik") = -f_min;
+    output.attr("n_evals") = static_cast<double>(n_evals);
+    output.attr("converged") = converged;
+    if (dir_mult) output.attr("phi") = std::exp(eta(eta.n_elem - 1U));
+
+    return output;
+}
+
+
+
+
+#endif
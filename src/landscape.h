@@ -4,6 +4,7 @@
 
 #include <RcppArmadillo.h>
 #include <vector>
+#include <memory>
 
 #include "ode.h"
 
@@ -96,9 +97,16 @@ public:
     double u;
     double q;
     arma::vec W;
-    arma::mat Phi;
+    /*
+     Dispersal matrix, stored in either double (`Phi`) or single (`Phi_f`)
+     precision. It never changes after construction, so copies of a system
+     (e.g., one per thread) share the same one.
+     */
+    std::shared_ptr<const arma::mat> Phi;
+    std::shared_ptr<const arma::fmat> Phi_f;
     size_t n_plants;
     double min_F_for_P;
+    bool single_prec;
 
 
 
@@ -116,7 +124,9 @@ public:
                             const std::vector<double>& W_,
                             const double& w_,
                             const arma::mat& z_,
-                            const double& min_F_for_P_)
+                            const double& min_F_for_P_,
+                            const bool& single_prec_ = false,
+                            const LandscapeSystemFunction* Phi_from = nullptr)
         : m(arma::conv_to<arma::vec>::from(m_)),
           d_yp(arma::conv_to<arma::vec>::from(d_yp_)),
           d_b0(arma::conv_to<arma::vec>::from(d_b0_)),
@@ -129,13 +139,33 @@ public:
           u(u_),
           q(q_),
           W(arma::conv_to<arma::vec>::from(W_)),
-          Phi(z_.n_rows, z_.n_cols),
+          Phi(),
+          Phi_f(),
           n_plants(z_.n_rows),
           min_F_for_P(min_F_for_P_),
+          single_prec(single_prec_),
           weights(z_.n_rows),
+          weights_t(arma::datum::nan),
           F(z_.n_rows),
-          R(z_.n_rows) {
-        fill_Phi__(w_, z_);
+          R(z_.n_rows),
+          growth_y(z_.n_rows),
+          growth_b(z_.n_rows) {
+        /*
+         Systems with the same `w`, `z`, and precision (e.g., in parameter
+         sweeps) can share one dispersal matrix:
+         */
+        if (Phi_from != nullptr) {
+            Phi = Phi_from->Phi;
+            Phi_f = Phi_from->Phi_f;
+            return;
+        }
+        arma::mat Phi_(n_plants, n_plants);
+        fill_Phi__(Phi_, w_, z_);
+        // Only keep the single-precision version if requested:
+        if (single_prec) {
+            Phi_f = std::make_shared<const arma::fmat>(
+                arma::conv_to<arma::fmat>::from(Phi_));
+        } else Phi = std::make_shared<const arma::mat>(std::move(Phi_));
     };
 
 
@@ -173,14 +203,46 @@ public:
 
     }
 
+    // For use in `ObserverP`:
+    bool P_at(const double& t) const {
+        return same_time(t, weights_t);
+    }
+    void last_P(arma::vec& P) const {
+        P = P_max % weights;
+        return;
+    }
+    void make_P(arma::vec& P, const MatType& x) {
+        make_weights(P, x);
+        P %= P_max;
+        return;
+    }
+
+    // For checkpoints (see checkpoint.h):
+    template< class W >
+    void save(W& w) const {
+        w.write(weights);
+        w.write(weights_t);
+        return;
+    }
+    template< class R >
+    void load(R& r) {
+        r.read(weights);
+        r.read(weights_t);
+        return;
+    }
+
 
 
 protected:
 
 
     arma::vec weights;
+    // Time at which `weights` were last calculated inside the RHS:
+    double weights_t;
     arma::vec F;
     arma::vec R;
+    arma::vec growth_y;
+    arma::vec growth_b;
 
     /*
       Everything but calculating R, which differs by derived class.
@@ -193,6 +255,8 @@ protected:
         const arma::vec B(x.unsafe_col(1));
         const arma::vec N(x.unsafe_col(2));
 
+        weights_t = t;
+
         arma::vec dYdt = dxdt.unsafe_col(0);
         arma::vec dBdt = dxdt.unsafe_col(1);
         arma::vec dNdt = dxdt.unsafe_col(2);
@@ -221,8 +285,10 @@ protected:
         arma::vec delta_y = d_yp % Lambda;
         arma::vec delta_b = d_b0 + d_bp % Lambda;
 
-        arma::vec growth_y = (Phi * (delta_y % YF + gamma_y)) % N;
-        arma::vec growth_b = (Phi * (delta_b % BF + gamma_b)) % N;
+        Phi_times(delta_y % YF + gamma_y, growth_y);
+        Phi_times(delta_b % BF + gamma_b, growth_b);
+        growth_y %= N;
+        growth_b %= N;
 
         dYdt = growth_y - m % Y;
         dBdt = growth_b - m % B;
@@ -231,24 +297,44 @@ protected:
         return;
     }
 
+    /*
+     Phi * v, where Phi can be stored in single precision.
+     For the single-precision version, products are still accumulated in
+     double precision. Going column-wise keeps it a single pass through Phi.
+     */
+    void Phi_times(const arma::vec& v, arma::vec& out) const {
+        if (! single_prec) {
+            out = (*Phi) * v;
+            return;
+        }
+        if (out.n_elem != n_plants) out.set_size(n_plants);
+        out.zeros();
+        for (size_t j = 0; j < n_plants; j++) {
+            const float* Phi_j = Phi_f->colptr(j);
+            const double& v_j(v(j));
+            for (size_t i = 0; i < n_plants; i++) {
+                out(i) += static_cast<double>(Phi_j[i]) * v_j;
+            }
+        }
+        return;
+    }
+
     // fill Phi matrix.
     // `z` should be n_plants x n_plants in size
-    void fill_Phi__(const double& w_, const arma::mat& z_) {
-
-        Phi.set_size(n_plants, n_plants);
+    void fill_Phi__(arma::mat& Phi_, const double& w_, const arma::mat& z_) {
 
         double col_sum;
         for (size_t j = 0; j < n_plants; j++) {
             col_sum = 0;
             for (size_t i = 0; i < n_plants; i++) {
                 if (i == j) {
-                    Phi(i,j) = 1;
+                    Phi_(i,j) = 1;
                 } else {
-                    Phi(i,j) = std::exp(-w_ * z_(i, j));
+                    Phi_(i,j) = std::exp(-w_ * z_(i, j));
                 }
-                col_sum += Phi(i,j);
+                col_sum += Phi_(i,j);
             }
-            for (size_t i = 0; i < n_plants; i++) Phi(i,j) /= col_sum;
+            for (size_t i = 0; i < n_plants; i++) Phi_(i,j) /= col_sum;
         }
 
     }
@@ -260,6 +346,88 @@ protected:
 
 
 
+class NonSeasonalLandscape : public LandscapeSystemFunction
+{
+public:
+
+    NonSeasonalLandscape(const std::vector<double>& m_,
+                         const std::vector<double>& d_yp_,
+                         const std::vector<double>& d_b0_,
+                         const std::vector<double>& d_bp_,
+                         const std::vector<double>& g_yp_,
+                         const std::vector<double>& g_b0_,
+                         const std::vector<double>& g_bp_,
+                         const std::vector<double>& L_0_,
+                         const std::vector<double>& P_max_,
+                         const double& u_,
+                         const double& q_,
+                         const std::vector<double>& W_,
+                         const double& w_,
+                         const arma::mat& z_,
+                         const double& min_F_for_P_,
+                         const std::vector<double>& R_,
+                         const bool& single_prec_ = false,
+                         const LandscapeSystemFunction* Phi_from = nullptr)
+        : LandscapeSystemFunction(m_, d_yp_, d_b0_, d_bp_, g_yp_, g_b0_, g_bp_,
+                                  L_0_, P_max_, u_, q_, W_, w_, z_,
+                                  min_F_for_P_, single_prec_, Phi_from) {
+
+        this->R = arma::conv_to<arma::vec>::from(R_);
+
+    };
+
+
+    void operator()(const MatType& x,
+                    MatType& dxdt,
+                    const double t) {
+
+        LandscapeSystemFunction::make_weights(this->weights, x);
+        LandscapeSystemFunction::all_but_R(x, dxdt, t);
+        return;
+
+    }
+
+    void make_weights(arma::vec& wts_vec,
+                      const MatType& x) {
+        LandscapeSystemFunction::make_weights(wts_vec, x);
+    }
+
+};
+
+
+
+
+
+/*
+ Create output matrix from observer for either landscape system
+ (`S` is the type states were stored as).
+ */
+template< class S, class L >
+inline NumericMatrix landscape_output(ObserverP<L, S>& obs) {
+
+    obs.finish();
+
+    size_t np = obs.P.empty() ? 0U : obs.P.front().n_elem;
+    size_t n_steps = obs.data.size();
+    NumericMatrix output(n_steps * np, 6);
+    colnames(output) = CharacterVector::create("t", "p", "Y", "B", "N", "P");
+    size_t i = 0;
+    for (size_t t = 0; t < n_steps; t++) {
+        const S& x(obs.data[t]);
+        for (size_t k = 0; k < np; k++) {
+            output(i,0) = obs.time[t];
+            output(i,1) = k;
+            output(i,2) = x(k, 0);
+            output(i,3) = x(k, 1);
+            output(i,4) = x(k, 2);
+            output(i,5) = obs.P[t](k);
+            i++;
+        }
+
+    }
+    return output;
+}
+
 
 
 #endif
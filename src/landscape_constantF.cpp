@@ -11,12 +11,44 @@
 
 #include "ode.h"
 #include "landscape_constantF.h"
+#include "outcomes.h"
+#include "checkpoint.h"
 
 using namespace Rcpp;
 
 
 
 
+// `S` is the type states were stored as
+template< class S >
+NumericMatrix landscape_constF_output(ObserverP<LandscapeConstF, S>& obs) {
+
+    obs.finish();
+
+    size_t np = obs.P.empty() ? 0U : obs.P.front().n_elem;
+    size_t n_states = 2U;
+    size_t n_steps = obs.data.size();
+    NumericMatrix output(n_steps * np, n_states+3U);
+    colnames(output) = CharacterVector::create("t", "p", "Y", "B", "P");
+    size_t i = 0;
+    for (size_t t = 0; t < n_steps; t++) {
+        const S& x(obs.data[t]);
+        for (size_t k = 0; k < np; k++) {
+            output(i,0) = obs.time[t];
+            output(i,1) = k;
+            for (size_t j = 0; j < n_states; j++) {
+                output(i,j+2U) = x(k,j);
+            }
+            output(i, n_states+2U) = obs.P[t](k);
+            i++;
+        }
+
+    }
+    return output;
+}
+
+
+
 //' @export
 // [[Rcpp::export]]
 NumericMatrix landscape_constantF_ode(const std::vector<double>& m,
@@ -32,7 +64,13 @@ NumericMatrix landscape_constantF_ode(const std::vector<double>& m,
                                       const std::vector<double>& Y0,
                                       const std::vector<double>& B0,
                                       const double& dt = 0.1,
-                                      const double& max_t = 90.0) {
+                                      const double& max_t = 90.0,
+                                      const bool& single_prec = false,
+                                      const bool& outcomes_only = false,
+                                      const double& threshold = 1e-6,
+                                      const double& outcome_window = 0,
+                                      const bool& by_plant = false,
+                                      const bool& show_progress = false) {
 
     size_t np = m.size();
     /*
@@ -41,6 +79,7 @@ NumericMatrix landscape_constantF_ode(const std::vector<double>& m,
      */
     bool err = lanscape_constF_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
                                           L_0, u, X, Y0, B0, dt, max_t);
+    outcome_arg_checks(err, threshold, outcome_window);
     if (err) return NumericMatrix(0,0);
 
     size_t n_states = 2U;
@@ -51,30 +90,30 @@ NumericMatrix landscape_constantF_ode(const std::vector<double>& m,
     }
 
 
-    Observer<MatType> obs;
     LandscapeConstF system(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X);
 
-    boost::numeric::odeint::integrate_const(
-        MatStepperType(), std::ref(system),
-        x, 0.0, max_t, dt, std::ref(obs));
+    if (outcomes_only) {
+        OutcomeTracker tracker(np, threshold, max_t - outcome_window);
+        if (! integrate_interruptible(system, x, dt, max_t, tracker,
+                                      show_progress)) {
+            return NumericMatrix(0,0);
+        }
+        return outcome_output(tracker, by_plant);
+    }
 
-    size_t n_steps = obs.data.size();
-    NumericMatrix output(n_steps * np, n_states+3U);
-    colnames(output) = CharacterVector::create("t", "p", "Y", "B", "P");
-    std::vector<double> wts(np);
-    size_t i = 0;
-    for (size_t t = 0; t < n_steps; t++) {
-        system.make_weights(wts, obs.data[t]);
-        for (size_t k = 0; k < np; k++) {
-            output(i,0) = obs.time[t];
-            output(i,1) = k;
-            for (size_t j = 0; j < n_states; j++) {
-                output(i,j+2U) = obs.data[t](k,j);
-            }
-            output(i, n_states+2U) = wts[k];
-            i++;
+    if (single_prec) {
+        ObserverP<LandscapeConstF, arma::fmat> obs(system);
+        if (! integrate_interruptible(system, x, dt, max_t, obs,
+                                      show_progress)) {
+            return NumericMatrix(0,0);
         }
+        return landscape_constF_output(obs);
+    }
 
+    ObserverP<LandscapeConstF> obs(system);
+    if (! integrate_interruptible(system, x, dt, max_t, obs, show_progress)) {
+        return NumericMatrix(0,0);
     }
-    return output;
+
+    return landscape_constF_output(obs);
 }
@@ -115,7 +115,8 @@ public:
           u(u_),
           X(X_),
           n_plants(m_.size()),
-          weights(m_.size()) {};
+          weights(m_.size()),
+          weights_t(arma::datum::nan) {};
 
 
     LandscapeConstF(const LandscapeConstF& other)
@@ -130,7 +131,8 @@ public:
           u(other.u),
           X(other.X),
           n_plants(other.n_plants),
-          weights(other.weights) {};
+          weights(other.weights),
+          weights_t(other.weights_t) {};
 
     LandscapeConstF& operator=(const LandscapeConstF& other) {
         m = other.m;
@@ -145,6 +147,7 @@ public:
         X = other.X;
         n_plants = other.n_plants;
         weights = other.weights;
+        weights_t = other.weights_t;
         return *this;
     }
 
@@ -153,6 +156,7 @@ public:
                     MatType& dxdt) {
 
         make_weights(this->weights, x);
+        weights_t = arma::datum::nan;
 
         for (size_t i = 0; i < n_plants; i++) {
             one_plant(i, x, dxdt);
@@ -165,6 +169,7 @@ public:
                   MatType& dxdt,
                   const double& t) {
         this->operator()(x, dxdt);
+        weights_t = t;
         return;
     }
 
@@ -187,11 +192,42 @@ public:
         return;
     }
 
+    // For use in `ObserverP`:
+    bool P_at(const double& t) const {
+        return same_time(t, weights_t);
+    }
+    void last_P(arma::vec& P) const {
+        P = arma::conv_to<arma::vec>::from(weights);
+        return;
+    }
+    void make_P(arma::vec& P, const MatType& x) {
+        make_weights(P_tmp, x);
+        P = arma::conv_to<arma::vec>::from(P_tmp);
+        return;
+    }
+
+    // For checkpoints (see checkpoint.h):
+    template< class W >
+    void save(W& w) const {
+        w.write(weights);
+        w.write(weights_t);
+        return;
+    }
+    template< class R >
+    void load(R& r) {
+        r.read(weights);
+        r.read(weights_t);
+        return;
+    }
+
 
 
 private:
 
     std::vector<double> weights;
+    // Time at which `weights` were last calculated inside the RHS:
+    double weights_t;
+    std::vector<double> P_tmp;
 
    void one_plant(const size_t& i,
                    const MatType& x,
@@ -13,14 +13,25 @@
 #include <RcppArmadillo.h>
 #include <vector>
 #include <cmath>
-#include <random>
+#include <memory>
+#include <array>
+#include <algorithm>
 
 #include "ode.h"
 #include "landscape_constantF.h"
+#include "outcomes.h"
+#include "checkpoint.h"
 
 #include <RcppParallel.h>
 #include <pcg_random.hpp>
 
+#include "rng.h"
+#include "spatial_noise.h"
+#include "scheduler.h"
+#include "sweep.h"
+#include "ensemble.h"
+#include "community.h"
+
 
 using namespace Rcpp;
 
@@ -85,15 +96,15 @@ public:
 
                 x.elem( arma::find(x < 1) ) += 1e-6; // to remove zeros
 
-                pcg32& rng(system.second.m_rng);
-                std::normal_distribution<double>& norm(system.second.m_dist);
+                // Draw all perturbations at once:
+                system.second.normals(stoch);
                 double YB, xij;
                 for (size_t i = 0 ; i < x.n_rows ; i++) {
                     YB = arma::accu(x.row(i)); // Y+B for this plant
                     for (size_t j = 0 ; j < x.n_cols ; j++) {
                         xij = x(i,j) / YB;
                         logit(xij);
-                        xij += (season_sigma * norm(rng));
+                        xij += (season_sigma * stoch(i,j));
                         inv_logit(xij);
                         x(i,j) = xij;
                     }
@@ -105,7 +116,7 @@ public:
             return;
         }
         // Standard iteration:
-        system.first(x, det);
+        system.first(x, det, t);
         system.second(x, stoch);
         double sqrt_dt = std::sqrt(dt);
         for (size_t i = 0 ; i < x.n_rows ; i++) {
@@ -135,23 +146,41 @@ private:
 struct StochLandscapeStochProcess
 {
     pcg32& m_rng;
-    std::normal_distribution<double> m_dist;
     double n_sigma;
+    const SpatialNoise& noise;
+    MatType& work;
+    // Whether to negate all normals (for the second rep in antithetic pairs):
+    bool negate;
 
     StochLandscapeStochProcess(pcg32& rng,
-                               double n_sigma_)
+                               double n_sigma_,
+                               const SpatialNoise& noise_,
+                               MatType& work_,
+                               const bool& negate_ = false)
         : m_rng(rng),
-          m_dist(0.0, 1.0),
-          n_sigma(n_sigma_) {}
+          n_sigma(n_sigma_),
+          noise(noise_),
+          work(work_),
+          negate(negate_) {}
+
+    // Standard normals (possibly correlated among plants) for all of `z`:
+    void normals(MatType& z) {
+        noise.fill(z, m_rng, work);
+        if (negate) z *= -1.0;
+        return;
+    }
 
     void operator()(const MatType &x, MatType &dxdt) {
 
+        // Standard normals for the whole landscape, then scaled below:
+        normals(dxdt);
+
         double stdev;
 
         for (size_t i = 0 ; i < x.n_rows ; i++) {
             for (size_t j = 0 ; j < x.n_cols ; j++) {
                 stdev = std::sqrt(x(i,j) * (1 - x(i,j)) / n_sigma);
-                dxdt(i,j) = stdev * m_dist(m_rng);
+                dxdt(i,j) *= stdev;
             }
         }
 
@@ -164,8 +193,28 @@ struct StochLandscapeStochProcess
 // RcppParallel Worker to do runs for a single thread:
 struct StochLandCFWorker : public RcppParallel::Worker {
 
+    /*
+     Y, B, and P for each rep (rows are plants within time points), stored
+     either in double (`output`) or single (`output_f`) precision.
+     The matching rep, time, and plant columns are filled in afterwards.
+     */
     std::vector<MatType> output;
-    std::vector<std::vector<uint64_t>> seeds;
+    std::vector<arma::fmat> output_f;
+    std::vector<std::vector<double>> times;
+    // Used instead of the above when only outcomes are returned:
+    std::vector<OutcomeTracker> outcomes;
+    /*
+     Used instead of all the above when only summaries across reps are
+     returned (set after construction; see ensemble.h):
+     */
+    AccumulatorPool* summaries;
+    // Each rep's RNG is seeded from this and its index (see rng.h):
+    uint64_t master_seed;
+    /*
+     If true, reps are in antithetic pairs (0 and 1, 2 and 3, ...) that
+     use the same RNG stream, but with all normals negated for the second.
+     */
+    bool antithetic;
     MatType x0;
     LandscapeConstF determ_sys0;
     double n_sigma;
@@ -174,6 +223,24 @@ struct StochLandCFWorker : public RcppParallel::Worker {
     double season_len;
     double season_surv;
     double season_sigma;
+    // Factored correlations among plants (shared by all threads):
+    SpatialNoise noise;
+    bool single_prec;
+    bool outcomes_only;
+    bool by_plant;
+    /*
+     Each rep is checkpointed to its own file (`<checkpoint_file>.<rep>`)
+     so threads never write to the same file.
+     Reasons why a checkpoint couldn't be read or written (or "" if it worked)
+     are stored in `checkpoint_status`.
+     */
+    std::string checkpoint_file;
+    size_t checkpoint_steps;
+    bool resume;
+    uint64_t hash;
+    std::vector<std::string> checkpoint_status;
+    // Shared progress counters and cancellation flag:
+    Progress& progress;
 
     StochLandCFWorker(const uint32_t& n_reps,
                       const std::vector<double>& m,
@@ -192,10 +259,31 @@ struct StochLandCFWorker : public RcppParallel::Worker {
                       const double& season_len_,
                       const double& season_surv_,
                       const double& season_sigma_,
+                      const uint64_t& master_seed_,
+                      const bool& antithetic_,
+                      const SpatialNoise& noise_,
                       const double& dt_,
-                      const double& max_t_)
-        : output(n_reps, MatType(0,0)),
-          seeds(n_reps, std::vector<uint64_t>(2)),
+                      const double& max_t_,
+                      const bool& single_prec_,
+                      const bool& outcomes_only_,
+                      const double& threshold,
+                      const double& outcome_window,
+                      const bool& by_plant_,
+                      const std::string& checkpoint_file_,
+                      const size_t& checkpoint_steps_,
+                      const bool& resume_,
+                      const uint64_t& hash_,
+                      Progress& progress_)
+        : output((single_prec_ || outcomes_only_ ? 0U : n_reps), MatType(0,0)),
+          output_f((single_prec_ && ! outcomes_only_ ? n_reps : 0U),
+                   arma::fmat(0,0)),
+          times(outcomes_only_ ? 0U : n_reps),
+          outcomes((outcomes_only_ ? n_reps : 0U),
+                   OutcomeTracker(m.size(), threshold,
+                                  max_t_ - outcome_window)),
+          summaries(nullptr),
+          master_seed(master_seed_),
+          antithetic(antithetic_),
           x0(m.size(), 2U),
           determ_sys0(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X),
           n_sigma(n_sigma_),
@@ -203,16 +291,17 @@ struct StochLandCFWorker : public RcppParallel::Worker {
           max_t(max_t_),
           season_len(season_len_),
           season_surv(season_surv_),
-          season_sigma(season_sigma_) {
-
-        std::vector<uint64_t> tmp_seeds(4);
-        for (uint32_t i = 0; i < n_reps; i++) {
-            // These are 32-bit integers cast as 64-bit for downstream compatibility
-            tmp_seeds = as<std::vector<uint64_t>>(Rcpp::runif(4,0,4294967296));
-            // Converting to two 64-bit seeds for pcg32
-            seeds[i][0] = (tmp_seeds[0]<<32) + tmp_seeds[1];
-            seeds[i][1] = (tmp_seeds[2]<<32) + tmp_seeds[3];
-        }
+          season_sigma(season_sigma_),
+          noise(noise_),
+          single_prec(single_prec_),
+          outcomes_only(outcomes_only_),
+          by_plant(by_plant_),
+          checkpoint_file(checkpoint_file_),
+          checkpoint_steps(checkpoint_steps_),
+          resume(resume_),
+          hash(hash_),
+          checkpoint_status(n_reps),
+          progress(progress_) {
 
         for (size_t i = 0; i < x0.n_rows; i++) {
             x0(i,0) = Y0[i];
@@ -222,41 +311,58 @@ struct StochLandCFWorker : public RcppParallel::Worker {
     };
 
     void operator()(size_t begin, size_t end) {
+        if (summaries != nullptr) {
+            do_summary_reps(begin, end);
+        } else if (outcomes_only) {
+            do_outcome_reps(begin, end);
+        } else if (single_prec) {
+            do_reps(begin, end, output_f);
+        } else do_reps(begin, end, output);
+        return;
+    }
+
+
+    // Fill final output from stored reps:
+    void fill_output(NumericMatrix& out) const {
+        if (outcomes_only) {
+            fill_outcomes__(out);
+        } else if (single_prec) {
+            fill_output__(out, output_f);
+        } else fill_output__(out, output);
+        return;
+    }
+
+
+private:
+
+    // `S` is the type Y, B, and P are stored as for each rep
+    template< class S >
+    void do_reps(size_t begin, size_t end, std::vector<S>& out) {
 
         pcg32 rng;
         const size_t& np(determ_sys0.n_plants);
         MatType x;
-        Observer<MatType> obs;
-        std::vector<double> wts(np);
+        // Copy for this thread so the observer can use its weights:
+        LandscapeConstF determ_sys(determ_sys0);
+        ObserverP<LandscapeConstF, S> obs(determ_sys);
 
         for (size_t rep = begin; rep < end; rep++) {
 
-            rng.seed(seeds[rep][0], seeds[rep][1]);
-
-            x = x0;
-            obs.data.clear();
-            obs.time.clear();
-
-            boost::numeric::odeint::integrate_const(
-                StochLandscapeStepper(np, 2U, season_len, season_surv, season_sigma),
-                std::make_pair(determ_sys0,
-                               StochLandscapeStochProcess(rng, n_sigma)),
-                               x, 0.0, max_t, dt, std::ref(obs));
+            if (progress.cancelled()) break;
+            obs.clear();
+            if (! run_rep__(rep, rng, x, determ_sys, obs)) continue;
+            obs.finish();
 
             size_t n_steps = obs.data.size();
-            output[rep].set_size(n_steps * np, 6U);
-            // colnames(output[rep]) = CharacterVector::create("rep", "t", "p", "Y", "B", "P");
+            out[rep].set_size(n_steps * np, 3U);
+            times[rep] = obs.time;
             size_t i = 0;
-            double dbl_rep = static_cast<double>(rep) + 1;
             for (size_t t = 0; t < n_steps; t++) {
-                determ_sys0.make_weights(wts, obs.data[t]);
+                const S& x_t(obs.data[t]);
                 for (size_t k = 0; k < np; k++) {
-                    output[rep](i,0) = dbl_rep;
-                    output[rep](i,1) = obs.time[t];
-                    output[rep](i,2) = k;
-                    output[rep](i,3) = obs.data[t](k,0);
-                    output[rep](i,4) = obs.data[t](k,1);
-                    output[rep](i,5) = wts[k];
+                    out[rep](i,0) = x_t(k,0);
+                    out[rep](i,1) = x_t(k,1);
+                    out[rep](i,2) = obs.P[t](k);
                     i++;
                 }
 
@@ -265,11 +371,228 @@ struct StochLandCFWorker : public RcppParallel::Worker {
         }
         return;
     }
+
+    // Same as above, but only adding to summaries across reps:
+    void do_summary_reps(size_t begin, size_t end) {
+
+        pcg32 rng;
+        const size_t& np(determ_sys0.n_plants);
+        MatType x;
+        LandscapeConstF determ_sys(determ_sys0);
+        ObserverP<LandscapeConstF> obs(determ_sys);
+        EnsembleAccumulator* acc = summaries->checkout();
+
+        for (size_t rep = begin; rep < end; rep++) {
+
+            if (progress.cancelled()) break;
+            obs.clear();
+            if (! run_rep__(rep, rng, x, determ_sys, obs)) continue;
+            obs.finish();
+
+            size_t n_steps = std::min(obs.data.size(), acc->n_times);
+            for (size_t t = 0; t < n_steps; t++) {
+                const MatType& x_t(obs.data[t]);
+                acc->add_time(t, obs.time[t]);
+                for (size_t k = 0; k < np; k++) {
+                    acc->add(t, k, 0U, x_t(k,0));
+                    acc->add(t, k, 1U, x_t(k,1));
+                    acc->add(t, k, 2U, obs.P[t](k));
+                }
+            }
+        }
+
+        summaries->checkin(acc);
+        return;
+    }
+
+    // Same as above, but only keeping track of outcomes:
+    void do_outcome_reps(size_t begin, size_t end) {
+
+        pcg32 rng;
+        MatType x;
+        LandscapeConstF determ_sys(determ_sys0);
+
+        for (size_t rep = begin; rep < end; rep++) {
+            if (progress.cancelled()) break;
+            outcomes[rep].reset();
+            run_rep__(rep, rng, x, determ_sys, outcomes[rep]);
+        }
+        return;
+    }
+
+    /*
+     Simulate one rep, resuming from and writing checkpoints if requested.
+     Returns false if an existing checkpoint couldn't be used or if the
+     run was cancelled.
+     */
+    template< class Obs >
+    bool run_rep__(const size_t& rep,
+                   pcg32& rng,
+                   MatType& x,
+                   LandscapeConstF& determ_sys,
+                   Obs& obs) {
+
+        const size_t& np(determ_sys0.n_plants);
+        const std::string file(checkpoint_file + "." + std::to_string(rep + 1));
+        const std::string engine("landscape_constantF_stoch_ode");
+
+        seed_rep_rng(rng, master_seed, antithetic ? rep / 2U : rep);
+        x = x0;
+        determ_sys = determ_sys0;
+        size_t step = 0;
+        bool done = false;
+        TrajectoryLog log(file, engine, hash);
+
+        if (resume && ! checkpoint_file.empty() && file_exists(file)) {
+            CheckpointReader reader(file, engine, hash);
+            std::string log_status;
+            if (reader.good()) {
+                uint64_t step_in;
+                reader.read(done);
+                reader.read(step_in);
+                step = step_in;
+                reader.read(x);
+                reader.read_streamable(rng);
+                determ_sys.load(reader);
+                log_status = log.load(reader, obs);
+                obs.load(reader);
+            }
+            if (! reader.good()) {
+                checkpoint_status[rep] = "Checkpoint file " + file + " " +
+                    reader.status + "!";
+                return false;
+            }
+            if (! log_status.empty()) {
+                checkpoint_status[rep] = log_status + "!";
+                return false;
+            }
+        }
+        if (done) {
+            progress.add_rep();
+            return true;
+        }
+        progress.add_steps(step);
+
+        auto save = [&](const size_t& step_) {
+            // The checkpoint can only cover rows that were written:
+            bool ok = log.append(obs);
+            if (ok) {
+                CheckpointWriter writer(file, engine, hash);
+                writer.write(done);
+                writer.write(static_cast<uint64_t>(step_));
+                writer.write(x);
+                writer.write_streamable(rng);
+                determ_sys.save(writer);
+                log.save(writer);
+                obs.save(writer);
+                ok = writer.commit();
+            }
+            if (! ok) {
+                checkpoint_status[rep] = "Warning: checkpoint file " + file +
+                    " could not be written.";
+            }
+        };
+
+        /*
+         The deterministic part is passed by reference so it isn't copied
+         every step, and so that observers see the weights calculated
+         inside it.
+         */
+        StochLandscapeStepper stepper(np, 2U, season_len, season_surv,
+                                      season_sigma);
+        MatType noise_work;
+        ProgressTicker ticker(progress, false);
+        bool finished = integrate_const_from(
+            stepper,
+            std::pair<LandscapeConstF&, StochLandscapeStochProcess>(
+                determ_sys,
+                StochLandscapeStochProcess(rng, n_sigma, noise, noise_work,
+                                           antithetic && (rep % 2U) == 1U)),
+            x, step, dt, max_t, obs, checkpoint_steps, save, ticker);
+        if (! finished) return false;
+        progress.add_rep();
+
+        // Save finished reps so they aren't re-run when resuming:
+        if (! checkpoint_file.empty()) {
+            done = true;
+            save(step);
+        }
+
+        return true;
+    }
+
+    template< class S >
+    void fill_output__(NumericMatrix& output, const std::vector<S>& out) const {
+
+        const size_t& np(determ_sys0.n_plants);
+        size_t n_rows = 0;
+        for (const S& m : out) n_rows += m.n_rows;
+
+        output = NumericMatrix(n_rows, 6U);
+        colnames(output) = CharacterVector::create("rep", "t", "p", "Y", "B", "P");
+        size_t i = 0;
+        for (size_t rep = 0; rep < out.size(); rep++) {
+            const S& m(out[rep]);
+            double dbl_rep = static_cast<double>(rep) + 1;
+            for (size_t k = 0; k < m.n_rows; k++) {
+                output(i,0) = dbl_rep;
+                output(i,1) = times[rep][k / np];
+                output(i,2) = k % np;
+                for (size_t j = 0; j < m.n_cols; j++) {
+                    output(i,j+3U) = m(k,j);
+                }
+                i++;
+            }
+
+        }
+        return;
+    }
+
+    void fill_outcomes__(NumericMatrix& output) const {
+
+        size_t n_rows = 0;
+        for (const OutcomeTracker& o : outcomes) n_rows += o.n_rows(by_plant);
+
+        output = NumericMatrix(n_rows, by_plant ? 7U : 6U);
+        colnames(output) = outcome_colnames(by_plant, true);
+        size_t i = 0, i0;
+        for (size_t rep = 0; rep < outcomes.size(); rep++) {
+            i0 = i;
+            outcomes[rep].fill_output(output, i, 1U, by_plant);
+            double dbl_rep = static_cast<double>(rep) + 1;
+            for (; i0 < i; i0++) output(i0,0) = dbl_rep;
+        }
+        return;
+    }
 };
 
 
 
 
+// Checks for arguments only used in the stochastic version:
+inline void constF_stoch_arg_checks(bool& err,
+                                    const double& n_sigma,
+                                    const double& season_len,
+                                    const double& season_surv,
+                                    const double& season_sigma,
+                                    const double& dt,
+                                    const double& max_t) {
+    min_val_check(err, n_sigma, "n_sigma", 0, false);
+    min_val_check(err, season_len, "season_len", 0, false);
+    min_val_check(err, season_surv, "season_surv", 0);
+    max_val_check(err, season_surv, "season_surv", 1);
+    if (season_len < max_t && ! zero_remainder(season_len, dt)) {
+        Rcout << "season_len is " << std::to_string(season_len);
+        Rcout << " but should be divisible by dt (";
+        Rcout << std::to_string(dt) << ")!" << std::endl;
+        err = true;
+    }
+    min_val_check(err, season_sigma, "season_sigma", 0);
+    return;
+}
+
+
+
 //' @export
 // [[Rcpp::export]]
 NumericMatrix landscape_constantF_stoch_ode(const uint32_t& n_reps,
@@ -290,7 +613,27 @@ NumericMatrix landscape_constantF_stoch_ode(const uint32_t& n_reps,
                                             const double& season_surv = 0.01,
                                             const double& season_sigma = 0,
                                             const double& dt = 0.1,
-                                            const double& max_t = 100.0) {
+                                            const double& max_t = 100.0,
+                                            const bool& single_prec = false,
+                                            const bool& outcomes_only = false,
+                                            const double& threshold = 1e-6,
+                                            const double& outcome_window = 0,
+                                            const bool& by_plant = false,
+                                            const std::string& checkpoint_file = "",
+                                            const double& checkpoint_every = 0,
+                                            const bool& resume = false,
+                                            const bool& show_progress = false,
+                                            SEXP seed = R_NilValue,
+                                            SEXP noise_z = R_NilValue,
+                                            const double& noise_w = 1,
+                                            SEXP noise_vcv = R_NilValue,
+                                            const uint32_t& noise_rank = 0,
+                                            const uint32_t& grain_size = 1,
+                                            const bool& thread_stats = false,
+                                            const bool& antithetic = false,
+                                            const bool& summarize = false,
+                                            SEXP quantiles = R_NilValue,
+                                            const double& compression = 100) {
 
     /*
      I can't just use 'stop()' because it causes a segfault (or similar).
@@ -298,43 +641,1255 @@ NumericMatrix landscape_constantF_stoch_ode(const uint32_t& n_reps,
      */
     bool err = lanscape_constF_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
                                           L_0, u, X, Y0, B0, dt, max_t);
-    min_val_check(err, n_sigma, "n_sigma", 0, false);
     double season_len_ = (season_len == R_NilValue) ? max_t + 1.0 : as<double>(season_len);
-    min_val_check(err, season_len_, "season_len", 0, false);
-    min_val_check(err, season_surv, "season_surv", 0);
-    max_val_check(err, season_surv, "season_surv", 1);
-    if (season_len_ < max_t && ! zero_remainder(season_len_, dt)) {
-        Rcout << "season_len is " << std::to_string(season_len_);
-        Rcout << " but should be divisible by dt (";
-        Rcout << std::to_string(dt) << ")!" << std::endl;
+    constF_stoch_arg_checks(err, n_sigma, season_len_, season_surv,
+                            season_sigma, dt, max_t);
+    outcome_arg_checks(err, threshold, outcome_window);
+    size_t checkpoint_steps = checkpoint_arg_checks(err, checkpoint_file,
+                                                    checkpoint_every, dt);
+    if (seed != R_NilValue) min_val_check(err, as<double>(seed), "seed", 0);
+    min_val_check(err, grain_size, "grain_size", 1);
+    if (antithetic && n_reps % 2U != 0) {
+        Rcout << "n_reps should be even when antithetic = TRUE!" << std::endl;
         err = true;
     }
-    min_val_check(err, season_sigma, "season_sigma", 0);
+    std::vector<double> quantiles_;
+    if (quantiles != R_NilValue) {
+        quantiles_ = as<std::vector<double>>(quantiles);
+        min_val_check(err, quantiles_, "quantiles", 0);
+        max_val_check(err, quantiles_, "quantiles", 1);
+    }
+    if (summarize) {
+        if (outcomes_only) {
+            Rcout << "summarize and outcomes_only can't both be TRUE!" << std::endl;
+            err = true;
+        }
+        min_val_check(err, compression, "compression", 10);
+    }
+    // Correlations among plants for noise (if requested):
+    arma::mat noise_C;
+    bool corr_noise = noise_corr_mat(noise_C, err, noise_z, noise_w, noise_vcv,
+                                     m.size());
     if (err) return NumericMatrix(0,0);
 
+    // Factored once here, then shared by all reps:
+    SpatialNoise noise;
+    if (corr_noise && ! noise.factor(noise_C, noise_rank)) {
+        Rcout << "Correlation matrix for noise is not positive semi-definite!";
+        Rcout << std::endl;
+        return NumericMatrix(0,0);
+    }
+
+    // Each rep's RNG is seeded from this and the rep's index:
+    uint64_t master_seed = make_master_seed(seed);
+
+    // Checkpoints can only be used to resume runs with identical inputs:
+    InputHash hash;
+    if (! checkpoint_file.empty()) {
+        hash.add(n_reps, m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X,
+                 Y0, B0, n_sigma, season_len_, season_surv, season_sigma,
+                 dt, max_t, single_prec, outcomes_only, threshold,
+                 outcome_window);
+        /*
+         Reps are drawn from streams based on the seed, so resuming with a
+         different one (or with none, which draws a new one) would mix
+         reps from different streams:
+         */
+        hash.add(seed == R_NilValue, master_seed);
+        if (corr_noise) hash.add(noise_C, noise_rank);
+        if (antithetic) hash.add(antithetic);
+        if (summarize) hash.add(summarize);
+    }
+
+
+    Progress progress(n_reps, n_reps * n_const_steps(dt, max_t), show_progress);
 
     StochLandCFWorker worker(n_reps, m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
                              L_0, u, X, Y0, B0, n_sigma,
                              season_len_, season_surv, season_sigma,
-                             dt, max_t);
+                             master_seed, antithetic, noise, dt, max_t,
+                             single_prec, outcomes_only,
+                             threshold, outcome_window, by_plant,
+                             checkpoint_file, checkpoint_steps, resume,
+                             hash.value, progress);
 
-    RcppParallel::parallelFor(0, n_reps, worker);
+    /*
+     For summaries, each chunk of reps that's running adds to its own
+     accumulator, and these are merged afterwards:
+     */
+    AccumulatorPool pool(EnsembleAccumulator(summarize ?
+                                                 n_const_steps(dt, max_t) + 2U : 0U,
+                                             m.size(), 3U,
+                                             summarize && ! quantiles_.empty(),
+                                             compression));
+    if (summarize) worker.summaries = &pool;
+
+    // Reps are handed to threads `grain_size` at a time (see scheduler.h):
+    ThreadUsage usage;
+    // Running in another thread lets this one check for interrupts:
+    bool finished = progress.run_parallel([&]() {
+        dynamic_parallel_for(worker, n_reps, grain_size, usage);
+    });
+
+    for (const std::string& status : worker.checkpoint_status) {
+        if (status.empty()) continue;
+        Rcout << status << std::endl;
+        // Not being able to write checkpoints isn't fatal:
+        if (status.compare(0, 7, "Warning") != 0) err = true;
+    }
+    if (err || ! finished) return NumericMatrix(0,0);
+
+    NumericMatrix output;
+    if (summarize) {
+        output = ensemble_output(pool.merged(), {"Y", "B", "P"}, quantiles_);
+    } else worker.fill_output(output);
+    if (thread_stats) output.attr("thread_stats") = usage.output();
+
+    return output;
+}
+
+
+
+
+/*
+ Worker for the reps of parameter set `k` in `par_sets` (see `SweepPars`),
+ used when comparing or sweeping sets below.
+ Returns nullptr (and sets `err`) if the set's parameters aren't valid.
+ */
+inline std::unique_ptr<StochLandCFWorker> stoch_set_worker(
+        SweepPars& pars,
+        const size_t& k,
+        const size_t& np,
+        const uint32_t& n_reps,
+        const double& season_len,
+        const uint64_t& master_seed,
+        const bool& antithetic,
+        const SpatialNoise& noise,
+        const double& dt,
+        const double& max_t,
+        const bool& single_prec,
+        const bool& outcomes_only,
+        const double& threshold,
+        const double& outcome_window,
+        const bool& by_plant,
+        Progress& progress,
+        bool& err) {
+
+    std::vector<double> m = pars.plant_pars(k, "m", np, err);
+    std::vector<double> d_yp = pars.plant_pars(k, "d_yp", np, err);
+    std::vector<double> d_b0 = pars.plant_pars(k, "d_b0", np, err);
+    std::vector<double> d_bp = pars.plant_pars(k, "d_bp", np, err);
+    std::vector<double> g_yp = pars.plant_pars(k, "g_yp", np, err);
+    std::vector<double> g_b0 = pars.plant_pars(k, "g_b0", np, err);
+    std::vector<double> g_bp = pars.plant_pars(k, "g_bp", np, err);
+    std::vector<double> L_0 = pars.plant_pars(k, "L_0", np, err);
+    double u = pars.scalar_par(k, "u", err);
+    double X = pars.scalar_par(k, "X", err);
+    std::vector<double> Y0 = pars.plant_pars(k, "Y0", np, err);
+    std::vector<double> B0 = pars.plant_pars(k, "B0", np, err);
+    double n_sigma = pars.scalar_par(k, "n_sigma", err);
+    // Same defaults as `landscape_constantF_stoch_ode`:
+    double season_surv = pars.has(k, "season_surv") ?
+        pars.scalar_par(k, "season_surv", err) : 0.01;
+    double season_sigma = pars.has(k, "season_sigma") ?
+        pars.scalar_par(k, "season_sigma", err) : 0;
+    if (err) return nullptr;
+
+    bool set_err = lanscape_constF_arg_checks(m, d_yp, d_b0, d_bp, g_yp,
+                                              g_b0, g_bp, L_0, u, X, Y0,
+                                              B0, dt, max_t);
+    constF_stoch_arg_checks(set_err, n_sigma, season_len, season_surv,
+                            season_sigma, dt, max_t);
+    if (set_err) {
+        Rcout << "(in parameter set " << (k + 1U) << ")" << std::endl;
+        err = true;
+        return nullptr;
+    }
+
+    return std::unique_ptr<StochLandCFWorker>(new StochLandCFWorker(
+            n_reps, m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, u, X,
+            Y0, B0, n_sigma, season_len, season_surv, season_sigma,
+            master_seed, antithetic, noise, dt, max_t, single_prec,
+            outcomes_only, threshold, outcome_window, by_plant, "", 0U,
+            false, 0U, progress));
+}
 
-    size_t n_rows = 0;
-    for (const MatType& m : worker.output) n_rows += m.n_rows;
 
-    NumericMatrix output(n_rows, 6U);
-    colnames(output) = CharacterVector::create("rep", "t", "p", "Y", "B", "P");
+
+/*
+ Comparing parameter sets using common random numbers:
+ rep `i` of every set uses the same RNG stream, so differences between sets
+ are mostly from their parameters rather than from noise.
+ Each task for the scheduler is one rep of one set (this is also used for
+ sweeps below, where streams don't have to be common).
+ */
+struct StochLandCFCompareWorker : public RcppParallel::Worker {
+
+    std::vector<std::unique_ptr<StochLandCFWorker>>& workers;
+    size_t n_reps;
+
+    StochLandCFCompareWorker(std::vector<std::unique_ptr<StochLandCFWorker>>& workers_,
+                             const size_t& n_reps_)
+        : workers(workers_), n_reps(n_reps_) {};
+
+    void operator()(size_t begin, size_t end) {
+        size_t rep;
+        for (size_t i = begin; i < end; i++) {
+            rep = i % n_reps;
+            (*workers[i / n_reps])(rep, rep + 1U);
+        }
+        return;
+    }
+};
+
+
+/*
+ Probability of each landscape-wide outcome for each set, plus its
+ difference from set 1.
+ Standard errors use independent units, which are reps or, if
+ `antithetic`, pairs of reps.
+ `diff_se` uses paired differences within units, and `indep_se` is what
+ the standard error of the difference would be if sets didn't share
+ random numbers.
+ */
+inline NumericMatrix compare_output(
+        const std::vector<std::unique_ptr<StochLandCFWorker>>& workers,
+        const size_t& n_reps,
+        const bool& antithetic) {
+
+    size_t n_sets = workers.size();
+    size_t per_unit = antithetic ? 2U : 1U;
+    size_t n_units = n_reps / per_unit;
+    double n_units_dbl = static_cast<double>(n_units);
+
+    // Proportion of reps in each unit (rows) with each outcome (columns):
+    std::vector<arma::mat> props(n_sets, arma::mat(n_units, 4U, arma::fill::zeros));
+    for (size_t k = 0; k < n_sets; k++) {
+        const std::vector<OutcomeTracker>& outs(workers[k]->outcomes);
+        for (size_t rep = 0; rep < n_reps; rep++) {
+            int out = outs[rep].outcome(outs[rep].n_plants);
+            props[k](rep / per_unit, out - 1) += 1.0 / static_cast<double>(per_unit);
+        }
+    }
+
+    auto mean_se = [&](const arma::vec& v, double& mean, double& se) {
+        mean = arma::accu(v) / n_units_dbl;
+        if (n_units < 2U) {
+            se = NA_REAL;
+            return;
+        }
+        double ss = 0;
+        for (size_t i = 0; i < n_units; i++) ss += (v(i) - mean) * (v(i) - mean);
+        se = std::sqrt(ss / (n_units_dbl - 1) / n_units_dbl);
+        return;
+    };
+
+    NumericMatrix output(n_sets * 4U, 7U);
+    colnames(output) = CharacterVector::create("set", "outcome", "p", "p_se",
+             "diff", "diff_se", "indep_se");
+    double p, p_se, p1, p1_se, diff, diff_se;
     size_t i = 0;
-    for (size_t rep = 0; rep < worker.output.size(); rep++) {
-        const MatType& m(worker.output[rep]);
-        for (size_t k = 0; k < m.n_rows; k++) {
-            for (size_t j = 0; j < m.n_cols; j++) {
-                output(i,j) = m(k,j);
-            }
+    for (size_t k = 0; k < n_sets; k++) {
+        for (size_t j = 0; j < 4U; j++) {
+            arma::vec pk = props[k].col(j);
+            arma::vec p0 = props[0].col(j);
+            mean_se(pk, p, p_se);
+            mean_se(p0, p1, p1_se);
+            pk -= p0;
+            mean_se(pk, diff, diff_se);
+            output(i,0) = k + 1;
+            output(i,1) = j + 1;
+            output(i,2) = p;
+            output(i,3) = p_se;
+            output(i,4) = diff;
+            output(i,5) = diff_se;
+            output(i,6) = std::sqrt(p_se * p_se + p1_se * p1_se);
             i++;
         }
+    }
+    return output;
+}
+
+
+
+/*
+ Run `landscape_constantF_stoch_ode` for each parameter set in `par_sets`
+ (named lists of its arguments, with those that are the same for all
+ sets in `shared`) using common random numbers, and optionally antithetic
+ pairs of reps.
+ All sets need to have `n_plants` plants so their RNG streams stay in sync.
+ Returns the probability of each landscape-wide outcome (codes are in
+ outcomes.h) for each set, and estimates of its difference from set 1
+ (see `compare_output` above).
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_constantF_stoch_compare(const uint32_t& n_reps,
+                                                const List& par_sets,
+                                                const List& shared,
+                                                const uint32_t& n_plants,
+                                                SEXP season_len = R_NilValue,
+                                                const double& dt = 0.1,
+                                                const double& max_t = 100.0,
+                                                const double& threshold = 1e-6,
+                                                const double& outcome_window = 0,
+                                                const bool& antithetic = false,
+                                                const bool& show_progress = false,
+                                                SEXP seed = R_NilValue,
+                                                const uint32_t& grain_size = 1,
+                                                const bool& thread_stats = false) {
+
+    bool err = false;
+    min_val_check(err, n_reps, "n_reps", 1);
+    min_val_check(err, static_cast<double>(par_sets.size()), "length(par_sets)", 1);
+    min_val_check(err, n_plants, "n_plants", 1);
+    double season_len_ = (season_len == R_NilValue) ? max_t + 1.0 : as<double>(season_len);
+    outcome_arg_checks(err, threshold, outcome_window);
+    if (seed != R_NilValue) min_val_check(err, as<double>(seed), "seed", 0);
+    min_val_check(err, grain_size, "grain_size", 1);
+    if (antithetic && n_reps % 2U != 0) {
+        Rcout << "n_reps should be even when antithetic = TRUE!" << std::endl;
+        err = true;
+    }
+    if (err) return NumericMatrix(0,0);
+
+    // Shared by all sets, which is what makes random numbers common:
+    uint64_t master_seed = make_master_seed(seed);
+    SpatialNoise noise;
+
+    SweepPars pars(par_sets, shared);
+    size_t n_sets = pars.n_sets;
+    size_t np = n_plants;
+    Progress progress(n_sets * n_reps,
+                      n_sets * n_reps * n_const_steps(dt, max_t),
+                      show_progress);
+
+    std::vector<std::unique_ptr<StochLandCFWorker>> workers;
+    workers.reserve(n_sets);
+    for (size_t k = 0; k < n_sets; k++) {
+        workers.push_back(stoch_set_worker(
+                pars, k, np, n_reps, season_len_, master_seed, antithetic,
+                noise, dt, max_t, false, true, threshold, outcome_window,
+                false, progress, err));
+        if (err) return NumericMatrix(0,0);
+    }
+
+    StochLandCFCompareWorker worker(workers, n_reps);
+
+    // Reps are handed to threads `grain_size` at a time (see scheduler.h):
+    ThreadUsage usage;
+    // Running in another thread lets this one check for interrupts:
+    bool finished = progress.run_parallel([&]() {
+        dynamic_parallel_for(worker, n_sets * n_reps, grain_size, usage);
+    });
+    if (! finished) return NumericMatrix(0,0);
+
+    NumericMatrix output = compare_output(workers, n_reps, antithetic);
+    if (thread_stats) output.attr("thread_stats") = usage.output();
+
+    return output;
+}
+
+
+
+
+/*
+ Run `landscape_constantF_stoch_ode` for each parameter set in `par_sets`
+ (named lists of its arguments, with those that are the same for all
+ sets in `shared`).
+ Each task for the scheduler is one rep of one set, so a few slow sets
+ don't hold up the rest.
+ Sets each get their own RNG streams unless `common_random` is true, in
+ which case rep `i` of every set uses the same stream (as in
+ `landscape_constantF_stoch_compare`), and each set's output is the same
+ as from `landscape_constantF_stoch_ode` with the same `seed`.
+ All sets need to have `n_plants` plants, and noise correlations (if any)
+ are the same for all sets.
+ Returns the output from all sets bound together, with the set number in
+ the first column.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_constantF_stoch_sweep(const uint32_t& n_reps,
+                                              const List& par_sets,
+                                              const List& shared,
+                                              const uint32_t& n_plants,
+                                              SEXP season_len = R_NilValue,
+                                              const double& dt = 0.1,
+                                              const double& max_t = 100.0,
+                                              const bool& single_prec = false,
+                                              const bool& outcomes_only = false,
+                                              const double& threshold = 1e-6,
+                                              const double& outcome_window = 0,
+                                              const bool& by_plant = false,
+                                              const bool& show_progress = false,
+                                              SEXP seed = R_NilValue,
+                                              const bool& common_random = false,
+                                              SEXP noise_z = R_NilValue,
+                                              const double& noise_w = 1,
+                                              SEXP noise_vcv = R_NilValue,
+                                              const uint32_t& noise_rank = 0,
+                                              const bool& antithetic = false,
+                                              const uint32_t& grain_size = 1,
+                                              const bool& thread_stats = false) {
+
+    bool err = false;
+    min_val_check(err, n_reps, "n_reps", 1);
+    min_val_check(err, static_cast<double>(par_sets.size()), "length(par_sets)", 1);
+    min_val_check(err, n_plants, "n_plants", 1);
+    double season_len_ = (season_len == R_NilValue) ? max_t + 1.0 : as<double>(season_len);
+    outcome_arg_checks(err, threshold, outcome_window);
+    if (seed != R_NilValue) min_val_check(err, as<double>(seed), "seed", 0);
+    min_val_check(err, grain_size, "grain_size", 1);
+    if (antithetic && n_reps % 2U != 0) {
+        Rcout << "n_reps should be even when antithetic = TRUE!" << std::endl;
+        err = true;
+    }
+    arma::mat noise_C;
+    bool corr_noise = noise_corr_mat(noise_C, err, noise_z, noise_w, noise_vcv,
+                                     n_plants);
+    if (err) return NumericMatrix(0,0);
+
+    SpatialNoise noise;
+    if (corr_noise && ! noise.factor(noise_C, noise_rank)) {
+        Rcout << "Correlation matrix for noise is not positive semi-definite!";
+        Rcout << std::endl;
+        return NumericMatrix(0,0);
+    }
+
+    uint64_t master_seed = make_master_seed(seed);
+
+    SweepPars pars(par_sets, shared);
+    size_t n_sets = pars.n_sets;
+    size_t np = n_plants;
+    Progress progress(n_sets * n_reps,
+                      n_sets * n_reps * n_const_steps(dt, max_t),
+                      show_progress);
+
+    std::vector<std::unique_ptr<StochLandCFWorker>> workers;
+    workers.reserve(n_sets);
+    for (size_t k = 0; k < n_sets; k++) {
+        uint64_t set_seed = common_random ? master_seed :
+            splitmix64(master_seed ^ splitmix64(k));
+        workers.push_back(stoch_set_worker(
+                pars, k, np, n_reps, season_len_, set_seed, antithetic,
+                noise, dt, max_t, single_prec, outcomes_only, threshold,
+                outcome_window, by_plant, progress, err));
+        if (err) return NumericMatrix(0,0);
+    }
 
+    StochLandCFCompareWorker worker(workers, n_reps);
+
+    // Reps are handed to threads `grain_size` at a time (see scheduler.h):
+    ThreadUsage usage;
+    // Running in another thread lets this one check for interrupts:
+    bool finished = progress.run_parallel([&]() {
+        dynamic_parallel_for(worker, n_sets * n_reps, grain_size, usage);
+    });
+    if (! finished) return NumericMatrix(0,0);
+
+    // Bind output from all sets, with the set number in the first column:
+    std::vector<NumericMatrix> set_out(n_sets);
+    size_t n_rows = 0;
+    for (size_t k = 0; k < n_sets; k++) {
+        workers[k]->fill_output(set_out[k]);
+        n_rows += set_out[k].nrow();
+    }
+    size_t n_cols = set_out.front().ncol();
+    NumericMatrix output(n_rows, n_cols + 1U);
+    CharacterVector cn = CharacterVector::create("set");
+    CharacterVector cn0 = colnames(set_out.front());
+    for (size_t j = 0; j < n_cols; j++) cn.push_back(cn0[j]);
+    colnames(output) = cn;
+    size_t i = 0;
+    for (size_t k = 0; k < n_sets; k++) {
+        const NumericMatrix& o(set_out[k]);
+        double set = static_cast<double>(k) + 1;
+        for (size_t r = 0; r < static_cast<size_t>(o.nrow()); r++) {
+            output(i,0) = set;
+            for (size_t j = 0; j < n_cols; j++) output(i,j+1U) = o(r,j);
+            i++;
+        }
     }
+    if (thread_stats) output.attr("thread_stats") = usage.output();
+
+    return output;
+}
+
+
+
+
+/*
+ Rare-event probabilities using adaptive multilevel splitting (AMS;
+ Cerou & Guyader 2007, with ties handled as in Brehier et al. 2016).
+
+ The event is one microbe going extinct across the landscape (its mean
+ proportion across plants falling to `threshold` or below) before `max_t`.
+ Progress toward it is scored as 1 minus that mean proportion.
+ Each iteration kills the `n_kill` particles (trajectories) with the lowest
+ maximum scores (plus any tied with them) and replaces each with a copy of
+ a random survivor, branched from the first point where that survivor beat
+ the killed particles' level and continued with its own RNG stream.
+ The estimate of the probability is
+ prod(1 - n_killed / n_particles) * (proportion of final particles that
+ reached the event), which is unbiased, so estimates from independent runs
+ can be averaged.
+ */
+class StochLandCFAms
+{
+public:
+
+    // Running maxima of the score (where it was beaten) for one particle:
+    struct Record {
+        size_t step;
+        double score;
+        MatType x;
+    };
+    struct Particle {
+        std::vector<Record> records;
+        bool hit;
+        double max_score() const { return records.back().score; }
+    };
+
+    StochLandCFAms(const LandscapeConstF& determ_sys0_,
+                   const MatType& x0_,
+                   const size_t& microbe_,
+                   const double& threshold_,
+                   const size_t& n_particles_,
+                   const size_t& n_kill_,
+                   const size_t& max_iters_,
+                   const double& n_sigma_,
+                   const double& season_len_,
+                   const double& season_surv_,
+                   const double& season_sigma_,
+                   const double& dt_,
+                   const double& max_t_)
+        : determ_sys0(determ_sys0_),
+          x0(x0_),
+          microbe(microbe_),
+          target(1 - threshold_),
+          n_particles(n_particles_),
+          n_kill(n_kill_),
+          max_iters(max_iters_),
+          n_sigma(n_sigma_),
+          season_len(season_len_),
+          season_surv(season_surv_),
+          season_sigma(season_sigma_),
+          dt(dt_),
+          max_steps(n_const_steps(dt_, max_t_)) {};
+
+    /*
+     One AMS run whose random numbers all come from `run_seed`.
+     Stream 0 is used to pick survivors and each branch gets the next
+     stream.
+     Fills `out` with the estimate, number of iterations, number of final
+     particles that reached the event, and final level.
+     Returns false if cancelled.
+     */
+    bool run(const uint64_t& run_seed,
+             std::vector<double>& out,
+             ProgressTicker& ticker) const {
+
+        pcg32 select_rng;
+        seed_rep_rng(select_rng, run_seed, 0);
+        uint64_t branch = 1;
+        LandscapeConstF determ_sys(determ_sys0);
+        MatType noise_work;
+        SpatialNoise noise;
+
+        std::vector<Particle> particles(n_particles);
+        for (Particle& p : particles) {
+            p.records.assign(1U, Record{0U, score__(x0), x0});
+            if (! simulate__(p, run_seed, branch++, determ_sys, noise,
+                             noise_work, ticker)) return false;
+        }
+
+        double log_p = 0;
+        double level = -1;
+        size_t iter = 0;
+        std::vector<double> scores(n_particles);
+        std::vector<size_t> killed, survivors;
+
+        while (iter < max_iters) {
+            for (size_t i = 0; i < n_particles; i++) {
+                scores[i] = particles[i].max_score();
+            }
+            std::vector<double> sorted(scores);
+            std::nth_element(sorted.begin(), sorted.begin() + (n_kill - 1U),
+                             sorted.end());
+            level = sorted[n_kill - 1U];
+            if (level >= target) break;
+            killed.clear();
+            survivors.clear();
+            for (size_t i = 0; i < n_particles; i++) {
+                if (scores[i] <= level) {
+                    killed.push_back(i);
+                } else survivors.push_back(i);
+            }
+            log_p += std::log1p(-static_cast<double>(killed.size()) /
+                static_cast<double>(n_particles));
+            iter++;
+            if (survivors.empty()) {
+                log_p = -arma::datum::inf;
+                break;
+            }
+            for (const size_t& i : killed) {
+                size_t j = survivors[static_cast<size_t>(
+                    unif_open(select_rng()) * survivors.size())];
+                // Branch at the first point where the survivor beat `level`:
+                const std::vector<Record>& rj(particles[j].records);
+                size_t r = 0;
+                while (rj[r].score <= level) r++;
+                particles[i].records.assign(rj.begin(), rj.begin() + r + 1U);
+                if (! simulate__(particles[i], run_seed, branch++, determ_sys,
+                                 noise, noise_work, ticker)) return false;
+            }
+        }
+
+        double n_hit = 0;
+        for (const Particle& p : particles) n_hit += p.hit ? 1 : 0;
+
+        out.resize(4U);
+        out[0] = std::exp(log_p) * n_hit / static_cast<double>(n_particles);
+        out[1] = iter;
+        out[2] = n_hit;
+        out[3] = level;
+        return true;
+    }
+
+private:
+    const LandscapeConstF& determ_sys0;
+    MatType x0;
+    size_t microbe;
+    double target;
+    size_t n_particles;
+    size_t n_kill;
+    size_t max_iters;
+    double n_sigma;
+    double season_len;
+    double season_surv;
+    double season_sigma;
+    double dt;
+    size_t max_steps;
+
+    double score__(const MatType& x) const {
+        double mean_x = 0;
+        for (size_t i = 0; i < x.n_rows; i++) mean_x += x(i, microbe);
+        return 1 - mean_x / static_cast<double>(x.n_rows);
+    }
+
+    /*
+     Continue a particle from its last record until it reaches the event or
+     the end, adding a record every time its score is beaten.
+     */
+    bool simulate__(Particle& p,
+                    const uint64_t& run_seed,
+                    const uint64_t& branch,
+                    LandscapeConstF& determ_sys,
+                    const SpatialNoise& noise,
+                    MatType& noise_work,
+                    ProgressTicker& ticker) const {
+
+        pcg32 rng;
+        seed_rep_rng(rng, run_seed, branch);
+        MatType x(p.records.back().x);
+        size_t step = p.records.back().step;
+        double best = p.records.back().score;
+        p.hit = best >= target;
+        StochLandscapeStepper stepper(x.n_rows, 2U, season_len, season_surv,
+                                      season_sigma);
+        std::pair<LandscapeConstF&, StochLandscapeStochProcess> system(
+            determ_sys,
+            StochLandscapeStochProcess(rng, n_sigma, noise, noise_work));
+
+        double score;
+        while (! p.hit && step < max_steps) {
+            stepper.do_step(system, x, static_cast<double>(step) * dt, dt);
+            step++;
+            score = score__(x);
+            if (score > best) {
+                best = score;
+                p.records.push_back(Record{step, score, x});
+                p.hit = best >= target;
+            }
+            if (! ticker.tick()) return false;
+        }
+        return true;
+    }
+};
+
+
+
+struct StochLandCFAmsWorker : public RcppParallel::Worker {
+
+    const StochLandCFAms& ams;
+    uint64_t master_seed;
+    std::vector<std::vector<double>> output;
+    Progress& progress;
+
+    StochLandCFAmsWorker(const StochLandCFAms& ams_,
+                         const uint64_t& master_seed_,
+                         const size_t& n_runs,
+                         Progress& progress_)
+        : ams(ams_), master_seed(master_seed_), output(n_runs),
+          progress(progress_) {};
+
+    void operator()(size_t begin, size_t end) {
+        ProgressTicker ticker(progress, false);
+        for (size_t i = begin; i < end; i++) {
+            if (progress.cancelled()) break;
+            // Each run's streams come from its own seed:
+            uint64_t run_seed = splitmix64(master_seed ^ splitmix64(i));
+            if (! ams.run(run_seed, output[i], ticker)) break;
+            progress.add_rep();
+        }
+        return;
+    }
+};
+
+
+
+/*
+ Probability that yeast or bacteria (`extinct`) goes extinct across the
+ landscape (see `StochLandCFAms` above) in `landscape_constantF_stoch_ode`.
+ Returns one row per independent AMS run with that run's estimate,
+ the number of iterations, the number of final particles that reached the
+ event, and the final level.
+ The mean of estimates is unbiased, and their SD / sqrt(n_runs) is its
+ standard error.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_constantF_stoch_ams(const uint32_t& n_runs,
+                                            const uint32_t& n_particles,
+                                            const std::vector<double>& m,
+                                            const std::vector<double>& d_yp,
+                                            const std::vector<double>& d_b0,
+                                            const std::vector<double>& d_bp,
+                                            const std::vector<double>& g_yp,
+                                            const std::vector<double>& g_b0,
+                                            const std::vector<double>& g_bp,
+                                            const std::vector<double>& L_0,
+                                            const double& u,
+                                            const double& X,
+                                            const std::vector<double>& Y0,
+                                            const std::vector<double>& B0,
+                                            const double& n_sigma,
+                                            const std::string& extinct = "yeast",
+                                            const double& threshold = 1e-6,
+                                            const uint32_t& n_kill = 1,
+                                            const uint32_t& max_iters = 1000000,
+                                            SEXP season_len = R_NilValue,
+                                            const double& season_surv = 0.01,
+                                            const double& season_sigma = 0,
+                                            const double& dt = 0.1,
+                                            const double& max_t = 100.0,
+                                            const bool& show_progress = false,
+                                            SEXP seed = R_NilValue,
+                                            const uint32_t& grain_size = 1) {
+
+    bool err = lanscape_constF_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                          L_0, u, X, Y0, B0, dt, max_t);
+    double season_len_ = (season_len == R_NilValue) ? max_t + 1.0 : as<double>(season_len);
+    constF_stoch_arg_checks(err, n_sigma, season_len_, season_surv,
+                            season_sigma, dt, max_t);
+    min_val_check(err, n_runs, "n_runs", 1);
+    min_val_check(err, n_particles, "n_particles", 2);
+    min_val_check(err, n_kill, "n_kill", 1);
+    max_val_check(err, n_kill, "n_kill", n_particles - 1.0);
+    min_val_check(err, threshold, "threshold", 0);
+    if (extinct != "yeast" && extinct != "bacteria") {
+        Rcout << "extinct must be \"yeast\" or \"bacteria\"!" << std::endl;
+        err = true;
+    }
+    if (seed != R_NilValue) min_val_check(err, as<double>(seed), "seed", 0);
+    min_val_check(err, grain_size, "grain_size", 1);
+    if (err) return NumericMatrix(0,0);
+
+    MatType x0(m.size(), 2U);
+    for (size_t i = 0; i < m.size(); i++) {
+        x0(i,0) = Y0[i];
+        x0(i,1) = B0[i];
+    }
+    LandscapeConstF determ_sys0(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0,
+                                u, X);
+    StochLandCFAms ams(determ_sys0, x0, (extinct == "yeast") ? 0U : 1U,
+                       threshold, n_particles, n_kill, max_iters, n_sigma,
+                       season_len_, season_surv, season_sigma, dt, max_t);
+
+    uint64_t master_seed = make_master_seed(seed);
+    // Total steps aren't known ahead of time, so only reps are shown:
+    Progress progress(n_runs, 0U, show_progress);
+    StochLandCFAmsWorker worker(ams, master_seed, n_runs, progress);
+
+    ThreadUsage usage;
+    // Running in another thread lets this one check for interrupts:
+    bool finished = progress.run_parallel([&]() {
+        dynamic_parallel_for(worker, n_runs, grain_size, usage);
+    });
+    if (! finished) return NumericMatrix(0,0);
+
+    NumericMatrix output(n_runs, 5U);
+    colnames(output) = CharacterVector::create("run", "p", "n_iters",
+             "n_hit", "level");
+    for (size_t i = 0; i < n_runs; i++) {
+        output(i,0) = i + 1;
+        for (size_t j = 0; j < 4U; j++) output(i,j+1U) = worker.output[i][j];
+    }
+
+    return output;
+}
+
+
+
+
+/*
+ Approximate Bayesian computation using sequential Monte Carlo (ABC-SMC;
+ Beaumont et al. 2009, with tolerances set adaptively as in
+ Del Moral et al. 2012) for `n_sigma`, `season_surv`, and `season_sigma`.
+
+ Priors are uniform, and each particle is one run of
+ `landscape_constantF_stoch_ode` summarized at the end by the
+ dissimilarity and diversity of yeast and bacteria among plants
+ (see community.h). The distance from the observed summaries is Euclidean.
+ Generation 0 samples from the priors. Each later generation's tolerance
+ is the `alpha` quantile of the previous generation's distances, and
+ particles are proposed by resampling the previous generation by weight
+ and perturbing with a Gaussian kernel (SD = sqrt(2 * weighted variance)
+ for each parameter) until `n_particles` are within the tolerance.
+ */
+class StochLandCFAbc
+{
+public:
+
+    // Parameters are n_sigma, season_surv, and season_sigma:
+    static constexpr size_t n_pars = 3;
+    // Summaries are dissimilarity and diversity:
+    static constexpr size_t n_stats = 2;
+    typedef std::array<double, n_pars> ParArray;
+    typedef std::array<double, n_stats> StatArray;
+
+    const LandscapeConstF& determ_sys0;
+
+    // The last complete generation:
+    arma::mat theta;
+    arma::mat stats;
+    arma::vec dist;
+    arma::vec weights;
+    // For each complete generation:
+    std::vector<double> epsilons;
+    std::vector<double> accept_rates;
+    std::vector<double> n_sims;
+
+    StochLandCFAbc(const LandscapeConstF& determ_sys0_,
+                   const MatType& x0_,
+                   const StatArray& obs_stats_,
+                   const ParArray& lower_,
+                   const ParArray& upper_,
+                   const size_t& n_particles_,
+                   const size_t& n_gens_,
+                   const double& alpha_,
+                   const double& min_accept_,
+                   const double& season_len_,
+                   const double& dt_,
+                   const double& max_t_,
+                   const uint64_t& master_seed_)
+        : determ_sys0(determ_sys0_),
+          theta(n_particles_, n_pars),
+          stats(n_particles_, n_stats),
+          dist(n_particles_),
+          weights(n_particles_),
+          epsilons(),
+          accept_rates(),
+          n_sims(),
+          x0(x0_),
+          obs_stats(obs_stats_),
+          lower(lower_),
+          upper(upper_),
+          n_particles(n_particles_),
+          n_gens(n_gens_),
+          alpha(alpha_),
+          min_accept(min_accept_),
+          season_len(season_len_),
+          dt(dt_),
+          max_steps(n_const_steps(dt_, max_t_)),
+          master_seed(master_seed_),
+          kernel_sd(),
+          cum_weights(n_particles_) {};
+
+    /*
+     Propose and simulate proposal `k` of generation `gen`.
+     All of its random numbers come from its own stream, so results don't
+     depend on threads.
+     Returns false if cancelled.
+     */
+    bool propose(const size_t& gen,
+                 const size_t& k,
+                 LandscapeConstF& determ_sys,
+                 MatType& noise_work,
+                 ProgressTicker& ticker,
+                 ParArray& th,
+                 StatArray& st,
+                 double& d) const {
+
+        pcg32 rng;
+        seed_rep_rng(rng, splitmix64(master_seed ^ splitmix64(gen)), k);
+        const ZigguratTables& zt(zig_tables());
+
+        if (gen == 0) {
+            for (size_t j = 0; j < n_pars; j++) {
+                th[j] = lower[j] + (upper[j] - lower[j]) * unif_open(rng());
+            }
+        } else {
+            bool inside = false;
+            while (! inside) {
+                double r = unif_open(rng());
+                size_t i = std::lower_bound(cum_weights.begin(),
+                                            cum_weights.end(), r) -
+                                                cum_weights.begin();
+                i = std::min(i, n_particles - 1U);
+                inside = true;
+                for (size_t j = 0; j < n_pars; j++) {
+                    th[j] = theta(i,j) + kernel_sd[j] * zig_normal(rng, zt);
+                    inside = inside && th[j] >= lower[j] && th[j] <= upper[j];
+                }
+            }
+        }
+
+        MatType x(x0);
+        StochLandscapeStepper stepper(x.n_rows, 2U, season_len, th[1], th[2]);
+        std::pair<LandscapeConstF&, StochLandscapeStochProcess> system(
+            determ_sys,
+            StochLandscapeStochProcess(rng, th[0], noise, noise_work));
+        for (size_t step = 0; step < max_steps; step++) {
+            stepper.do_step(system, x, static_cast<double>(step) * dt, dt);
+            if (! ticker.tick()) return false;
+        }
+
+        st[0] = bray_curtis_mean(x.colptr(0), x.colptr(1), x.n_rows);
+        st[1] = shannon_mean(x.colptr(0), x.colptr(1), x.n_rows);
+        d = 0;
+        for (size_t j = 0; j < n_stats; j++) {
+            d += (st[j] - obs_stats[j]) * (st[j] - obs_stats[j]);
+        }
+        d = std::sqrt(d);
+        if (! std::isfinite(d)) d = arma::datum::inf;
+        return true;
+    }
+
+    /*
+     Run all generations, stopping early if a generation can't get
+     `n_particles` within `n_particles / min_accept` simulations (the
+     previous generation is kept).
+     Returns false if cancelled.
+     */
+    bool run(Progress& progress,
+             const size_t& grain_size,
+             ThreadUsage& usage);
+
+private:
+    MatType x0;
+    StatArray obs_stats;
+    ParArray lower;
+    ParArray upper;
+    size_t n_particles;
+    size_t n_gens;
+    double alpha;
+    double min_accept;
+    double season_len;
+    double dt;
+    size_t max_steps;
+    uint64_t master_seed;
+    SpatialNoise noise;
+    ParArray kernel_sd;
+    std::vector<double> cum_weights;
+
+    // Kernel SDs and cumulative weights from the last generation:
+    void prepare__() {
+        double cw = 0;
+        for (size_t i = 0; i < n_particles; i++) {
+            cw += weights(i);
+            cum_weights[i] = cw;
+        }
+        for (size_t j = 0; j < n_pars; j++) {
+            double mu = arma::accu(weights % theta.col(j));
+            double v = 0;
+            for (size_t i = 0; i < n_particles; i++) {
+                v += weights(i) * (theta(i,j) - mu) * (theta(i,j) - mu);
+            }
+            kernel_sd[j] = std::sqrt(2 * v);
+        }
+        return;
+    }
+
+    /*
+     Importance weights for new particles `new_theta` given the last
+     generation (uniform priors, so only the kernel density matters).
+     */
+    void new_weights__(const arma::mat& new_theta, arma::vec& new_w) const {
+        new_w.set_size(n_particles);
+        for (size_t i = 0; i < n_particles; i++) {
+            double dens = 0;
+            for (size_t l = 0; l < n_particles; l++) {
+                double ss = 0;
+                for (size_t j = 0; j < n_pars; j++) {
+                    // Parameters that don't vary don't affect weights:
+                    if (kernel_sd[j] <= 0) continue;
+                    double zj = (new_theta(i,j) - theta(l,j)) / kernel_sd[j];
+                    ss += zj * zj;
+                }
+                dens += weights(l) * std::exp(-0.5 * ss);
+            }
+            new_w(i) = 1 / dens;
+        }
+        new_w /= arma::accu(new_w);
+        return;
+    }
+};
+
+
+
+struct StochLandCFAbcWorker : public RcppParallel::Worker {
+
+    const StochLandCFAbc& abc;
+    size_t gen;
+    // Index of the first proposal in this batch:
+    size_t start;
+    std::vector<StochLandCFAbc::ParArray> theta;
+    std::vector<StochLandCFAbc::StatArray> stats;
+    std::vector<double> dist;
+    Progress& progress;
+
+    StochLandCFAbcWorker(const StochLandCFAbc& abc_,
+                         Progress& progress_)
+        : abc(abc_), gen(0), start(0), theta(), stats(), dist(),
+          progress(progress_) {};
+
+    void resize(const size_t& n) {
+        theta.resize(n);
+        stats.resize(n);
+        dist.resize(n);
+        return;
+    }
+
+    void operator()(size_t begin, size_t end) {
+        LandscapeConstF determ_sys(abc.determ_sys0);
+        MatType noise_work;
+        ProgressTicker ticker(progress, false);
+        for (size_t i = begin; i < end; i++) {
+            if (progress.cancelled()) break;
+            if (! abc.propose(gen, start + i, determ_sys, noise_work, ticker,
+                              theta[i], stats[i], dist[i])) break;
+        }
+        return;
+    }
+};
+
+
+
+inline bool StochLandCFAbc::run(Progress& progress,
+                                const size_t& grain_size,
+                                ThreadUsage& usage) {
+
+    StochLandCFAbcWorker worker(*this, progress);
+    size_t max_sims = static_cast<size_t>(std::ceil(
+        static_cast<double>(n_particles) / min_accept));
+    arma::mat new_theta(n_particles, n_pars);
+    arma::mat new_stats(n_particles, n_stats);
+    arma::vec new_dist(n_particles);
+    arma::vec new_w;
+    double rate = 1;
+
+    for (size_t gen = 0; gen < n_gens; gen++) {
+
+        double eps = arma::datum::inf;
+        if (gen > 0) {
+            arma::vec sorted = arma::sort(dist);
+            double a_n = alpha * static_cast<double>(n_particles);
+            size_t q = static_cast<size_t>(std::ceil(a_n - 1e-9));
+            eps = sorted(std::max(q, static_cast<size_t>(1U)) - 1U);
+            prepare__();
+            rate = std::min(rate, alpha);
+        }
+
+        /*
+         Proposals are simulated in batches sized from the last acceptance
+         rate, and accepted in order of their index, so which ones are
+         accepted doesn't depend on threads either.
+         */
+        size_t n_acc = 0, n_done = 0;
+        while (n_acc < n_particles && n_done < max_sims) {
+            double need = static_cast<double>(n_particles - n_acc);
+            size_t batch = static_cast<size_t>(std::ceil(
+                need / std::max(rate, min_accept)));
+            batch = std::min(batch, max_sims - n_done);
+            worker.gen = gen;
+            worker.start = n_done;
+            worker.resize(batch);
+            dynamic_parallel_for(worker, batch, grain_size, usage);
+            if (progress.cancelled()) return false;
+            for (size_t b = 0; b < batch && n_acc < n_particles; b++) {
+                if (! std::isfinite(worker.dist[b]) ||
+                    worker.dist[b] > eps) continue;
+                for (size_t j = 0; j < n_pars; j++) {
+                    new_theta(n_acc,j) = worker.theta[b][j];
+                }
+                for (size_t j = 0; j < n_stats; j++) {
+                    new_stats(n_acc,j) = worker.stats[b][j];
+                }
+                new_dist(n_acc) = worker.dist[b];
+                n_acc++;
+                progress.add_rep();
+            }
+            n_done += batch;
+            rate = static_cast<double>(n_acc) / static_cast<double>(n_done);
+        }
+        if (n_acc < n_particles) break;
+
+        if (gen == 0) {
+            new_w.set_size(n_particles);
+            new_w.fill(1 / static_cast<double>(n_particles));
+        } else new_weights__(new_theta, new_w);
+
+        theta = new_theta;
+        stats = new_stats;
+        dist = new_dist;
+        weights = new_w;
+        epsilons.push_back(eps);
+        accept_rates.push_back(rate);
+        n_sims.push_back(static_cast<double>(n_done));
+    }
+
+    return true;
+}
+
+
+
+/*
+ Posterior samples of `n_sigma`, `season_surv`, and `season_sigma` in
+ `landscape_constantF_stoch_ode` using ABC-SMC (see `StochLandCFAbc` above).
+ `obs_stats` are the observed dissimilarity and diversity among plants
+ (as from `dissimilarity` and `diversity`) at `max_t`, and `lower` and
+ `upper` are bounds of the uniform priors for the three parameters
+ (set both to the same value to fix one).
+ Without `season_len`, the season parameters have no effect, so fix them.
+ Returns the particles from the last generation with their summaries,
+ distances, and weights. Tolerances, acceptance rates, and numbers of
+ simulations for each generation are attributes.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_constantF_stoch_abc(const uint32_t& n_particles,
+                                            const std::vector<double>& m,
+                                            const std::vector<double>& d_yp,
+                                            const std::vector<double>& d_b0,
+                                            const std::vector<double>& d_bp,
+                                            const std::vector<double>& g_yp,
+                                            const std::vector<double>& g_b0,
+                                            const std::vector<double>& g_bp,
+                                            const std::vector<double>& L_0,
+                                            const double& u,
+                                            const double& X,
+                                            const std::vector<double>& Y0,
+                                            const std::vector<double>& B0,
+                                            const std::vector<double>& obs_stats,
+                                            const std::vector<double>& lower,
+                                            const std::vector<double>& upper,
+                                            const uint32_t& n_gens = 5,
+                                            const double& alpha = 0.5,
+                                            const double& min_accept = 0.01,
+                                            SEXP season_len = R_NilValue,
+                                            const double& dt = 0.1,
+                                            const double& max_t = 100.0,
+                                            const bool& show_progress = false,
+                                            SEXP seed = R_NilValue,
+                                            const uint32_t& grain_size = 1) {
+
+    bool err = lanscape_constF_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                          L_0, u, X, Y0, B0, dt, max_t);
+    double season_len_ = (season_len == R_NilValue) ? max_t + 1.0 : as<double>(season_len);
+    len_check(err, obs_stats, "obs_stats", StochLandCFAbc::n_stats);
+    len_check(err, lower, "lower", StochLandCFAbc::n_pars);
+    len_check(err, upper, "upper", StochLandCFAbc::n_pars);
+    if (err) return NumericMatrix(0,0);
+    // Bounds need to be valid values for each parameter:
+    constF_stoch_arg_checks(err, lower[0], season_len_, lower[1], lower[2],
+                            dt, max_t);
+    constF_stoch_arg_checks(err, upper[0], season_len_, upper[1], upper[2],
+                            dt, max_t);
+    for (size_t j = 0; j < StochLandCFAbc::n_pars; j++) {
+        if (lower[j] > upper[j]) {
+            Rcout << "lower should not be above upper!" << std::endl;
+            err = true;
+            break;
+        }
+    }
+    min_val_check(err, n_particles, "n_particles", 2);
+    min_val_check(err, n_gens, "n_gens", 1);
+    min_val_check(err, alpha, "alpha", 0, false);
+    max_val_check(err, alpha, "alpha", 1, false);
+    min_val_check(err, min_accept, "min_accept", 0, false);
+    max_val_check(err, min_accept, "min_accept", 1);
+    if (seed != R_NilValue) min_val_check(err, as<double>(seed), "seed", 0);
+    min_val_check(err, grain_size, "grain_size", 1);
+    if (err) return NumericMatrix(0,0);
+
+    MatType x0(m.size(), 2U);
+    for (size_t i = 0; i < m.size(); i++) {
+        x0(i,0) = Y0[i];
+        x0(i,1) = B0[i];
+    }
+    LandscapeConstF determ_sys0(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0,
+                                u, X);
+    StochLandCFAbc::StatArray obs_stats_;
+    StochLandCFAbc::ParArray lower_, upper_;
+    std::copy(obs_stats.begin(), obs_stats.end(), obs_stats_.begin());
+    std::copy(lower.begin(), lower.end(), lower_.begin());
+    std::copy(upper.begin(), upper.end(), upper_.begin());
+
+    StochLandCFAbc abc(determ_sys0, x0, obs_stats_, lower_, upper_,
+                       n_particles, n_gens, alpha, min_accept, season_len_,
+                       dt, max_t, make_master_seed(seed));
+
+    /*
+     Total simulations aren't known ahead of time, so only accepted
+     particles are shown as reps:
+     */
+    Progress progress(static_cast<uint64_t>(n_particles) * n_gens, 0U,
+                      show_progress);
+    ThreadUsage usage;
+    // Generations (and their batches) all run in another thread:
+    bool finished = progress.run_parallel([&]() {
+        abc.run(progress, grain_size, usage);
+    });
+    if (! finished) return NumericMatrix(0,0);
+    if (abc.epsilons.empty()) {
+        Rcout << "Fewer than n_particles simulations from the priors gave ";
+        Rcout << "finite summaries!" << std::endl;
+        return NumericMatrix(0,0);
+    }
+    if (abc.epsilons.size() < n_gens) {
+        Rcout << "Stopped after " << abc.epsilons.size() << " generations ";
+        Rcout << "because the acceptance rate fell below min_accept."<< std::endl;
+    }
+
+    NumericMatrix output(n_particles, 8U);
+    colnames(output) = CharacterVector::create("particle", "n_sigma",
+             "season_surv", "season_sigma", "dissimilarity", "diversity",
+             "distance", "weight");
+    for (size_t i = 0; i < n_particles; i++) {
+        output(i,0) = i + 1;
+        for (size_t j = 0; j < StochLandCFAbc::n_pars; j++) {
+            output(i,j+1U) = abc.theta(i,j);
+        }
+        output(i,4) = abc.stats(i,0);
+        output(i,5) = abc.stats(i,1);
+        output(i,6) = abc.dist(i);
+        output(i,7) = abc.weights(i);
+    }
+    output.attr("epsilon") = abc.epsilons;
+    output.attr("accept_rate") = abc.accept_rates;
+    output.attr("n_sims") = abc.n_sims;
+
     return output;
 }
@@ -1,168 +1,25 @@
-#define _USE_MATH_DEFINES
 
 
 #include <RcppArmadillo.h>
 #include <vector>
-#include <cmath>
 
 #include "landscape.h"
+#include "landscape_seasonal.h"
+#include "outcomes.h"
+#include "checkpoint.h"
+#include "cache.h"
+#include "progress.h"
+#include "rng.h"
 
 using namespace Rcpp;
 
 
 
 
-
-class SeasonalLandscape : public LandscapeSystemFunction
-{
-public:
-    arma::vec R_hat;
-    arma::vec par1;
-    arma::vec par2;
-    std::vector<char> distr_types;
-
-    SeasonalLandscape(const std::vector<double>& m_,
-                      const std::vector<double>& d_yp_,
-                      const std::vector<double>& d_b0_,
-                      const std::vector<double>& d_bp_,
-                      const std::vector<double>& g_yp_,
-                      const std::vector<double>& g_b0_,
-                      const std::vector<double>& g_bp_,
-                      const std::vector<double>& L_0_,
-                      const std::vector<double>& P_max_,
-                      const double& u_,
-                      const double& q_,
-                      const std::vector<double>& W_,
-                      const double& w_,
-                      const arma::mat& z_,
-                      const double& min_F_for_P_,
-                      const std::vector<double>& R_hat_,
-                      const std::vector<double>& par1_,
-                      const std::vector<double>& par2_,
-                      const std::vector<char>& distr_types_,
-                      const std::vector<double>& Y0_,
-                      const std::vector<double>& B0_,
-                      const double& add_F_)
-        : LandscapeSystemFunction(m_, d_yp_, d_b0_, d_bp_, g_yp_, g_b0_, g_bp_,
-                                  L_0_, P_max_, u_, q_, W_, w_, z_, min_F_for_P_),
-          R_hat(arma::conv_to<arma::vec>::from(R_hat_)),
-          par1(arma::conv_to<arma::vec>::from(par1_)),
-          par2(arma::conv_to<arma::vec>::from(par2_)),
-          distr_types(distr_types_),
-          Y0(arma::conv_to<arma::vec>::from(Y0_)),
-          B0(arma::conv_to<arma::vec>::from(B0_)),
-          add_F(add_F_),
-          YB_added(z_.n_rows, false) {
-
-        for (size_t i = 0; i < n_plants; i++) {
-            // No reason to add these if these are set to zero:
-            if ((Y0(i) + B0(i)) == 0) YB_added[i] = true;
-        }
-
-    };
-
-
-    void operator()(const MatType& x,
-                    MatType& dxdt,
-                    const double t) {
-
-        LandscapeSystemFunction::make_weights(this->weights, x);
-        make_R(t);
-        LandscapeSystemFunction::all_but_R(x, dxdt, t);
-
-        for (size_t i = 0; i < n_plants; i++) {
-            if (F(i) >= add_F && ! YB_added[i]) {
-                const double& N(x(i,2));
-                double& dYdt = dxdt(i,0);
-                double& dBdt = dxdt(i,1);
-                double& dNdt = dxdt(i,2);
-                // note: using 'N + dNdt' below to avoid N going < 0
-                double y0_i = (N + dNdt) * Y0(i);
-                double b0_i = (N + dNdt) * B0(i);
-                dYdt += y0_i;
-                dBdt += b0_i;
-                dNdt -= (y0_i + b0_i);
-                YB_added[i] = true;
-            }
-        }
-
-
-        return;
-    }
-
-    void make_weights(arma::vec& wts_vec,
-                      const MatType& x) {
-        LandscapeSystemFunction::make_weights(wts_vec, x);
-    }
-
-
-
-private:
-    arma::vec Y0;
-    arma::vec B0;
-    double add_F;
-    std::vector<bool> YB_added;
-    const double sqrt_2pi = std::sqrt(2 * M_PI);
-
-
-    void make_R(const double& t) {
-
-        for (size_t i = 0; i < n_plants; i++) {
-            const char& dtype(distr_types[i]);
-            switch (dtype) {
-            case 'N':
-                // normal
-                normal_R(t, i);
-                break;
-            case 'W':
-                // weibull
-                weibull_R(t, i);
-                break;
-            case 'L':
-                // lognormal
-                lognormal_R(t, i);
-                break;
-            default:
-                // revert to normal
-                normal_R(t, i);
-                break;
-            }
-        }
-    }
-
-
-    inline void normal_R(const double& t, const size_t& i) {
-        const double& mu(par1(i));
-        const double& sigma(par2(i));
-        double tmp = (t - mu) / sigma;
-        R(i) = (R_hat(i) / (sigma * sqrt_2pi)) *
-            std::exp(-0.5 * (tmp*tmp));
-        return;
-    }
-
-    inline void weibull_R(const double& t, const size_t& i) {
-        const double& lambda(par1(i));
-        const double& k(par2(i));
-        R(i) = R_hat(i) * (k / lambda) * std::pow(t / lambda, k-1) *
-            std::exp(- std::pow(t / lambda, k));
-        return;
-    }
-
-    inline void lognormal_R(const double& t, const size_t& i) {
-        const double& mu(par1(i));
-        const double& sigma(par2(i));
-        double tmp = std::log(t) - mu;
-        R(i) = (R_hat(i) / (t * sigma * sqrt_2pi)) *
-            std::exp(- (tmp*tmp) / (2 * sigma * sigma));
-        return;
-    }
-
-};
-
-
-
-
-
+/*
+ If `cache_dir` (an existing directory) is provided, results are saved
+ there and re-used by later calls with identical inputs (see cache.h).
+ */
 //' @export
 // [[Rcpp::export]]
 NumericMatrix landscape_season_ode(const std::vector<double>& m,
@@ -188,7 +45,17 @@ NumericMatrix landscape_season_ode(const std::vector<double>& m,
                                    const std::vector<double>& B0,
                                    const double& add_F = 1.0,
                                    const double& dt = 0.1,
-                                   const double& max_t = 90.0) {
+                                   const double& max_t = 90.0,
+                                   const bool& single_prec = false,
+                                   const bool& outcomes_only = false,
+                                   const double& threshold = 1e-6,
+                                   const double& outcome_window = 0,
+                                   const bool& by_plant = false,
+                                   const std::string& checkpoint_file = "",
+                                   const double& checkpoint_every = 0,
+                                   const bool& resume = false,
+                                   const bool& show_progress = false,
+                                   const std::string& cache_dir = "") {
 
     size_t np = z.n_rows;
     /*
@@ -198,37 +65,36 @@ NumericMatrix landscape_season_ode(const std::vector<double>& m,
     bool err = lanscape_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
                                    L_0, P_max, u, q, W, w, z, min_F_for_P,
                                    Y0, B0, dt, max_t);
-    len_check(err, R_hat, "R_hat", np);
-    len_check(err, par1, "par1", np);
-    len_check(err, par2, "par2", np);
-    len_check(err, distr_types, "distr_types", np);
-    min_val_check(err, R_hat, "R_hat", 0, false);
-    min_val_check(err, par1, "par1", 0, false);
-    min_val_check(err, par2, "par2", 0, false);
     std::vector<char> distr_types_char;
-    distr_types_char.reserve(np);
-    std::string d;
-    for (size_t i = 0; i < distr_types.size(); i++) {
-        d = distr_types(i);
-        if (d != "N" && d != "W" && d != "L") {
-            Rcout << "distr_types must only contain 'N', 'W', or 'L'. ";
-            Rcout << "Yours contains at least one '" << d << "'." << std::endl;
-            err = true;
-            break;
-        }
-        distr_types_char.push_back(d[0]);
-    }
-    min_val_check(err, add_F, "add_F", 0, false);
-    for (size_t i = 0; i < std::min(B0.size(), Y0.size()); i++) {
-        if ((Y0[i] + B0[i]) > add_F) {
-            Rcout << "Y0+B0 must always be <= `add_F`." << std::endl;
-            err = true;
-            break;
-        }
-    }
+    landscape_season_arg_checks(err, np, R_hat, par1, par2, distr_types,
+                                distr_types_char, add_F, Y0, B0);
+    outcome_arg_checks(err, threshold, outcome_window);
+    size_t checkpoint_steps = checkpoint_arg_checks(err, checkpoint_file,
+                                                    checkpoint_every, dt);
     if (err) return NumericMatrix(0,0);
 
 
+    /*
+     Checkpoints can only be used to resume runs with identical inputs,
+     and cached results are looked up by the same hash:
+     */
+    InputHash hash;
+    if (! checkpoint_file.empty() || ! cache_dir.empty()) {
+        hash.add(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max, u, q, W,
+                 w, z, min_F_for_P, R_hat, par1, par2, distr_types_char,
+                 Y0, B0, add_F, dt, max_t, single_prec, outcomes_only,
+                 threshold, outcome_window);
+    }
+    const std::string engine("landscape_season_ode");
+
+    // (`by_plant` only changes output, so it's only needed for the cache)
+    InputHash cache_hash(hash);
+    cache_hash.add(by_plant);
+    ResultCache cache(cache_dir, engine, cache_hash);
+    NumericMatrix output;
+    if (cache.load(output)) return output;
+
+
     MatType x(np, 3);
     for (size_t i = 0; i < np; i++) {
         x(i,0) = 0.0;  // Y
@@ -237,33 +103,243 @@ NumericMatrix landscape_season_ode(const std::vector<double>& m,
     }
 
 
-    Observer<MatType> obs;
     SeasonalLandscape system(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max,
                              u, q, W, w, z, min_F_for_P,
                              R_hat, par1, par2, distr_types_char,
-                             Y0, B0, add_F);
-
-    boost::numeric::odeint::integrate_const(
-        MatStepperType(), std::ref(system),
-        x, 0.0, max_t, dt, std::ref(obs));
-
-    size_t n_steps = obs.data.size();
-    NumericMatrix output(n_steps * np, 6);
-    colnames(output) = CharacterVector::create("t", "p", "Y", "B", "N", "P");
-    arma::vec wts(np);
-    size_t i = 0;
-    for (size_t t = 0; t < n_steps; t++) {
-        system.make_weights(wts, obs.data[t]);
-        for (size_t k = 0; k < np; k++) {
-            output(i,0) = obs.time[t];
-            output(i,1) = k;
-            output(i,2) = obs.data[t](k, 0);
-            output(i,3) = obs.data[t](k, 1);
-            output(i,4) = obs.data[t](k, 2);
-            output(i,5) = P_max[k] * wts(k);
-            i++;
+                             Y0, B0, add_F, single_prec);
+
+
+    if (outcomes_only) {
+        OutcomeTracker tracker(np, threshold, max_t - outcome_window);
+        if (! integrate_checkpoint(system, x, dt, max_t, tracker,
+                                   checkpoint_file, checkpoint_steps,
+                                   resume, engine, hash.value,
+                                   show_progress)) {
+            return NumericMatrix(0,0);
         }
+        output = outcome_output(tracker, by_plant);
+    } else if (single_prec) {
+        ObserverP<SeasonalLandscape, arma::fmat> obs(system);
+        if (! integrate_checkpoint(system, x, dt, max_t, obs,
+                                   checkpoint_file, checkpoint_steps,
+                                   resume, engine, hash.value,
+                                   show_progress)) {
+            return NumericMatrix(0,0);
+        }
+        output = landscape_output(obs);
+    } else {
+        ObserverP<SeasonalLandscape> obs(system);
+        if (! integrate_checkpoint(system, x, dt, max_t, obs,
+                                   checkpoint_file, checkpoint_steps,
+                                   resume, engine, hash.value, show_progress)) {
+            return NumericMatrix(0,0);
+        }
+        output = landscape_output(obs);
+    }
 
+    cache.store(output);
+
+    return output;
+}
+
+
+
+
+
+/*
+ Observer for runs of multiple seasons that only keeps running sums (for
+ means within a season) of Y, B, N, and P for each plant.
+ */
+template< class L >
+struct SeasonSummaryObs
+{
+    arma::mat sums;
+    size_t n_obs;
+
+    SeasonSummaryObs(L& system_)
+        : sums(), n_obs(0), system(system_), P_tmp() {};
+
+    void reset(const size_t& n_plants) {
+        sums.zeros(n_plants, 4U);
+        n_obs = 0;
+        return;
     }
+
+    void operator()(const MatType& x, const double& t) {
+        if (system.P_at(t)) {
+            system.last_P(P_tmp);
+        } else system.make_P(P_tmp, x);
+        for (size_t i = 0; i < x.n_rows; i++) {
+            for (size_t j = 0; j < 3U; j++) sums(i,j) += x(i,j);
+            sums(i,3) += P_tmp(i);
+        }
+        n_obs++;
+        return;
+    }
+
+private:
+    L& system;
+    arma::vec P_tmp;
+};
+
+
+
+/*
+ Multiple seasons of the seasonal landscape in one call.
+ Each season starts with no flowers and runs from t = 0 to `max_t`.
+ Y and B surviving from the end of one season (proportions of flowers at
+ each plant, times `season_surv`) are added as the next season's `Y0` and
+ `B0`. `Y0` and `B0` are only used for the first season.
+ Flowering time (`par1`) and size (`R_hat`) can optionally be redrawn each
+ season (normal with SD `phen_sd`, truncated at zero, and lognormal with
+ log-scale SD `R_hat_sd` and the same mean, respectively).
+ Returns one row per season and plant.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_multiseason_ode(const std::vector<double>& m,
+                                        const std::vector<double>& d_yp,
+                                        const std::vector<double>& d_b0,
+                                        const std::vector<double>& d_bp,
+                                        const std::vector<double>& g_yp,
+                                        const std::vector<double>& g_b0,
+                                        const std::vector<double>& g_bp,
+                                        const std::vector<double>& L_0,
+                                        const std::vector<double>& P_max,
+                                        const double& u,
+                                        const double& q,
+                                        const std::vector<double>& W,
+                                        const std::vector<double>& R_hat,
+                                        const std::vector<double>& par1,
+                                        const std::vector<double>& par2,
+                                        const StringVector& distr_types,
+                                        const double& w,
+                                        const arma::mat& z,
+                                        const double& min_F_for_P,
+                                        const std::vector<double>& Y0,
+                                        const std::vector<double>& B0,
+                                        const uint32_t& n_seasons,
+                                        const double& season_surv = 0.01,
+                                        const double& phen_sd = 0,
+                                        const double& R_hat_sd = 0,
+                                        const double& add_F = 1.0,
+                                        const double& dt = 0.1,
+                                        const double& max_t = 90.0,
+                                        const bool& show_progress = false,
+                                        SEXP seed = R_NilValue) {
+
+    size_t np = z.n_rows;
+    /*
+     I can't just use 'stop()' because it causes a segfault (or similar).
+     The system below is my workaround.
+     */
+    bool err = lanscape_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                   L_0, P_max, u, q, W, w, z, min_F_for_P,
+                                   Y0, B0, dt, max_t);
+    std::vector<char> distr_types_char;
+    landscape_season_arg_checks(err, np, R_hat, par1, par2, distr_types,
+                                distr_types_char, add_F, Y0, B0);
+    min_val_check(err, n_seasons, "n_seasons", 1);
+    min_val_check(err, season_surv, "season_surv", 0);
+    max_val_check(err, season_surv, "season_surv", 1);
+    min_val_check(err, phen_sd, "phen_sd", 0);
+    min_val_check(err, R_hat_sd, "R_hat_sd", 0);
+    if (seed != R_NilValue) min_val_check(err, as<double>(seed), "seed", 0);
+    if (err) return NumericMatrix(0,0);
+
+
+    SeasonalLandscape system(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max,
+                             u, q, W, w, z, min_F_for_P,
+                             R_hat, par1, par2, distr_types_char,
+                             Y0, B0, add_F, false);
+
+    // Only needed (and R's RNG only used) if phenology is redrawn:
+    pcg32 rng;
+    const ZigguratTables& zt(zig_tables());
+    if (phen_sd > 0 || R_hat_sd > 0) seed_rep_rng(rng, make_master_seed(seed), 0);
+    const arma::vec par1_0(system.par1);
+    const arma::vec R_hat_0(system.R_hat);
+
+    arma::vec Y0_s = arma::conv_to<arma::vec>::from(Y0);
+    arma::vec B0_s = arma::conv_to<arma::vec>::from(B0);
+    MatType x(np, 3);
+
+    NumericMatrix output(n_seasons * np, 13U);
+    colnames(output) = CharacterVector::create("season", "p", "Y0", "B0",
+             "par1", "R_hat", "Y_mean", "B_mean", "N_mean", "P_mean",
+             "Y_end", "B_end", "N_end");
+
+    SeasonSummaryObs<SeasonalLandscape> obs(system);
+    auto no_save = [](const size_t& /* step_ */) {};
+    Progress progress(n_seasons, n_seasons * n_const_steps(dt, max_t),
+                      show_progress);
+
+    size_t k = 0;
+    for (size_t s = 0; s < n_seasons; s++) {
+
+        // Phenology for this season:
+        for (size_t i = 0; i < np; i++) {
+            if (phen_sd > 0) {
+                double par1_i;
+                do {
+                    par1_i = par1_0(i) + phen_sd * zig_normal(rng, zt);
+                } while (par1_i <= 0);
+                system.par1(i) = par1_i;
+            }
+            if (R_hat_sd > 0) {
+                system.R_hat(i) = R_hat_0(i) *
+                    std::exp(R_hat_sd * zig_normal(rng, zt) -
+                             0.5 * R_hat_sd * R_hat_sd);
+            }
+        }
+        system.new_season(Y0_s, B0_s);
+        x.zeros();
+        obs.reset(np);
+
+        CheckpointStepper stepper;
+        size_t step = 0;
+        bool finished;
+        {
+            ProgressTicker ticker(progress, true);
+            finished = integrate_const_from(stepper, std::ref(system), x, step,
+                                            dt, max_t, obs, 0U, no_save,
+                                            ticker);
+        }
+        if (! finished) break;
+        progress.add_rep();
+
+        double n_obs = static_cast<double>(obs.n_obs);
+        for (size_t i = 0; i < np; i++) {
+            output(k,0) = s + 1;
+            output(k,1) = i;
+            output(k,2) = Y0_s(i);
+            output(k,3) = B0_s(i);
+            output(k,4) = system.par1(i);
+            output(k,5) = system.R_hat(i);
+            for (size_t j = 0; j < 4U; j++) output(k,j+6U) = obs.sums(i,j) / n_obs;
+            for (size_t j = 0; j < 3U; j++) output(k,j+10U) = x(i,j);
+            k++;
+        }
+
+        // What survives to be added next season:
+        double F, Y0_i, B0_i;
+        for (size_t i = 0; i < np; i++) {
+            F = x(i,0) + x(i,1) + x(i,2);
+            Y0_i = F > 0 ? season_surv * x(i,0) / F : 0;
+            B0_i = F > 0 ? season_surv * x(i,1) / F : 0;
+            // These can't sum to more than `add_F` (see `landscape_season_ode`):
+            if ((Y0_i + B0_i) > add_F) {
+                double scale = add_F / (Y0_i + B0_i);
+                Y0_i *= scale;
+                B0_i *= scale;
+            }
+            Y0_s(i) = Y0_i;
+            B0_s(i) = B0_i;
+        }
+
+    }
+
+    if (! progress.finish()) return NumericMatrix(0,0);
+
     return output;
 }
@@ -0,0 +1,566 @@
+
+
+/*
+ Stochastic versions of the landscapes with flower dynamics
+ (`NonSeasonalLandscape` and `SeasonalLandscape`), with many reps run
+ in parallel.
+
+ Noise is in colonization only, so it doesn't change the number of flowers
+ at a plant (F = Y + B + N).
+ For proportions of flowers colonized by yeast (y = Y / F) and bacteria
+ (b = B / F), it's the same as in `landscape_constantF_stoch_ode`
+ (e.g., the standard deviation of noise for y is `sqrt(y * (1 - y) / n_sigma)`),
+ and what's added to Y and B is removed from N.
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <cmath>
+
+#include "landscape.h"
+#include "landscape_seasonal.h"
+#include "outcomes.h"
+#include "checkpoint.h"
+#include "progress.h"
+
+#include <RcppParallel.h>
+#include <pcg_random.hpp>
+
+#include "rng.h"
+#include "spatial_noise.h"
+#include "scheduler.h"
+
+
+using namespace Rcpp;
+
+
+
+// Stepper for the stochastic landscape (Euler-Maruyama):
+class StochFLandscapeStepper
+{
+public:
+
+    typedef boost::numeric::odeint::stepper_tag stepper_category;
+
+    static unsigned short order( void ) { return 1; }
+
+    StochFLandscapeStepper(const size_t& n_plants)
+        : det(n_plants, 3U),
+          stoch(n_plants, 3U) {}
+
+    template< class System >
+    void do_step(System system, MatType& x, double t, double dt) {
+        system.first(x, det, t);
+        system.second(x, stoch);
+        double sqrt_dt = std::sqrt(dt);
+        for (size_t i = 0 ; i < x.n_rows ; i++) {
+            for (size_t j = 0 ; j < x.n_cols ; j++) {
+                x(i,j) += dt * det(i,j) + sqrt_dt * stoch(i,j);
+                if (x(i,j) < 0) x(i,j) = 0;
+            }
+        }
+        return;
+    }
+
+private:
+    MatType det;
+    MatType stoch;
+};
+
+
+
+
+// Stochastic process of the stochastic landscape
+struct StochFLandscapeStochProcess
+{
+    pcg32& m_rng;
+    double n_sigma;
+    const SpatialNoise& noise;
+    // Standard normals for Y and B (n_plants x 2) and scratch space for them:
+    MatType& z;
+    MatType& work;
+
+    StochFLandscapeStochProcess(pcg32& rng,
+                                double n_sigma_,
+                                const SpatialNoise& noise_,
+                                MatType& z_,
+                                MatType& work_)
+        : m_rng(rng),
+          n_sigma(n_sigma_),
+          noise(noise_),
+          z(z_),
+          work(work_) {}
+
+    void operator()(const MatType &x, MatType &dxdt) {
+
+        noise.fill(z, m_rng, work);
+
+        double F, p, stdev;
+
+        for (size_t i = 0 ; i < x.n_rows ; i++) {
+            F = x(i,0) + x(i,1) + x(i,2);
+            if (F <= 0) {
+                for (size_t j = 0 ; j < 3U ; j++) dxdt(i,j) = 0;
+                continue;
+            }
+            for (size_t j = 0 ; j < 2U ; j++) {
+                p = x(i,j) / F;
+                stdev = F * std::sqrt(std::max(p * (1 - p), 0.0) / n_sigma);
+                dxdt(i,j) = stdev * z(i,j);
+            }
+            dxdt(i,2) = -1 * (dxdt(i,0) + dxdt(i,1));
+        }
+
+        return;
+    }
+};
+
+
+
+
+/*
+ RcppParallel Worker to do runs for a single thread.
+ `L` is the landscape system. Each rep gets its own copy of `system0`
+ (with its own workspace), but all copies share the same Phi matrix.
+ */
+template< class L >
+struct StochLandscapeWorker : public RcppParallel::Worker {
+
+    /*
+     Y, B, N, and P for each rep (rows are plants within time points), stored
+     either in double (`output`) or single (`output_f`) precision.
+     The matching rep, time, and plant columns are filled in afterwards.
+     */
+    std::vector<MatType> output;
+    std::vector<arma::fmat> output_f;
+    std::vector<std::vector<double>> times;
+    // Used instead of the above when only outcomes are returned:
+    std::vector<OutcomeTracker> outcomes;
+    // Each rep's RNG is seeded from this and its index (see rng.h):
+    uint64_t master_seed;
+    MatType x0;
+    L system0;
+    double n_sigma;
+    // Factored correlations among plants (shared by all threads):
+    SpatialNoise noise;
+    double dt;
+    double max_t;
+    bool single_prec;
+    bool outcomes_only;
+    bool by_plant;
+    // Shared progress counters and cancellation flag:
+    Progress& progress;
+
+    StochLandscapeWorker(const uint32_t& n_reps,
+                         const L& system0_,
+                         const MatType& x0_,
+                         const double& n_sigma_,
+                         const SpatialNoise& noise_,
+                         const uint64_t& master_seed_,
+                         const double& dt_,
+                         const double& max_t_,
+                         const bool& single_prec_,
+                         const bool& outcomes_only_,
+                         const double& threshold,
+                         const double& outcome_window,
+                         const bool& by_plant_,
+                         Progress& progress_)
+        : output((single_prec_ || outcomes_only_ ? 0U : n_reps), MatType(0,0)),
+          output_f((single_prec_ && ! outcomes_only_ ? n_reps : 0U),
+                   arma::fmat(0,0)),
+          times(outcomes_only_ ? 0U : n_reps),
+          outcomes((outcomes_only_ ? n_reps : 0U),
+                   OutcomeTracker(x0_.n_rows, threshold,
+                                  max_t_ - outcome_window)),
+          master_seed(master_seed_),
+          x0(x0_),
+          system0(system0_),
+          n_sigma(n_sigma_),
+          noise(noise_),
+          dt(dt_),
+          max_t(max_t_),
+          single_prec(single_prec_),
+          outcomes_only(outcomes_only_),
+          by_plant(by_plant_),
+          progress(progress_) {};
+
+    void operator()(size_t begin, size_t end) {
+        if (outcomes_only) {
+            do_outcome_reps(begin, end);
+        } else if (single_prec) {
+            do_reps(begin, end, output_f);
+        } else do_reps(begin, end, output);
+        return;
+    }
+
+
+    // Fill final output from stored reps:
+    void fill_output(NumericMatrix& out) const {
+        if (outcomes_only) {
+            fill_outcomes__(out);
+        } else if (single_prec) {
+            fill_output__(out, output_f);
+        } else fill_output__(out, output);
+        return;
+    }
+
+
+private:
+
+    // `S` is the type Y, B, N, and P are stored as for each rep
+    template< class S >
+    void do_reps(size_t begin, size_t end, std::vector<S>& out) {
+
+        pcg32 rng;
+        const size_t np = x0.n_rows;
+        MatType x, z, work;
+
+        for (size_t rep = begin; rep < end; rep++) {
+
+            if (progress.cancelled()) break;
+            L system(system0);
+            ObserverP<L, S> obs(system);
+            if (! run_rep__(rep, rng, x, z, work, system, obs)) continue;
+            obs.finish();
+
+            size_t n_steps = obs.data.size();
+            out[rep].set_size(n_steps * np, 4U);
+            times[rep] = obs.time;
+            size_t i = 0;
+            for (size_t t = 0; t < n_steps; t++) {
+                const S& x_t(obs.data[t]);
+                for (size_t k = 0; k < np; k++) {
+                    out[rep](i,0) = x_t(k,0);
+                    out[rep](i,1) = x_t(k,1);
+                    out[rep](i,2) = x_t(k,2);
+                    out[rep](i,3) = obs.P[t](k);
+                    i++;
+                }
+
+            }
+
+        }
+        return;
+    }
+
+    // Same as above, but only keeping track of outcomes:
+    void do_outcome_reps(size_t begin, size_t end) {
+
+        pcg32 rng;
+        MatType x, z, work;
+
+        for (size_t rep = begin; rep < end; rep++) {
+            if (progress.cancelled()) break;
+            L system(system0);
+            outcomes[rep].reset();
+            run_rep__(rep, rng, x, z, work, system, outcomes[rep]);
+        }
+        return;
+    }
+
+    // Simulate one rep. Returns false if the run was cancelled.
+    template< class Obs >
+    bool run_rep__(const size_t& rep,
+                   pcg32& rng,
+                   MatType& x,
+                   MatType& z,
+                   MatType& work,
+                   L& system,
+                   Obs& obs) {
+
+        seed_rep_rng(rng, master_seed, rep);
+        x = x0;
+        z.set_size(x0.n_rows, 2U);
+        size_t step = 0;
+
+        /*
+         The deterministic part is passed by reference so it isn't copied
+         every step, and so that observers see the weights calculated
+         inside it.
+         */
+        StochFLandscapeStepper stepper(x0.n_rows);
+        ProgressTicker ticker(progress, false);
+        auto no_save = [](const size_t& /* step_ */) {};
+        bool finished = integrate_const_from(
+            stepper,
+            std::pair<L&, StochFLandscapeStochProcess>(
+                system,
+                StochFLandscapeStochProcess(rng, n_sigma, noise, z, work)),
+            x, step, dt, max_t, obs, 0U, no_save, ticker);
+        if (! finished) return false;
+        progress.add_rep();
+
+        return true;
+    }
+
+    template< class S >
+    void fill_output__(NumericMatrix& output, const std::vector<S>& out) const {
+
+        const size_t np = x0.n_rows;
+        size_t n_rows = 0;
+        for (const S& m : out) n_rows += m.n_rows;
+
+        output = NumericMatrix(n_rows, 7U);
+        colnames(output) = CharacterVector::create("rep", "t", "p", "Y", "B",
+                 "N", "P");
+        size_t i = 0;
+        for (size_t rep = 0; rep < out.size(); rep++) {
+            const S& m(out[rep]);
+            double dbl_rep = static_cast<double>(rep) + 1;
+            for (size_t k = 0; k < m.n_rows; k++) {
+                output(i,0) = dbl_rep;
+                output(i,1) = times[rep][k / np];
+                output(i,2) = k % np;
+                for (size_t j = 0; j < m.n_cols; j++) {
+                    output(i,j+3U) = m(k,j);
+                }
+                i++;
+            }
+
+        }
+        return;
+    }
+
+    void fill_outcomes__(NumericMatrix& output) const {
+
+        size_t n_rows = 0;
+        for (const OutcomeTracker& o : outcomes) n_rows += o.n_rows(by_plant);
+
+        output = NumericMatrix(n_rows, by_plant ? 7U : 6U);
+        colnames(output) = outcome_colnames(by_plant, true);
+        size_t i = 0, i0;
+        for (size_t rep = 0; rep < outcomes.size(); rep++) {
+            i0 = i;
+            outcomes[rep].fill_output(output, i, 1U, by_plant);
+            double dbl_rep = static_cast<double>(rep) + 1;
+            for (; i0 < i; i0++) output(i0,0) = dbl_rep;
+        }
+        return;
+    }
+};
+
+
+
+/*
+ Everything after argument checks that's shared by both stochastic
+ landscapes: setting up noise and seeds, running all reps, and making
+ the output.
+ */
+template< class L >
+inline NumericMatrix landscape_stoch_runs(const uint32_t& n_reps,
+                                          const L& system,
+                                          const MatType& x0,
+                                          const double& n_sigma,
+                                          const double& dt,
+                                          const double& max_t,
+                                          const bool& single_prec,
+                                          const bool& outcomes_only,
+                                          const double& threshold,
+                                          const double& outcome_window,
+                                          const bool& by_plant,
+                                          const bool& show_progress,
+                                          SEXP seed,
+                                          SEXP noise_z,
+                                          const double& noise_w,
+                                          SEXP noise_vcv,
+                                          const uint32_t& noise_rank,
+                                          const uint32_t& grain_size,
+                                          const bool& thread_stats) {
+
+    bool err = false;
+    min_val_check(err, n_sigma, "n_sigma", 0, false);
+    if (seed != R_NilValue) min_val_check(err, as<double>(seed), "seed", 0);
+    min_val_check(err, grain_size, "grain_size", 1);
+    // Correlations among plants for noise (if requested):
+    arma::mat noise_C;
+    bool corr_noise = noise_corr_mat(noise_C, err, noise_z, noise_w, noise_vcv,
+                                     x0.n_rows);
+    if (err) return NumericMatrix(0,0);
+
+    // Factored once here, then shared by all reps:
+    SpatialNoise noise;
+    if (corr_noise && ! noise.factor(noise_C, noise_rank)) {
+        Rcout << "Correlation matrix for noise is not positive semi-definite!";
+        Rcout << std::endl;
+        return NumericMatrix(0,0);
+    }
+
+    // Each rep's RNG is seeded from this and the rep's index:
+    uint64_t master_seed = make_master_seed(seed);
+
+    Progress progress(n_reps, n_reps * n_const_steps(dt, max_t), show_progress);
+
+    StochLandscapeWorker<L> worker(n_reps, system, x0, n_sigma, noise,
+                                   master_seed, dt, max_t, single_prec,
+                                   outcomes_only, threshold, outcome_window,
+                                   by_plant, progress);
+
+    // Reps are handed to threads `grain_size` at a time (see scheduler.h):
+    ThreadUsage usage;
+    // Running in another thread lets this one check for interrupts:
+    bool finished = progress.run_parallel([&]() {
+        dynamic_parallel_for(worker, n_reps, grain_size, usage);
+    });
+    if (! finished) return NumericMatrix(0,0);
+
+    NumericMatrix output;
+    worker.fill_output(output);
+    if (thread_stats) output.attr("thread_stats") = usage.output();
+
+    return output;
+}
+
+
+
+
+
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_stoch_ode(const uint32_t& n_reps,
+                                  const std::vector<double>& m,
+                                  const std::vector<double>& R,
+                                  const std::vector<double>& d_yp,
+                                  const std::vector<double>& d_b0,
+                                  const std::vector<double>& d_bp,
+                                  const std::vector<double>& g_yp,
+                                  const std::vector<double>& g_b0,
+                                  const std::vector<double>& g_bp,
+                                  const std::vector<double>& L_0,
+                                  const std::vector<double>& P_max,
+                                  const double& u,
+                                  const double& q,
+                                  const std::vector<double>& W,
+                                  const double& w,
+                                  const arma::mat& z,
+                                  const double& min_F_for_P,
+                                  const std::vector<double>& Y0,
+                                  const std::vector<double>& B0,
+                                  const std::vector<double>& N0,
+                                  const double& n_sigma,
+                                  const double& dt = 0.1,
+                                  const double& max_t = 90.0,
+                                  const bool& single_prec = false,
+                                  const bool& outcomes_only = false,
+                                  const double& threshold = 1e-6,
+                                  const double& outcome_window = 0,
+                                  const bool& by_plant = false,
+                                  const bool& show_progress = false,
+                                  SEXP seed = R_NilValue,
+                                  SEXP noise_z = R_NilValue,
+                                  const double& noise_w = 1,
+                                  SEXP noise_vcv = R_NilValue,
+                                  const uint32_t& noise_rank = 0,
+                                  const uint32_t& grain_size = 1,
+                                  const bool& thread_stats = false) {
+
+    size_t np = z.n_rows;
+    /*
+     I can't just use 'stop()' because it causes a segfault (or similar).
+     The system below is my workaround.
+     */
+    bool err = lanscape_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                   L_0, P_max, u, q, W, w, z, min_F_for_P,
+                                   Y0, B0, dt, max_t);
+    len_check(err, R, "R", np);
+    len_check(err, N0, "N0", np);
+    min_val_check(err, R, "R", 0);
+    min_val_check(err, N0, "N0", 0);
+    outcome_arg_checks(err, threshold, outcome_window);
+    if (err) return NumericMatrix(0,0);
+
+    MatType x0(np, 3);
+    for (size_t i = 0; i < np; i++) {
+        x0(i,0) = Y0[i];
+        x0(i,1) = B0[i];
+        x0(i,2) = N0[i];
+    }
+
+    NonSeasonalLandscape system(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                L_0, P_max, u, q, W, w, z, min_F_for_P, R,
+                                single_prec);
+
+    return landscape_stoch_runs(n_reps, system, x0, n_sigma, dt, max_t,
+                                single_prec, outcomes_only, threshold,
+                                outcome_window, by_plant, show_progress,
+                                seed, noise_z, noise_w, noise_vcv, noise_rank,
+                                grain_size, thread_stats);
+}
+
+
+
+
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_season_stoch_ode(const uint32_t& n_reps,
+                                         const std::vector<double>& m,
+                                         const std::vector<double>& d_yp,
+                                         const std::vector<double>& d_b0,
+                                         const std::vector<double>& d_bp,
+                                         const std::vector<double>& g_yp,
+                                         const std::vector<double>& g_b0,
+                                         const std::vector<double>& g_bp,
+                                         const std::vector<double>& L_0,
+                                         const std::vector<double>& P_max,
+                                         const double& u,
+                                         const double& q,
+                                         const std::vector<double>& W,
+                                         const std::vector<double>& R_hat,
+                                         const std::vector<double>& par1,
+                                         const std::vector<double>& par2,
+                                         const StringVector& distr_types,
+                                         const double& w,
+                                         const arma::mat& z,
+                                         const double& min_F_for_P,
+                                         const std::vector<double>& Y0,
+                                         const std::vector<double>& B0,
+                                         const double& n_sigma,
+                                         const double& add_F = 1.0,
+                                         const double& dt = 0.1,
+                                         const double& max_t = 90.0,
+                                         const bool& single_prec = false,
+                                         const bool& outcomes_only = false,
+                                         const double& threshold = 1e-6,
+                                         const double& outcome_window = 0,
+                                         const bool& by_plant = false,
+                                         const bool& show_progress = false,
+                                         SEXP seed = R_NilValue,
+                                         SEXP noise_z = R_NilValue,
+                                         const double& noise_w = 1,
+                                         SEXP noise_vcv = R_NilValue,
+                                         const uint32_t& noise_rank = 0,
+                                         const uint32_t& grain_size = 1,
+                                         const bool& thread_stats = false) {
+
+    size_t np = z.n_rows;
+    /*
+     I can't just use 'stop()' because it causes a segfault (or similar).
+     The system below is my workaround.
+     */
+    bool err = lanscape_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                   L_0, P_max, u, q, W, w, z, min_F_for_P,
+                                   Y0, B0, dt, max_t);
+    std::vector<char> distr_types_char;
+    landscape_season_arg_checks(err, np, R_hat, par1, par2, distr_types,
+                                distr_types_char, add_F, Y0, B0);
+    outcome_arg_checks(err, threshold, outcome_window);
+    if (err) return NumericMatrix(0,0);
+
+    /*
+     Y and B are added once F >= add_F (see `SeasonalLandscape`).
+     Because they're added via the derivative, how much is added depends on
+     the stepper, so the start of colonization differs a bit from
+     `landscape_season_ode` even without noise.
+     */
+    MatType x0(np, 3, arma::fill::zeros);
+
+    SeasonalLandscape system(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0, P_max,
+                             u, q, W, w, z, min_F_for_P,
+                             R_hat, par1, par2, distr_types_char,
+                             Y0, B0, add_F, single_prec);
+
+    return landscape_stoch_runs(n_reps, system, x0, n_sigma, dt, max_t,
+                                single_prec, outcomes_only, threshold,
+                                outcome_window, by_plant, show_progress,
+                                seed, noise_z, noise_w, noise_vcv, noise_rank,
+                                grain_size, thread_stats);
+}
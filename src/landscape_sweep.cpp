@@ -0,0 +1,416 @@
+
+/*
+ Parameter sweeps for the deterministic landscapes.
+ All parameter sets use the same landscape (`z`) and are run in parallel,
+ so it's not necessary to fork R processes for each one.
+ Sets with the same `w` share a single dispersal matrix.
+ (Sweeps for the constant-F stochastic landscape are
+ `landscape_constantF_stoch_sweep` in landscape_constantF_stoch.cpp.)
+ */
+
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <map>
+#include <memory>
+
+#include "landscape.h"
+#include "landscape_seasonal.h"
+#include "outcomes.h"
+#include "checkpoint.h"
+#include "progress.h"
+#include "scheduler.h"
+#include "sweep.h"
+
+#include <RcppParallel.h>
+
+
+using namespace Rcpp;
+
+
+
+/*
+ Make the system for parameter set `k` and fill its starting values.
+ `Phis` stores the first system made for each value of `w` so that
+ others can share its dispersal matrix.
+ */
+template< class L >
+std::unique_ptr<L> sweep_system(SweepPars& pars,
+                                const size_t& k,
+                                const arma::mat& z,
+                                const double& dt,
+                                const double& max_t,
+                                std::map<double, const LandscapeSystemFunction*>& Phis,
+                                MatType& x0,
+                                bool& err);
+
+template<>
+std::unique_ptr<NonSeasonalLandscape> sweep_system<NonSeasonalLandscape>(
+        SweepPars& pars,
+        const size_t& k,
+        const arma::mat& z,
+        const double& dt,
+        const double& max_t,
+        std::map<double, const LandscapeSystemFunction*>& Phis,
+        MatType& x0,
+        bool& err) {
+
+    size_t np = z.n_rows;
+    std::vector<double> m = pars.plant_pars(k, "m", np, err);
+    std::vector<double> R = pars.plant_pars(k, "R", np, err);
+    std::vector<double> d_yp = pars.plant_pars(k, "d_yp", np, err);
+    std::vector<double> d_b0 = pars.plant_pars(k, "d_b0", np, err);
+    std::vector<double> d_bp = pars.plant_pars(k, "d_bp", np, err);
+    std::vector<double> g_yp = pars.plant_pars(k, "g_yp", np, err);
+    std::vector<double> g_b0 = pars.plant_pars(k, "g_b0", np, err);
+    std::vector<double> g_bp = pars.plant_pars(k, "g_bp", np, err);
+    std::vector<double> L_0 = pars.plant_pars(k, "L_0", np, err);
+    std::vector<double> P_max = pars.plant_pars(k, "P_max", np, err);
+    double u = pars.scalar_par(k, "u", err);
+    double q = pars.scalar_par(k, "q", err);
+    std::vector<double> W = pars.plant_pars(k, "W", np, err);
+    double w = pars.scalar_par(k, "w", err);
+    double min_F_for_P = pars.scalar_par(k, "min_F_for_P", err);
+    std::vector<double> Y0 = pars.plant_pars(k, "Y0", np, err);
+    std::vector<double> B0 = pars.plant_pars(k, "B0", np, err);
+    std::vector<double> N0 = pars.plant_pars(k, "N0", np, err);
+    if (err) return nullptr;
+
+    bool set_err = lanscape_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                       L_0, P_max, u, q, W, w, z, min_F_for_P,
+                                       Y0, B0, dt, max_t);
+    len_check(set_err, R, "R", np);
+    len_check(set_err, N0, "N0", np);
+    min_val_check(set_err, R, "R", 0);
+    min_val_check(set_err, N0, "N0", 0);
+    if (set_err) {
+        Rcout << "(in parameter set " << (k + 1U) << ")" << std::endl;
+        err = true;
+        return nullptr;
+    }
+
+    x0.set_size(np, 3);
+    for (size_t i = 0; i < np; i++) {
+        x0(i,0) = Y0[i];
+        x0(i,1) = B0[i];
+        x0(i,2) = N0[i];
+    }
+
+    const LandscapeSystemFunction* Phi_from = Phis.count(w) > 0 ? Phis[w] : nullptr;
+    std::unique_ptr<NonSeasonalLandscape> system(
+            new NonSeasonalLandscape(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                     L_0, P_max, u, q, W, w, z, min_F_for_P,
+                                     R, false, Phi_from));
+    if (Phi_from == nullptr) Phis[w] = system.get();
+
+    return system;
+}
+
+template<>
+std::unique_ptr<SeasonalLandscape> sweep_system<SeasonalLandscape>(
+        SweepPars& pars,
+        const size_t& k,
+        const arma::mat& z,
+        const double& dt,
+        const double& max_t,
+        std::map<double, const LandscapeSystemFunction*>& Phis,
+        MatType& x0,
+        bool& err) {
+
+    size_t np = z.n_rows;
+    std::vector<double> m = pars.plant_pars(k, "m", np, err);
+    std::vector<double> d_yp = pars.plant_pars(k, "d_yp", np, err);
+    std::vector<double> d_b0 = pars.plant_pars(k, "d_b0", np, err);
+    std::vector<double> d_bp = pars.plant_pars(k, "d_bp", np, err);
+    std::vector<double> g_yp = pars.plant_pars(k, "g_yp", np, err);
+    std::vector<double> g_b0 = pars.plant_pars(k, "g_b0", np, err);
+    std::vector<double> g_bp = pars.plant_pars(k, "g_bp", np, err);
+    std::vector<double> L_0 = pars.plant_pars(k, "L_0", np, err);
+    std::vector<double> P_max = pars.plant_pars(k, "P_max", np, err);
+    double u = pars.scalar_par(k, "u", err);
+    double q = pars.scalar_par(k, "q", err);
+    std::vector<double> W = pars.plant_pars(k, "W", np, err);
+    std::vector<double> R_hat = pars.plant_pars(k, "R_hat", np, err);
+    std::vector<double> par1 = pars.plant_pars(k, "par1", np, err);
+    std::vector<double> par2 = pars.plant_pars(k, "par2", np, err);
+    StringVector distr_types = pars.plant_strings(k, "distr_types", np, err);
+    double w = pars.scalar_par(k, "w", err);
+    double min_F_for_P = pars.scalar_par(k, "min_F_for_P", err);
+    std::vector<double> Y0 = pars.plant_pars(k, "Y0", np, err);
+    std::vector<double> B0 = pars.plant_pars(k, "B0", np, err);
+    double add_F = pars.scalar_par(k, "add_F", err);
+    if (err) return nullptr;
+
+    bool set_err = lanscape_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                       L_0, P_max, u, q, W, w, z, min_F_for_P,
+                                       Y0, B0, dt, max_t);
+    std::vector<char> distr_types_char;
+    landscape_season_arg_checks(set_err, np, R_hat, par1, par2, distr_types,
+                                distr_types_char, add_F, Y0, B0);
+    if (set_err) {
+        Rcout << "(in parameter set " << (k + 1U) << ")" << std::endl;
+        err = true;
+        return nullptr;
+    }
+
+    x0.zeros(np, 3);
+
+    const LandscapeSystemFunction* Phi_from = Phis.count(w) > 0 ? Phis[w] : nullptr;
+    std::unique_ptr<SeasonalLandscape> system(
+            new SeasonalLandscape(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                  L_0, P_max, u, q, W, w, z, min_F_for_P,
+                                  R_hat, par1, par2, distr_types_char,
+                                  Y0, B0, add_F, false, Phi_from));
+    if (Phi_from == nullptr) Phis[w] = system.get();
+
+    return system;
+}
+
+
+
+
+// RcppParallel Worker where each task is one parameter set:
+template< class L >
+struct LandscapeSweepWorker : public RcppParallel::Worker {
+
+    std::vector<std::unique_ptr<L>>& systems;
+    const std::vector<MatType>& x0;
+    // Only one of these is used, depending on `outcomes_only`:
+    std::vector<ObserverP<L>> obs;
+    std::vector<OutcomeTracker> outcomes;
+    double dt;
+    double max_t;
+    bool outcomes_only;
+    bool by_plant;
+    Progress& progress;
+
+    LandscapeSweepWorker(std::vector<std::unique_ptr<L>>& systems_,
+                         const std::vector<MatType>& x0_,
+                         const double& dt_,
+                         const double& max_t_,
+                         const bool& outcomes_only_,
+                         const double& threshold,
+                         const double& outcome_window,
+                         const bool& by_plant_,
+                         Progress& progress_)
+        : systems(systems_),
+          x0(x0_),
+          obs(),
+          outcomes(),
+          dt(dt_),
+          max_t(max_t_),
+          outcomes_only(outcomes_only_),
+          by_plant(by_plant_),
+          progress(progress_) {
+
+        size_t n_sets = systems.size();
+        if (outcomes_only) {
+            size_t np = n_sets > 0 ? x0.front().n_rows : 0U;
+            outcomes.assign(n_sets, OutcomeTracker(np, threshold,
+                                                   max_t - outcome_window));
+        } else {
+            obs.reserve(n_sets);
+            for (size_t k = 0; k < n_sets; k++) obs.emplace_back(*systems[k]);
+        }
+
+    };
+
+    void operator()(size_t begin, size_t end) {
+        auto no_save = [](const size_t& /* step_ */) {};
+        for (size_t k = begin; k < end; k++) {
+            if (progress.cancelled()) break;
+            MatType x(x0[k]);
+            CheckpointStepper stepper;
+            size_t step = 0;
+            bool finished;
+            {
+                ProgressTicker ticker(progress, false);
+                if (outcomes_only) {
+                    finished = integrate_const_from(stepper, std::ref(*systems[k]),
+                                                    x, step, dt, max_t,
+                                                    outcomes[k], 0U, no_save,
+                                                    ticker);
+                } else {
+                    finished = integrate_const_from(stepper, std::ref(*systems[k]),
+                                                    x, step, dt, max_t,
+                                                    obs[k], 0U, no_save,
+                                                    ticker);
+                }
+            }
+            if (! finished) break;
+            progress.add_rep();
+        }
+        return;
+    }
+
+    // Bind output from all sets, with the set number in the first column:
+    void fill_output(NumericMatrix& output) {
+        if (outcomes_only) {
+            fill_outcomes__(output);
+            return;
+        }
+        size_t n_rows = 0;
+        for (ObserverP<L>& o : obs) {
+            o.finish();
+            if (! o.P.empty()) n_rows += o.data.size() * o.P.front().n_elem;
+        }
+        output = NumericMatrix(n_rows, 7);
+        colnames(output) = CharacterVector::create("set", "t", "p", "Y", "B",
+                 "N", "P");
+        size_t i = 0;
+        for (size_t k = 0; k < obs.size(); k++) {
+            const ObserverP<L>& o(obs[k]);
+            size_t np = o.P.empty() ? 0U : o.P.front().n_elem;
+            double set = static_cast<double>(k) + 1;
+            for (size_t t = 0; t < o.data.size(); t++) {
+                const MatType& x(o.data[t]);
+                for (size_t p = 0; p < np; p++) {
+                    output(i,0) = set;
+                    output(i,1) = o.time[t];
+                    output(i,2) = p;
+                    output(i,3) = x(p, 0);
+                    output(i,4) = x(p, 1);
+                    output(i,5) = x(p, 2);
+                    output(i,6) = o.P[t](p);
+                    i++;
+                }
+            }
+        }
+        return;
+    }
+
+private:
+
+    void fill_outcomes__(NumericMatrix& output) const {
+        size_t n_rows = 0;
+        for (const OutcomeTracker& o : outcomes) n_rows += o.n_rows(by_plant);
+        CharacterVector cn = outcome_colnames(by_plant, false);
+        output = NumericMatrix(n_rows, cn.size() + 1U);
+        CharacterVector cn_set = CharacterVector::create("set");
+        for (size_t j = 0; j < cn.size(); j++) cn_set.push_back(cn[j]);
+        colnames(output) = cn_set;
+        size_t i = 0, i0;
+        for (size_t k = 0; k < outcomes.size(); k++) {
+            i0 = i;
+            outcomes[k].fill_output(output, i, 1U, by_plant);
+            double set = static_cast<double>(k) + 1;
+            for (; i0 < i; i0++) output(i0,0) = set;
+        }
+        return;
+    }
+};
+
+
+
+
+// Shared by both sweeps below:
+template< class L >
+inline NumericMatrix landscape_sweep_runs(const List& par_sets,
+                                          const List& shared,
+                                          const arma::mat& z,
+                                          const double& dt,
+                                          const double& max_t,
+                                          const bool& outcomes_only,
+                                          const double& threshold,
+                                          const double& outcome_window,
+                                          const bool& by_plant,
+                                          const bool& show_progress,
+                                          const uint32_t& grain_size,
+                                          const bool& thread_stats) {
+
+    /*
+     I can't just use 'stop()' because it causes a segfault (or similar).
+     The system below is my workaround.
+     */
+    bool err = false;
+    min_val_check(err, static_cast<double>(par_sets.size()), "length(par_sets)", 1);
+    outcome_arg_checks(err, threshold, outcome_window);
+    min_val_check(err, grain_size, "grain_size", 1);
+    if (err) return NumericMatrix(0,0);
+
+    SweepPars pars(par_sets, shared);
+    size_t n_sets = pars.n_sets;
+    std::vector<std::unique_ptr<L>> systems;
+    std::vector<MatType> x0(n_sets);
+    std::map<double, const LandscapeSystemFunction*> Phis;
+    systems.reserve(n_sets);
+    for (size_t k = 0; k < n_sets; k++) {
+        systems.push_back(sweep_system<L>(pars, k, z, dt, max_t, Phis,
+                                          x0[k], err));
+        if (err) return NumericMatrix(0,0);
+    }
+
+    Progress progress(n_sets, n_sets * n_const_steps(dt, max_t),
+                      show_progress);
+
+    LandscapeSweepWorker<L> worker(systems, x0, dt, max_t, outcomes_only,
+                                   threshold, outcome_window, by_plant,
+                                   progress);
+
+    // Sets are handed to threads `grain_size` at a time (see scheduler.h):
+    ThreadUsage usage;
+    // Running in another thread lets this one check for interrupts:
+    bool finished = progress.run_parallel([&]() {
+        dynamic_parallel_for(worker, n_sets, grain_size, usage);
+    });
+    if (! finished) return NumericMatrix(0,0);
+
+    NumericMatrix output;
+    worker.fill_output(output);
+    if (thread_stats) output.attr("thread_stats") = usage.output();
+
+    return output;
+}
+
+
+
+
+/*
+ Run `landscape_ode` for each parameter set in `par_sets`, all on the
+ landscape `z`.
+ Each item in `par_sets` is a named list of arguments to `landscape_ode`,
+ and arguments that are the same for all sets can go in `shared` instead.
+ Returns the output from all sets bound together, with the set number
+ in the first column.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_sweep(const List& par_sets,
+                              const List& shared,
+                              const arma::mat& z,
+                              const double& dt = 0.1,
+                              const double& max_t = 90.0,
+                              const bool& outcomes_only = false,
+                              const double& threshold = 1e-6,
+                              const double& outcome_window = 0,
+                              const bool& by_plant = false,
+                              const bool& show_progress = false,
+                              const uint32_t& grain_size = 1,
+                              const bool& thread_stats = false) {
+
+    return landscape_sweep_runs<NonSeasonalLandscape>(
+            par_sets, shared, z, dt, max_t, outcomes_only, threshold,
+            outcome_window, by_plant, show_progress, grain_size, thread_stats);
+}
+
+
+// Same as above, but for `landscape_season_ode`:
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_season_sweep(const List& par_sets,
+                                     const List& shared,
+                                     const arma::mat& z,
+                                     const double& dt = 0.1,
+                                     const double& max_t = 90.0,
+                                     const bool& outcomes_only = false,
+                                     const double& threshold = 1e-6,
+                                     const double& outcome_window = 0,
+                                     const bool& by_plant = false,
+                                     const bool& show_progress = false,
+                                     const uint32_t& grain_size = 1,
+                                     const bool& thread_stats = false) {
+
+    return landscape_sweep_runs<SeasonalLandscape>(
+            par_sets, shared, z, dt, max_t, outcomes_only, threshold,
+            outcome_window, by_plant, show_progress, grain_size, thread_stats);
+}
@@ -1,5 +1,22 @@
+
+/*
+ Local (within-flower) chemostat model with any number of yeast and
+ bacteria strains competing for sugar (A), where bacteria also produce
+ hydrogen ions (H) that inhibit growth.
+
+ Strains can arrive after the start. Arrivals are events for the
+ integrator: it steps exactly to each arrival time, adds the arriving
+ strain to the state, then restarts (dopri5's first-same-as-last
+ derivative is no longer valid after the jump). Arrivals used to be done
+ inside the RHS, which doesn't work with steppers that evaluate it more
+ than once per step.
+ */
+
 #include <RcppArmadillo.h>
 #include <vector>
+#include <string>
+#include <algorithm>
+#include <limits>
 
 #include "ode.h"
 
@@ -8,15 +25,15 @@ using namespace Rcpp;
 
 
 
+/*
+ State is yeast strains, then bacteria strains, then A and H.
+ The RHS doesn't change the system or allocate anything.
+ */
 class LocalSystemFunction
 {
 public:
     size_t n_Y;
     size_t n_B;
-    double Y_delay;
-    double Y0;
-    double B_delay;
-    double B0;
     double D;
     double A_0;
     std::vector<double> r_Y;
@@ -32,30 +49,22 @@ public:
     std::vector<double> h_B;
 
     LocalSystemFunction(const size_t& n_Y_,
-                   const size_t& n_B_,
-                   const double& Y_delay_,
-                   const double& Y0_,
-                   const double& B_delay_,
-                   const double& B0_,
-                   const double& D_,
-                   const double& A_0_,
-                   const double& r_Y_,
-                   const double& m_Y_,
-                   const double& q_Y_,
-                   const double& c_Y_,
-                   const double& h_Y_,
-                   const double& r_B_,
-                   const double& m_B_,
-                   const double& e_B_,
-                   const double& q_B_,
-                   const double& c_B_,
-                   const double& h_B_)
+                        const size_t& n_B_,
+                        const double& D_,
+                        const double& A_0_,
+                        const double& r_Y_,
+                        const double& m_Y_,
+                        const double& q_Y_,
+                        const double& c_Y_,
+                        const double& h_Y_,
+                        const double& r_B_,
+                        const double& m_B_,
+                        const double& e_B_,
+                        const double& q_B_,
+                        const double& c_B_,
+                        const double& h_B_)
         : n_Y(n_Y_),
           n_B(n_B_),
-          Y_delay(Y_delay_),
-          Y0(Y0_),
-          B_delay(B_delay_),
-          B0(B0_),
           D(D_),
           A_0(A_0_),
           r_Y(n_Y, r_Y_),
@@ -70,30 +79,22 @@ public:
           c_B(n_B, c_B_),
           h_B(n_B, h_B_) {};
     LocalSystemFunction(const size_t& n_Y_,
-                   const size_t& n_B_,
-                   const double& Y_delay_,
-                   const double& Y0_,
-                   const double& B_delay_,
-                   const double& B0_,
-                   const double& D_,
-                   const double& A_0_,
-                   const std::vector<double>& r_Y_,
-                   const std::vector<double>& m_Y_,
-                   const std::vector<double>& q_Y_,
-                   const std::vector<double>& c_Y_,
-                   const std::vector<double>& h_Y_,
-                   const std::vector<double>& r_B_,
-                   const std::vector<double>& m_B_,
-                   const std::vector<double>& e_B_,
-                   const std::vector<double>& q_B_,
-                   const std::vector<double>& c_B_,
-                   const std::vector<double>& h_B_)
+                        const size_t& n_B_,
+                        const double& D_,
+                        const double& A_0_,
+                        const std::vector<double>& r_Y_,
+                        const std::vector<double>& m_Y_,
+                        const std::vector<double>& q_Y_,
+                        const std::vector<double>& c_Y_,
+                        const std::vector<double>& h_Y_,
+                        const std::vector<double>& r_B_,
+                        const std::vector<double>& m_B_,
+                        const std::vector<double>& e_B_,
+                        const std::vector<double>& q_B_,
+                        const std::vector<double>& c_B_,
+                        const std::vector<double>& h_B_)
         : n_Y(n_Y_),
           n_B(n_B_),
-          Y_delay(Y_delay_),
-          Y0(Y0_),
-          B_delay(B_delay_),
-          B0(B0_),
           D(D_),
           A_0(A_0_),
           r_Y(r_Y_),
@@ -119,7 +120,9 @@ public:
         if (c_B.size() != n_B) Rcpp::stop("c_B.size() != n_B");
         if (h_B.size() != n_B) Rcpp::stop("h_B.size() != n_B");
     };
-    void operator()(const VecType& x, VecType& dxdt, const double t) {
+    // `C` is `VecType` or `ArrType<n_Y+n_B+2>`:
+    template< class C >
+    void operator()(const C& x, C& dxdt, const double /* t */) const {
         size_t n_YB = n_Y+n_B;
         const double& A(x[n_YB]);
         const double& H(x[n_YB+1U]);
@@ -129,15 +132,10 @@ public:
         dHdt = - D * H;
         double Ryi, Rbj;
 
-        bool add_B = B_delay > 0 && t >= B_delay;
-        if (add_B) B_delay = -1;
-        bool add_Y = Y_delay > 0 && t >= Y_delay;
-        if (add_Y) Y_delay = -1;
-
         for (size_t i = 0; i < n_Y; i++) {
             const double& Yi(x[i]);
             if (Yi == 0) {
-                if (add_Y) dxdt[i] = Y0;
+                dxdt[i] = 0;
                 continue;
             }
             Ryi = r_Y[i] * A / ((c_Y[i] + A) * (1 + H / h_Y[i]));
@@ -148,7 +146,7 @@ public:
         for (size_t j = 0; j < n_B; j++) {
             const double& Bj(x[j+n_Y]);
             if (Bj == 0) {
-                if (add_B) dxdt[j+n_Y] = B0;
+                dxdt[j+n_Y] = 0;
                 continue;
             }
             Rbj = r_B[j] * A / ((c_B[j] + A) * (1 + H / h_B[j]));
@@ -163,6 +161,144 @@ public:
 
 
 
+// Arrival of `x` of the strain at index `i` in the state at time `t`:
+struct LocalArrival {
+    double t;
+    size_t i;
+    double x;
+};
+
+
+/*
+ Integrate from 0 to `max_t` with output every `dt` (at the same times
+ as `integrate_const`), adding strains as they arrive.
+ States observed at an arrival time include that arrival.
+ */
+template< class C, class Obs >
+inline void integrate_arrivals(const LocalSystemFunction& system,
+                               C& x,
+                               std::vector<LocalArrival> arrivals,
+                               const double& dt,
+                               const double& max_t,
+                               Obs& obs) {
+
+    std::stable_sort(arrivals.begin(), arrivals.end(),
+                     [](const LocalArrival& a, const LocalArrival& b) {
+                         return a.t < b.t;
+                     });
+    // Arrivals this close to a step's start or end are done there:
+    const double t_eps = 1e-10 * dt;
+    size_t next = 0;
+    auto arrive = [&](const double& t) {
+        while (next < arrivals.size() && arrivals[next].t <= t + t_eps) {
+            x[arrivals[next].i] += arrivals[next].x;
+            next++;
+        }
+    };
+
+    boost::numeric::odeint::runge_kutta_dopri5<C> stepper;
+    arrive(0.0);
+    obs(x, 0.0);
+    size_t step = 0;
+    double time = 0.0;
+    while ((time + dt) - max_t <= std::numeric_limits<double>::epsilon()) {
+        double t1 = 0.0 + static_cast<double>(step + 1U) * dt;
+        bool split = false;
+        while (next < arrivals.size() && arrivals[next].t < t1 - t_eps) {
+            stepper.do_step(std::ref(system), x, time, arrivals[next].t - time);
+            time = arrivals[next].t;
+            arrive(time);
+            stepper.reset();
+            split = true;
+        }
+        // (Steps without arrivals are exactly `dt`, as in `integrate_const`)
+        stepper.do_step(std::ref(system), x, time, split ? t1 - time : dt);
+        ++step;
+        time = t1;
+        if (next < arrivals.size() && arrivals[next].t <= time + t_eps) {
+            arrive(time);
+            stepper.reset();
+        }
+        obs(x, time);
+    }
+    return;
+}
+
+
+
+inline void init_state(VecType& x, const VecType& x0) {
+    x = x0;
+    return;
+}
+template< size_t N >
+inline void init_state(ArrType<N>& x, const VecType& x0) {
+    std::copy(x0.begin(), x0.end(), x.begin());
+    return;
+}
+
+/*
+ Run the system from `x0` using state type `C`, and return a matrix with
+ time in the first column and the state in the rest (without column names).
+ */
+template< class C >
+NumericMatrix local_engine(const LocalSystemFunction& system,
+                           const VecType& x0,
+                           const std::vector<LocalArrival>& arrivals,
+                           const double& dt,
+                           const double& max_t) {
+
+    C x;
+    init_state(x, x0);
+    Observer<C> obs;
+    integrate_arrivals(system, x, arrivals, dt, max_t, obs);
+
+    size_t n_steps = obs.data.size();
+    NumericMatrix output(n_steps, x0.size() + 1U);
+    for (size_t i = 0; i < n_steps; i++) {
+        output(i,0) = obs.time[i];
+        for (size_t j = 0; j < x0.size(); j++) {
+            output(i,j+1U) = obs.data[i][j];
+        }
+    }
+    return output;
+}
+
+typedef NumericMatrix (*LocalEngine)(const LocalSystemFunction&,
+                                     const VecType&,
+                                     const std::vector<LocalArrival>&,
+                                     const double&,
+                                     const double&);
+
+/*
+ Engines with fixed-size state, indexed by state size (n_Y + n_B + 2).
+ This covers up to five strains of each; bigger systems use `VecType`,
+ where the allocations are small next to the RHS itself.
+ */
+const LocalEngine local_engines[] = {
+    nullptr, nullptr,
+    &local_engine<ArrType<2>>, &local_engine<ArrType<3>>,
+    &local_engine<ArrType<4>>, &local_engine<ArrType<5>>,
+    &local_engine<ArrType<6>>, &local_engine<ArrType<7>>,
+    &local_engine<ArrType<8>>, &local_engine<ArrType<9>>,
+    &local_engine<ArrType<10>>, &local_engine<ArrType<11>>,
+    &local_engine<ArrType<12>>
+};
+
+inline NumericMatrix run_local_engine(const LocalSystemFunction& system,
+                                      const VecType& x0,
+                                      const std::vector<LocalArrival>& arrivals,
+                                      const double& dt,
+                                      const double& max_t) {
+    size_t n = x0.size();
+    size_t n_engines = sizeof(local_engines) / sizeof(LocalEngine);
+    if (n < n_engines && local_engines[n] != nullptr) {
+        return local_engines[n](system, x0, arrivals, dt, max_t);
+    }
+    return local_engine<VecType>(system, x0, arrivals, dt, max_t);
+}
+
+
+
 //' @export
  // [[Rcpp::export]]
  NumericMatrix run_ode_cpp(const double& dt = 0.01,
@@ -190,27 +326,122 @@ public:
      if (A_0 == -999) A_0 = A0;
 
      VecType x(4U, 0.0);
-     if (Y_delay <= 0) x[0] = Y0;
-     if (B_delay <= 0) x[1] = B0;
      x[2] = A0;
      x[3] = H0;
+     // (Delays <= 0 mean they're there from the start)
+     std::vector<LocalArrival> arrivals = {
+         LocalArrival{std::max(Y_delay, 0.0), 0U, Y0},
+         LocalArrival{std::max(B_delay, 0.0), 1U, B0}
+     };
 
-     Observer<VecType> obs;
-     LocalSystemFunction system(1U, 1U, Y_delay, Y0, B_delay, B0, D, A_0, r_Y, m_Y, q_Y,
-                           c_Y, h_Y, r_B, m_B, e_B, q_B, c_B, h_B);
+     LocalSystemFunction system(1U, 1U, D, A_0, r_Y, m_Y, q_Y,
+                                c_Y, h_Y, r_B, m_B, e_B, q_B, c_B, h_B);
 
-     boost::numeric::odeint::integrate_const(
-         VecStepperType(), std::ref(system),
-         x, 0.0, max_t, dt, std::ref(obs));
-
-     size_t n_steps = obs.data.size();
-     NumericMatrix output(n_steps, x.size()+1U);
+     NumericMatrix output = run_local_engine(system, x, arrivals, dt, max_t);
      colnames(output) = CharacterVector::create("t", "Y", "B", "A", "H");
-     for (size_t i = 0; i < n_steps; i++) {
-         output(i,0) = obs.time[i];
-         for (size_t j = 0; j < x.size(); j++) {
-             output(i,j+1U) = obs.data[i][j];
-         }
-     }
      return output;
  }
+
+
+
+
+/*
+ Local chemostat with any number of yeast and bacteria strains.
+ Parameters are vectors with one value per strain, and each strain is
+ added at density `Y0` (or `B0`) at time `Y_arrive` (or `B_arrive`;
+ 0 means it's there from the start).
+ Returns one column per strain (`Y1`, `Y2`, ..., `B1`, ...), plus A and H.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix local_multistrain_ode(const std::vector<double>& r_Y,
+                                    const std::vector<double>& m_Y,
+                                    const std::vector<double>& q_Y,
+                                    const std::vector<double>& c_Y,
+                                    const std::vector<double>& h_Y,
+                                    const std::vector<double>& Y0,
+                                    const std::vector<double>& Y_arrive,
+                                    const std::vector<double>& r_B,
+                                    const std::vector<double>& m_B,
+                                    const std::vector<double>& e_B,
+                                    const std::vector<double>& q_B,
+                                    const std::vector<double>& c_B,
+                                    const std::vector<double>& h_B,
+                                    const std::vector<double>& B0,
+                                    const std::vector<double>& B_arrive,
+                                    const double& A0 = 1.46,
+                                    const double& H0 = 0.0,
+                                    const double& D = 0.214,
+                                    SEXP A_0 = R_NilValue,
+                                    const double& dt = 0.01,
+                                    const double& max_t = 36.0) {
+
+    size_t n_Y = r_Y.size();
+    size_t n_B = r_B.size();
+    /*
+     I can't just use 'stop()' because it causes a segfault (or similar).
+     The system below is my workaround.
+     */
+    bool err = false;
+    len_check(err, m_Y, "m_Y", n_Y);
+    len_check(err, q_Y, "q_Y", n_Y);
+    len_check(err, c_Y, "c_Y", n_Y);
+    len_check(err, h_Y, "h_Y", n_Y);
+    len_check(err, Y0, "Y0", n_Y);
+    len_check(err, Y_arrive, "Y_arrive", n_Y);
+    len_check(err, m_B, "m_B", n_B);
+    len_check(err, e_B, "e_B", n_B);
+    len_check(err, q_B, "q_B", n_B);
+    len_check(err, c_B, "c_B", n_B);
+    len_check(err, h_B, "h_B", n_B);
+    len_check(err, B0, "B0", n_B);
+    len_check(err, B_arrive, "B_arrive", n_B);
+    if (err) return NumericMatrix(0,0);
+    min_val_check(err, r_Y, "r_Y", 0);
+    min_val_check(err, m_Y, "m_Y", 0);
+    min_val_check(err, q_Y, "q_Y", 0);
+    min_val_check(err, c_Y, "c_Y", 0);
+    min_val_check(err, h_Y, "h_Y", 0, false);
+    min_val_check(err, Y0, "Y0", 0);
+    min_val_check(err, Y_arrive, "Y_arrive", 0);
+    min_val_check(err, r_B, "r_B", 0);
+    min_val_check(err, m_B, "m_B", 0);
+    min_val_check(err, e_B, "e_B", 0);
+    min_val_check(err, q_B, "q_B", 0);
+    min_val_check(err, c_B, "c_B", 0);
+    min_val_check(err, h_B, "h_B", 0, false);
+    min_val_check(err, B0, "B0", 0);
+    min_val_check(err, B_arrive, "B_arrive", 0);
+    min_val_check(err, A0, "A0", 0);
+    min_val_check(err, H0, "H0", 0);
+    min_val_check(err, D, "D", 0);
+    double A_0_ = (A_0 == R_NilValue) ? A0 : as<double>(A_0);
+    min_val_check(err, A_0_, "A_0", 0);
+    min_val_check(err, dt, "dt", 0, false);
+    min_val_check(err, max_t, "max_t", std::max(dt, 0.0), false);
+    if (err) return NumericMatrix(0,0);
+
+    VecType x(n_Y + n_B + 2U, 0.0);
+    x[n_Y + n_B] = A0;
+    x[n_Y + n_B + 1U] = H0;
+    std::vector<LocalArrival> arrivals;
+    arrivals.reserve(n_Y + n_B);
+    for (size_t i = 0; i < n_Y; i++) {
+        arrivals.push_back(LocalArrival{Y_arrive[i], i, Y0[i]});
+    }
+    for (size_t j = 0; j < n_B; j++) {
+        arrivals.push_back(LocalArrival{B_arrive[j], n_Y + j, B0[j]});
+    }
+
+    LocalSystemFunction system(n_Y, n_B, D, A_0_, r_Y, m_Y, q_Y, c_Y, h_Y,
+                               r_B, m_B, e_B, q_B, c_B, h_B);
+
+    NumericMatrix output = run_local_engine(system, x, arrivals, dt, max_t);
+    CharacterVector cn = CharacterVector::create("t");
+    for (size_t i = 0; i < n_Y; i++) cn.push_back("Y" + std::to_string(i + 1U));
+    for (size_t j = 0; j < n_B; j++) cn.push_back("B" + std::to_string(j + 1U));
+    cn.push_back("A");
+    cn.push_back("H");
+    colnames(output) = cn;
+    return output;
+}
@@ -4,6 +4,7 @@
 
 #include <RcppArmadillo.h>
 #include <vector>
+#include <array>
 #include <string>
 
 
@@ -22,6 +23,16 @@ typedef std::vector<double> VecType;
 
 typedef boost::numeric::odeint::runge_kutta_dopri5<VecType> VecStepperType;
 
+/*
+ Fixed-size state for small systems whose size is known at compile time.
+ These live on the stack, and dopri5 never has to check or resize them.
+ */
+template< size_t N >
+using ArrType = std::array<double, N>;
+
+template< size_t N >
+using ArrStepperType = boost::numeric::odeint::runge_kutta_dopri5<ArrType<N>>;
+
 // Comment if you want to use boost matrix types:
 // typedef boost::numeric::ublas::matrix<double> MatType;
 typedef arma::mat MatType;
@@ -85,21 +96,178 @@ struct resize_impl<arma::mat, arma::mat>
 } } } // namespace boost::numeric::odeint
 
 
+/*
+ Copy a state into the type it's stored as.
+ Storing `MatType` states as `arma::fmat` halves the memory used for
+ trajectories, while integration itself always stays in double precision.
+ */
 template< class C >
+inline void store_state(C& out, const C& x) {
+    out = x;
+    return;
+}
+inline void store_state(arma::fmat& out, const MatType& x) {
+    out = arma::conv_to<arma::fmat>::from(x);
+    return;
+}
+// ... and back again (`tmp` is only used when a conversion is necessary):
+template< class C >
+inline const C& load_state(const C& x, C& /* tmp */) {
+    return x;
+}
+inline const MatType& load_state(const arma::fmat& x, MatType& tmp) {
+    tmp = arma::conv_to<MatType>::from(x);
+    return tmp;
+}
+
+
+// `S` is the type states are stored as (defaults to the state type `C`)
+template< class C, class S = C >
 struct Observer
 {
-    std::vector<C> data;
+    std::vector<S> data;
     std::vector<double> time;
     Observer() : data(), time() {};
 
     void operator()(const C& x, const double& t) {
-        data.push_back(x);
+        data.push_back(S());
+        store_state(data.back(), x);
         time.push_back(t);
         return;
     }
 };
 
 
+/*
+ Whether two times are the same, allowing for rounding differences between
+ times passed to the system (t + dt) and the observer (t0 + n * dt).
+ */
+inline bool same_time(const double& t1, const double& t2) {
+    return std::abs(t1 - t2) <= 1e-10 * std::max(1.0, std::abs(t1));
+}
+
+
+/*
+ Same as above, but also storing pollinators (P) for each plant.
+ Systems (`L`) calculate these inside their RHS, so this avoids a separate
+ pass to re-calculate them. `L` needs these methods:
+   - `bool P_at(const double& t)`: whether the last RHS evaluation was at
+     time `t` (and at the state observed then)
+   - `void last_P(arma::vec& P)`: P from the last RHS evaluation
+   - `void make_P(arma::vec& P, const MatType& x)`: calculate P directly
+ With dopri5, the last evaluation in each step is at the new state
+ (first-same-as-last), so P can be stored right away except at t = 0.
+ With steppers that evaluate the RHS at the start of each step
+ (e.g., Euler-Maruyama), P is filled in at the next observation.
+ Call `finish()` after integrating to fill any that are still missing.
+ */
+template< class L, class S = MatType >
+struct ObserverP : public Observer<MatType, S>
+{
+    typedef arma::Col<typename S::elem_type> PType;
+    std::vector<PType> P;
+
+    ObserverP(L& system_)
+        : Observer<MatType, S>(), P(), system(system_), pending(false),
+          P_tmp(), x_tmp() {};
+
+    void operator()(const MatType& x, const double& t) {
+        if (pending) fill_pending__();
+        Observer<MatType, S>::operator()(x, t);
+        P.push_back(PType());
+        if (system.P_at(t)) {
+            system.last_P(P_tmp);
+            P.back() = arma::conv_to<PType>::from(P_tmp);
+        } else pending = true;
+        return;
+    }
+
+    void finish() {
+        if (pending) fill_pending__();
+        return;
+    }
+
+    void clear() {
+        this->data.clear();
+        this->time.clear();
+        P.clear();
+        pending = false;
+        return;
+    }
+
+    /*
+     For checkpoints (see checkpoint.h). Rows are written separately
+     (`save_rows` and `load_rows`) so they can be appended to a file as
+     they're added, rather than rewritten every checkpoint.
+     Only rows with P are final, so a last row still waiting for P is
+     saved here instead (after rows are loaded when resuming).
+     */
+    template< class W >
+    void save(W& w) const {
+        w.write(pending);
+        if (pending) {
+            w.write(this->time.back());
+            w.write(this->data.back());
+        }
+        return;
+    }
+    template< class R >
+    void load(R& r) {
+        r.read(pending);
+        if (pending) {
+            this->time.push_back(0);
+            this->data.push_back(S());
+            P.push_back(PType());
+            r.read(this->time.back());
+            r.read(this->data.back());
+        }
+        return;
+    }
+    size_t n_final_rows() const {
+        return this->time.size() - (pending ? 1U : 0U);
+    }
+    // Final rows from `i0` on:
+    template< class W >
+    void save_rows(W& w, const size_t& i0) const {
+        for (size_t i = i0; i < n_final_rows(); i++) {
+            w.write(this->time[i]);
+            w.write(this->data[i]);
+            w.write(P[i]);
+        }
+        return;
+    }
+    // Replaces all rows with the first `n` in `r`:
+    template< class R >
+    void load_rows(R& r, const size_t& n) {
+        this->data.resize(n);
+        this->time.resize(n);
+        P.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            r.read(this->time[i]);
+            r.read(this->data[i]);
+            r.read(P[i]);
+        }
+        return;
+    }
+
+private:
+    L& system;
+    bool pending;
+    arma::vec P_tmp;
+    MatType x_tmp;
+
+    void fill_pending__() {
+        size_t k = P.size() - 1U;
+        if (system.P_at(this->time[k])) {
+            system.last_P(P_tmp);
+        } else system.make_P(P_tmp, load_state(this->data[k], x_tmp));
+        P[k] = arma::conv_to<PType>::from(P_tmp);
+        pending = false;
+        return;
+    }
+};
+
+
 
 
 /*
@@ -176,6 +344,8 @@ inline void min_val_check(bool& err,
                           const std::string& obj_name,
                           const double& min_val,
                           const bool& allow_equal = true) {
+    // (Lengths are checked separately, and there's no minimum to check here)
+    if (obj.empty()) return;
     double obj_min = *std::min_element(obj.begin(), obj.end());
     if (allow_equal) {
         if (obj_min < min_val) {
@@ -0,0 +1,112 @@
+# ifndef __SWEETSOURSONG_ONE_PLANT_H
+# define __SWEETSOURSONG_ONE_PLANT_H
+
+
+#include <RcppArmadillo.h>
+#include <vector>
+
+#include "ode.h"
+
+using namespace Rcpp;
+
+
+
+
+class OnePlantSystemFunction
+{
+public:
+    double m;
+    double R;
+    double d_yp;
+    double d_b0;
+    double d_bp;
+    double g_yp;
+    double g_b0;
+    double g_bp;
+    double L_0;
+    double P_max;
+    double q;
+    double s_0_h;
+    double h;
+    double f_0_u;
+    double F_tilde;
+    double u;
+
+    OnePlantSystemFunction(const double& m_,
+                           const double& R_,
+                           const double& d_yp_,
+                           const double& d_b0_,
+                           const double& d_bp_,
+                           const double& g_yp_,
+                           const double& g_b0_,
+                           const double& g_bp_,
+                           const double& L_0_,
+                           const double& P_max_,
+                           const double& q_,
+                           const double& s_0_,
+                           const double& h_,
+                           const double& f_0_,
+                           const double& F_tilde_,
+                           const double& u_)
+        : m(m_),
+          R(R_),
+          d_yp(d_yp_),
+          d_b0(d_b0_),
+          d_bp(d_bp_),
+          g_yp(g_yp_),
+          g_b0(g_b0_),
+          g_bp(g_bp_),
+          L_0(L_0_),
+          P_max(P_max_),
+          q(q_),
+          s_0_h(std::pow(s_0_, h_)),
+          h(h_),
+          f_0_u(std::pow(f_0_, u_)),
+          F_tilde(F_tilde_),
+          u(u_) {};
+
+    // `C` is `VecType` or `ArrType<3>`:
+    template< class C >
+    void operator()(const C& x, C& dxdt, const double /* t */) const {
+
+        const double& Y(x[0]);
+        const double& B(x[1]);
+        const double& N(x[2]);
+
+        double F = Y + B + N;
+
+        // double F_u = std::pow(F, u);
+        // double phi = F_u / (f_0_u + F_u);
+        double FF_u = std::pow(F / (F + F_tilde), u);
+        double phi = FF_u / (f_0_u + FF_u);
+        double psi = s_0_h / (s_0_h + std::pow(B / F, h));
+        double P = P_max * (q * psi + (1-q) * phi);
+
+        double PF = P / F;
+        double Lambda = PF / (L_0 + PF);
+
+        double gamma_y = g_yp * Lambda;
+        double gamma_b = g_b0 + g_bp * Lambda;
+
+        double delta_y = d_yp * Lambda;
+        double delta_b = d_b0 + d_bp * Lambda;
+
+        double disp_y = delta_y * Y / F + gamma_y;
+        double disp_b = delta_b * B / F + gamma_b;
+
+        double& dYdt(dxdt[0]);
+        double& dBdt(dxdt[1]);
+        double& dNdt(dxdt[2]);
+
+        dYdt = disp_y * N - m * Y;
+        dBdt = disp_b * N - m * B;
+        dNdt = R - N * (m + disp_y + disp_b);
+
+        return;
+    }
+};
+
+
+
+
+#endif
@@ -0,0 +1,625 @@
+
+/*
+ Batched versions of `one_plant_ode` and `one_plant_season_ode` that run
+ many parameter sets in one call.
+ Sets are integrated in blocks of `batch_lanes` sets that all take the same
+ steps at the same time. Within a block, the state and parameters are stored
+ as one array per variable (with one value per set), so each dopri5 stage and
+ each part of the system's arithmetic is a loop over sets that the compiler
+ can vectorize. Blocks are handed to threads as in scheduler.h.
+ Each set goes through the same arithmetic in the same order as in the
+ single-run functions, so results are the same as calling them separately.
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <array>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include "ode.h"
+#include "progress.h"
+#include "scheduler.h"
+
+#include <RcppParallel.h>
+
+
+using namespace Rcpp;
+
+
+
+/*
+ Number of sets per block. Eight doubles fill an AVX-512 register
+ (or two AVX2 ones), and narrower SIMD just uses more instructions per loop.
+ */
+constexpr size_t batch_lanes = 8;
+
+typedef std::array<double, batch_lanes> Lanes;
+// Y, B, and N for each set in a block:
+typedef std::array<Lanes, 3> BlockState;
+
+
+
+
+/*
+ Parameters for all sets, with one vector per parameter.
+ Each item in `pars` should have length 1 (used for all sets) or the number of
+ sets. Vectors are padded (by repeating the last set) to a multiple of
+ `batch_lanes` so the last block doesn't need special treatment.
+ */
+class OnePlantBatchPars
+{
+public:
+
+    size_t n_sets;
+    size_t n_blocks;
+    bool seasonal;
+    std::vector<double> m;
+    std::vector<double> R;
+    std::vector<double> d_yp;
+    std::vector<double> d_b0;
+    std::vector<double> d_bp;
+    std::vector<double> g_yp;
+    std::vector<double> g_b0;
+    std::vector<double> g_bp;
+    std::vector<double> L_0;
+    std::vector<double> P_max;
+    std::vector<double> q;
+    std::vector<double> s_0_h;
+    std::vector<double> h;
+    std::vector<double> f_0_u;
+    std::vector<double> F_tilde;
+    std::vector<double> u;
+    std::vector<double> R_hat;
+    std::vector<double> t0;
+    std::vector<double> k;
+    std::vector<double> lambda;
+    std::vector<double> Y0;
+    std::vector<double> B0;
+    std::vector<double> N0;
+
+    OnePlantBatchPars(const List& pars, const bool& seasonal_, bool& err)
+        : n_sets(0), n_blocks(0), seasonal(seasonal_) {
+
+        for (size_t i = 0; i < static_cast<size_t>(pars.size()); i++) {
+            SEXP x_i = pars[i];
+            std::vector<double> x = as<std::vector<double>>(x_i);
+            n_sets = std::max(n_sets, x.size());
+        }
+        if (n_sets == 0) {
+            Rcout << "pars should have at least one parameter set!" << std::endl;
+            err = true;
+            return;
+        }
+
+        m = read__(pars, "m", err);
+        d_yp = read__(pars, "d_yp", err);
+        d_b0 = read__(pars, "d_b0", err);
+        d_bp = read__(pars, "d_bp", err);
+        g_yp = read__(pars, "g_yp", err);
+        g_b0 = read__(pars, "g_b0", err);
+        g_bp = read__(pars, "g_bp", err);
+        L_0 = read__(pars, "L_0", err);
+        P_max = read__(pars, "P_max", err);
+        q = read__(pars, "q", err);
+        h = read__(pars, "h", err);
+        F_tilde = read__(pars, "F_tilde", err);
+        u = read__(pars, "u", err);
+        std::vector<double> s_0 = read__(pars, "s_0", err);
+        std::vector<double> f_0 = read__(pars, "f_0", err);
+        if (seasonal) {
+            R_hat = read__(pars, "R_hat", err);
+            t0 = read__(pars, "t0", err);
+            k = read__(pars, "k", err);
+            lambda = read__(pars, "lambda", err);
+        } else R = read__(pars, "R", err);
+        Y0 = read__(pars, "Y0", err, 1.0);
+        B0 = read__(pars, "B0", err, 1.0);
+        N0 = read__(pars, "N0", err, 1.0);
+        if (err) return;
+
+        s_0_h.resize(n_sets);
+        f_0_u.resize(n_sets);
+        for (size_t i = 0; i < n_sets; i++) {
+            s_0_h[i] = std::pow(s_0[i], h[i]);
+            f_0_u[i] = std::pow(f_0[i], u[i]);
+        }
+
+        n_blocks = (n_sets + batch_lanes - 1U) / batch_lanes;
+        for (std::vector<double>* x : {&m, &R, &d_yp, &d_b0, &d_bp, &g_yp,
+             &g_b0, &g_bp, &L_0, &P_max, &q, &s_0_h, &h, &f_0_u, &F_tilde,
+             &u, &R_hat, &t0, &k, &lambda, &Y0, &B0, &N0}) {
+            if (! x->empty()) x->resize(n_blocks * batch_lanes, x->back());
+        }
+
+    };
+
+private:
+
+    // Use `def` if it's missing (NaN means it's required):
+    std::vector<double> read__(const List& pars,
+                               const std::string& name,
+                               bool& err,
+                               const double& def = NA_REAL) {
+        if (! pars.containsElementNamed(name.c_str())) {
+            if (std::isnan(def)) {
+                Rcout << name << " is missing from pars!" << std::endl;
+                err = true;
+            }
+            return std::vector<double>(n_sets, def);
+        }
+        SEXP x_name = pars[name];
+        std::vector<double> x = as<std::vector<double>>(x_name);
+        if (x.size() == 1U) {
+            x.resize(n_sets, x.front());
+        } else if (x.size() != n_sets) {
+            Rcout << name << " has length " << x.size() << " but should have ";
+            Rcout << "length 1 or " << n_sets << "!" << std::endl;
+            err = true;
+        }
+        return x;
+    }
+};
+
+
+
+
+/*
+ System for one block of sets, with each parameter copied into a local array
+ so the compiler knows they don't overlap with the state.
+ This is the same as `OnePlantSystemFunction` (or
+ `OnePlantSeasonSystemFunction` when `seasonal` is true), but for a block.
+ */
+class OnePlantBatchSystem
+{
+public:
+
+    bool seasonal;
+    Lanes m;
+    Lanes R;
+    Lanes d_yp;
+    Lanes d_b0;
+    Lanes d_bp;
+    Lanes g_yp;
+    Lanes g_b0;
+    Lanes g_bp;
+    Lanes L_0;
+    Lanes P_max;
+    Lanes q;
+    Lanes s_0_h;
+    Lanes h;
+    Lanes f_0_u;
+    Lanes F_tilde;
+    Lanes u;
+    Lanes R_hat;
+    Lanes t0;
+    Lanes k;
+    Lanes lambda;
+
+    OnePlantBatchSystem(const OnePlantBatchPars& pars, const size_t& block)
+        : seasonal(pars.seasonal) {
+        size_t i0 = block * batch_lanes;
+        auto load = [i0](Lanes& x, const std::vector<double>& v) {
+            if (v.empty()) {
+                x.fill(0);
+            } else std::copy(v.begin() + i0, v.begin() + i0 + batch_lanes,
+                             x.begin());
+        };
+        load(m, pars.m);
+        load(R, pars.R);
+        load(d_yp, pars.d_yp);
+        load(d_b0, pars.d_b0);
+        load(d_bp, pars.d_bp);
+        load(g_yp, pars.g_yp);
+        load(g_b0, pars.g_b0);
+        load(g_bp, pars.g_bp);
+        load(L_0, pars.L_0);
+        load(P_max, pars.P_max);
+        load(q, pars.q);
+        load(s_0_h, pars.s_0_h);
+        load(h, pars.h);
+        load(f_0_u, pars.f_0_u);
+        load(F_tilde, pars.F_tilde);
+        load(u, pars.u);
+        load(R_hat, pars.R_hat);
+        load(t0, pars.t0);
+        load(k, pars.k);
+        load(lambda, pars.lambda);
+    };
+
+    void operator()(const BlockState& x, BlockState& dxdt, const double t) const {
+
+        const Lanes& Y(x[0]);
+        const Lanes& B(x[1]);
+        const Lanes& N(x[2]);
+
+        Lanes R_t;
+        if (seasonal) {
+            for (size_t l = 0; l < batch_lanes; l++) {
+                R_t[l] = R_hat[l] * (k[l] / lambda[l]) *
+                    std::pow((t + t0[l]) / lambda[l], k[l]-1) *
+                    std::exp(-1 * std::pow((t + t0[l]) / lambda[l], k[l]));
+            }
+        } else R_t = R;
+
+        Lanes P;
+        plants__(Y, B, N, P);
+
+        Lanes disp_y, disp_b;
+        for (size_t l = 0; l < batch_lanes; l++) {
+            double F = Y[l] + B[l] + N[l];
+            double PF = P[l] / F;
+            double Lambda = PF / (L_0[l] + PF);
+            double gamma_y = g_yp[l] * Lambda;
+            double gamma_b = g_b0[l] + g_bp[l] * Lambda;
+            double delta_y = d_yp[l] * Lambda;
+            double delta_b = d_b0[l] + d_bp[l] * Lambda;
+            disp_y[l] = delta_y * Y[l] / F + gamma_y;
+            disp_b[l] = delta_b * B[l] / F + gamma_b;
+        }
+
+        Lanes& dYdt(dxdt[0]);
+        Lanes& dBdt(dxdt[1]);
+        Lanes& dNdt(dxdt[2]);
+        for (size_t l = 0; l < batch_lanes; l++) {
+            dYdt[l] = disp_y[l] * N[l] - m[l] * Y[l];
+            dBdt[l] = disp_b[l] * N[l] - m[l] * B[l];
+            dNdt[l] = R_t[l] - N[l] * (m[l] + disp_y[l] + disp_b[l]);
+        }
+
+        return;
+    }
+
+    /*
+     Pollinator visits for a block's state, as reported in the "P" column.
+     `one_plant_ode` reports P using F^u (not (F / (F + F_tilde))^u as in
+     its system), so that's done here, too.
+     */
+    void P(const BlockState& x, Lanes& P_out) const {
+        if (seasonal) {
+            plants__(x[0], x[1], x[2], P_out);
+            return;
+        }
+        for (size_t l = 0; l < batch_lanes; l++) {
+            double F = x[0][l] + x[1][l] + x[2][l];
+            double F_u = std::pow(F, u[l]);
+            double phi = F_u / (f_0_u[l] + F_u);
+            double psi = s_0_h[l] / (s_0_h[l] + std::pow(x[1][l] / F, h[l]));
+            P_out[l] = P_max[l] * (q[l] * psi + (1-q[l]) * phi);
+        }
+        return;
+    }
+
+private:
+
+    void plants__(const Lanes& Y, const Lanes& B, const Lanes& N,
+                  Lanes& P) const {
+        for (size_t l = 0; l < batch_lanes; l++) {
+            double F = Y[l] + B[l] + N[l];
+            double FF_u = std::pow(F / (F + F_tilde[l]), u[l]);
+            double phi = FF_u / (f_0_u[l] + FF_u);
+            double psi = s_0_h[l] / (s_0_h[l] + std::pow(B[l] / F, h[l]));
+            P[l] = P_max[l] * (q[l] * psi + (1-q[l]) * phi);
+        }
+        return;
+    }
+};
+
+
+
+
+/*
+ Dormand-Prince 5 stepper for a block, with the same coefficients and order
+ of operations as `runge_kutta_dopri5` (including reusing the last stage's
+ derivatives as the next step's first stage).
+ */
+class OnePlantBatchStepper
+{
+public:
+
+    OnePlantBatchStepper() : first_call(true) {};
+
+    void do_step(const OnePlantBatchSystem& system,
+                 BlockState& x,
+                 const double& t,
+                 const double& dt) {
+
+        const double a2 = 1.0 / 5.0;
+        const double a3 = 3.0 / 10.0;
+        const double a4 = 4.0 / 5.0;
+        const double a5 = 8.0 / 9.0;
+
+        const double b21 = 1.0 / 5.0;
+
+        const double b31 = 3.0 / 40.0;
+        const double b32 = 9.0 / 40.0;
+
+        const double b41 = 44.0 / 45.0;
+        const double b42 = -56.0 / 15.0;
+        const double b43 = 32.0 / 9.0;
+
+        const double b51 = 19372.0 / 6561.0;
+        const double b52 = -25360.0 / 2187.0;
+        const double b53 = 64448.0 / 6561.0;
+        const double b54 = -212.0 / 729.0;
+
+        const double b61 = 9017.0 / 3168.0;
+        const double b62 = -355.0 / 33.0;
+        const double b63 = 46732.0 / 5247.0;
+        const double b64 = 49.0 / 176.0;
+        const double b65 = -5103.0 / 18656.0;
+
+        const double c1 = 35.0 / 384.0;
+        const double c3 = 500.0 / 1113.0;
+        const double c4 = 125.0 / 192.0;
+        const double c5 = -2187.0 / 6784.0;
+        const double c6 = 11.0 / 84.0;
+
+        if (first_call) {
+            system(x, dxdt, t);
+            first_call = false;
+        }
+
+        stage_sum__<1>(x_tmp, x, {dt*b21}, {&dxdt});
+        system(x_tmp, k2, t + dt*a2);
+        stage_sum__<2>(x_tmp, x, {dt*b31, dt*b32}, {&dxdt, &k2});
+        system(x_tmp, k3, t + dt*a3);
+        stage_sum__<3>(x_tmp, x, {dt*b41, dt*b42, dt*b43}, {&dxdt, &k2, &k3});
+        system(x_tmp, k4, t + dt*a4);
+        stage_sum__<4>(x_tmp, x, {dt*b51, dt*b52, dt*b53, dt*b54},
+                       {&dxdt, &k2, &k3, &k4});
+        system(x_tmp, k5, t + dt*a5);
+        stage_sum__<5>(x_tmp, x, {dt*b61, dt*b62, dt*b63, dt*b64, dt*b65},
+                       {&dxdt, &k2, &k3, &k4, &k5});
+        system(x_tmp, k6, t + dt);
+        stage_sum__<5>(x_tmp, x, {dt*c1, dt*c3, dt*c4, dt*c5, dt*c6},
+                       {&dxdt, &k3, &k4, &k5, &k6});
+        x = x_tmp;
+        system(x, dxdt, t + dt);
+
+        return;
+    }
+
+private:
+
+    bool first_call;
+    BlockState dxdt;
+    BlockState k2;
+    BlockState k3;
+    BlockState k4;
+    BlockState k5;
+    BlockState k6;
+    BlockState x_tmp;
+
+    // out = x + a[0] * ks[0] + a[1] * ks[1] + ..., added in that order:
+    template< size_t K >
+    void stage_sum__(BlockState& out,
+                     const BlockState& x,
+                     const std::array<double, K>& a,
+                     const std::array<const BlockState*, K>& ks) {
+        for (size_t j = 0; j < 3U; j++) {
+            Lanes& out_j(out[j]);
+            out_j = x[j];
+            for (size_t i = 0; i < K; i++) {
+                const Lanes& k_ij((*ks[i])[j]);
+                for (size_t l = 0; l < batch_lanes; l++) {
+                    out_j[l] += a[i] * k_ij[l];
+                }
+            }
+        }
+        return;
+    }
+};
+
+
+
+// Times `integrate_const` observes at when going from 0 to `max_t`:
+inline std::vector<double> const_times(const double& dt, const double& max_t) {
+    std::vector<double> times;
+    times.reserve(n_const_steps(dt, max_t) + 1U);
+    double time = 0;
+    size_t step = 0;
+    while ((time + dt) - max_t <= std::numeric_limits<double>::epsilon()) {
+        times.push_back(time);
+        step++;
+        time = static_cast<double>(step) * dt;
+    }
+    times.push_back(time);
+    return times;
+}
+
+
+
+/*
+ Each task is one block of sets.
+ Output is stored by column (for the "t", "Y", "B", "N", and "P" columns),
+ with rows grouped by set. Blocks only write to their own sets' rows.
+ */
+struct OnePlantBatchWorker : public RcppParallel::Worker {
+
+    const OnePlantBatchPars& pars;
+    const std::vector<double>& times;
+    double dt;
+    bool last_only;
+    size_t rows_per_set;
+    size_t n_rows;
+    std::vector<double> output;
+    Progress& progress;
+
+    OnePlantBatchWorker(const OnePlantBatchPars& pars_,
+                        const std::vector<double>& times_,
+                        const double& dt_,
+                        const bool& last_only_,
+                        Progress& progress_)
+        : pars(pars_),
+          times(times_),
+          dt(dt_),
+          last_only(last_only_),
+          rows_per_set(last_only_ ? 1U : times_.size()),
+          n_rows(pars_.n_sets * rows_per_set),
+          output(n_rows * 5U),
+          progress(progress_) {};
+
+    void operator()(size_t begin, size_t end) {
+        for (size_t b = begin; b < end; b++) {
+            if (progress.cancelled()) break;
+            OnePlantBatchSystem system(pars, b);
+            OnePlantBatchStepper stepper;
+            BlockState x;
+            size_t i0 = b * batch_lanes;
+            std::copy(pars.Y0.begin() + i0, pars.Y0.begin() + i0 + batch_lanes,
+                      x[0].begin());
+            std::copy(pars.B0.begin() + i0, pars.B0.begin() + i0 + batch_lanes,
+                      x[1].begin());
+            std::copy(pars.N0.begin() + i0, pars.N0.begin() + i0 + batch_lanes,
+                      x[2].begin());
+            bool finished = true;
+            {
+                ProgressTicker ticker(progress, false);
+                for (size_t s = 0; s < times.size(); s++) {
+                    if (! last_only) save__(system, x, b, s, s);
+                    if ((s + 1U) == times.size()) break;
+                    stepper.do_step(system, x, times[s], dt);
+                    if (! ticker.tick()) {
+                        finished = false;
+                        break;
+                    }
+                }
+            }
+            if (! finished) break;
+            if (last_only) save__(system, x, b, times.size() - 1U, 0U);
+            size_t n_valid = std::min(batch_lanes, pars.n_sets - i0);
+            for (size_t l = 0; l < n_valid; l++) progress.add_rep();
+        }
+        return;
+    }
+
+    void fill_output(NumericMatrix& out) const {
+        out = NumericMatrix(n_rows, 6U);
+        colnames(out) = CharacterVector::create("set", "t", "Y", "B", "N", "P");
+        for (size_t i = 0; i < n_rows; i++) {
+            out(i,0) = static_cast<double>(i / rows_per_set) + 1;
+            for (size_t j = 0; j < 5U; j++) out(i,j+1U) = output[j * n_rows + i];
+        }
+        return;
+    }
+
+private:
+
+    // Save state at time index `s` to row `r` of each set in block `b`:
+    void save__(const OnePlantBatchSystem& system,
+                const BlockState& x,
+                const size_t& b,
+                const size_t& s,
+                const size_t& r) {
+        Lanes P;
+        system.P(x, P);
+        size_t i0 = b * batch_lanes;
+        size_t n_valid = std::min(batch_lanes, pars.n_sets - i0);
+        for (size_t l = 0; l < n_valid; l++) {
+            size_t i = (i0 + l) * rows_per_set + r;
+            output[i] = times[s];
+            output[n_rows + i] = x[0][l];
+            output[2U * n_rows + i] = x[1][l];
+            output[3U * n_rows + i] = x[2][l];
+            output[4U * n_rows + i] = P[l];
+        }
+        return;
+    }
+};
+
+
+
+
+// Shared by both functions below:
+inline NumericMatrix one_plant_batch_runs(const List& pars,
+                                          const bool& seasonal,
+                                          const double& dt,
+                                          const double& max_t,
+                                          const bool& last_only,
+                                          const bool& show_progress,
+                                          const uint32_t& grain_size,
+                                          const bool& thread_stats) {
+
+    /*
+     I can't just use 'stop()' because it causes a segfault (or similar).
+     The system below is my workaround.
+     */
+    bool err = false;
+    min_val_check(err, dt, "dt", 0, false);
+    min_val_check(err, max_t, "max_t", dt);
+    min_val_check(err, grain_size, "grain_size", 1);
+    if (err) return NumericMatrix(0,0);
+
+    OnePlantBatchPars batch_pars(pars, seasonal, err);
+    if (err) return NumericMatrix(0,0);
+
+    std::vector<double> times = const_times(dt, max_t);
+    size_t n_blocks = batch_pars.n_blocks;
+
+    Progress progress(batch_pars.n_sets, n_blocks * (times.size() - 1U),
+                      show_progress);
+
+    OnePlantBatchWorker worker(batch_pars, times, dt, last_only, progress);
+
+    // Blocks are handed to threads `grain_size` at a time (see scheduler.h):
+    ThreadUsage usage;
+    // Running in another thread lets this one check for interrupts:
+    bool finished = progress.run_parallel([&]() {
+        dynamic_parallel_for(worker, n_blocks, grain_size, usage);
+    });
+    if (! finished) return NumericMatrix(0,0);
+
+    NumericMatrix output;
+    worker.fill_output(output);
+    if (thread_stats) output.attr("thread_stats") = usage.output();
+
+    return output;
+}
+
+
+
+
+/*
+ Run `one_plant_ode` for many parameter sets at once.
+ `pars` is a named list (or data frame) with the same names as the
+ arguments to `one_plant_ode` (except `dt` and `max_t`), where each item
+ has one value per parameter set or a single value used for all sets.
+ `Y0`, `B0`, and `N0` default to 1 if not provided.
+ Returns output from all sets bound together, with the set number in the
+ first column. If `last_only` is true, only the last time point is
+ returned for each set.
+ `grain_size` is the number of blocks (of 8 sets each) given to a thread
+ at a time.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix one_plant_batch_ode(const List& pars,
+                                  const double& dt = 0.1,
+                                  const double& max_t = 90.0,
+                                  const bool& last_only = false,
+                                  const bool& show_progress = false,
+                                  const uint32_t& grain_size = 1,
+                                  const bool& thread_stats = false) {
+
+    return one_plant_batch_runs(pars, false, dt, max_t, last_only,
+                                show_progress, grain_size, thread_stats);
+}
+
+
+// Same as above, but for `one_plant_season_ode`:
+//' @export
+// [[Rcpp::export]]
+NumericMatrix one_plant_season_batch_ode(const List& pars,
+                                         const double& dt = 0.1,
+                                         const double& max_t = 90.0,
+                                         const bool& last_only = false,
+                                         const bool& show_progress = false,
+                                         const uint32_t& grain_size = 1,
+                                         const bool& thread_stats = false) {
+
+    return one_plant_batch_runs(pars, true, dt, max_t, last_only,
+                                show_progress, grain_size, thread_stats);
+}
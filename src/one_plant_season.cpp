@@ -70,7 +70,9 @@ public:
           k(k_),
           lambda(lambda_) {};
 
-    void operator()(const VecType& x, VecType& dxdt, const double t) {
+    // `C` is `VecType` or `ArrType<3>`:
+    template< class C >
+    void operator()(const C& x, C& dxdt, const double t) const {
 
         const double& Y(x[0]);
         const double& B(x[1]);
@@ -141,18 +143,18 @@ NumericMatrix one_plant_season_ode(const double& m,
                                    const double& B0 = 1.0,
                                    const double& N0 = 1.0) {
 
-    VecType x(3U, 0.0);
+    ArrType<3> x;
     x[0] = Y0;
     x[1] = B0;
     x[2] = N0;
 
-    Observer<VecType> obs;
+    Observer<ArrType<3>> obs;
     OnePlantSeasonSystemFunction system(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
                                   L_0, P_max, q, s_0, h, f_0, F_tilde, u,
                                   R_hat, t0, k, lambda);
 
     boost::numeric::odeint::integrate_const(
-        VecStepperType(), std::ref(system),
+        ArrStepperType<3>(), std::ref(system),
         x, 0.0, max_t, dt, std::ref(obs));
 
     size_t n_steps = obs.data.size();
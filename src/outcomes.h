@@ -0,0 +1,243 @@
+# ifndef __SWEETSOURSONG_OUTCOMES_H
+# define __SWEETSOURSONG_OUTCOMES_H
+
+
+/*
+ Classifying outcomes (coexistence, yeast only, bacteria only, or extinct)
+ and finding when yeast and bacteria dropped out, all during integration.
+ This means trajectories don't have to be stored when only outcomes
+ are of interest.
+ Works for any landscape model where the first two columns in the state
+ matrix are yeast and bacteria (with plants in rows).
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <cmath>
+
+#include "ode.h"
+
+using namespace Rcpp;
+
+
+/*
+ Outcome codes, in the same order as factor levels used in scripts:
+ 1 = coexist, 2 = yeast only, 3 = bacteria only, 4 = extinct
+ */
+enum OutcomeCode {
+    OUT_COEXIST = 1,
+    OUT_YEAST_ONLY = 2,
+    OUT_BACT_ONLY = 3,
+    OUT_EXTINCT = 4
+};
+
+inline int classify_outcome(const double& Y,
+                            const double& B,
+                            const double& threshold) {
+    if (Y > threshold && B > threshold) return OUT_COEXIST;
+    if (Y > threshold) return OUT_YEAST_ONLY;
+    if (B > threshold) return OUT_BACT_ONLY;
+    return OUT_EXTINCT;
+}
+
+
+
+/*
+ Observer that keeps track of outcomes instead of storing states.
+
+ - Outcomes are based on the mean Y and B for times >= `window_start`
+   (or just final values if `window_start` is >= the final time).
+ - Drop-out times are the first time that Y or B falls to (or below)
+   `threshold` after having been above it.
+   These are NaN (NA in R) if that never happened.
+ - Both are done for each plant and for the landscape as a whole
+   (using Y and B summed across plants).
+ */
+class OutcomeTracker
+{
+public:
+    double threshold;
+    double window_start;
+    size_t n_plants;
+    // Means inside window (last row is for entire landscape):
+    arma::mat window_mean;
+    // Drop-out times (last row is for entire landscape):
+    arma::mat drop_t;
+
+    OutcomeTracker(const size_t& n_plants_,
+                   const double& threshold_,
+                   const double& window_start_)
+        : threshold(threshold_),
+          window_start(window_start_),
+          n_plants(n_plants_),
+          window_mean(n_plants_+1U, 2U),
+          drop_t(n_plants_+1U, 2U),
+          above(n_plants_+1U, 2U),
+          last(n_plants_+1U, 2U),
+          n_window(0) {
+        reset();
+    };
+
+    void reset() {
+        window_mean.zeros();
+        drop_t.fill(NA_REAL);
+        above.zeros();
+        last.zeros();
+        n_window = 0;
+        return;
+    }
+
+    void operator()(const MatType& x, const double& t) {
+
+        last(n_plants,0) = 0;
+        last(n_plants,1) = 0;
+        for (size_t i = 0; i < n_plants; i++) {
+            for (size_t j = 0; j < 2U; j++) {
+                last(i,j) = x(i,j);
+                last(n_plants,j) += x(i,j);
+            }
+        }
+
+        for (size_t i = 0; i <= n_plants; i++) {
+            for (size_t j = 0; j < 2U; j++) {
+                if (last(i,j) > threshold) {
+                    above(i,j) = 1;
+                } else if (above(i,j) > 0 && ISNAN(drop_t(i,j))) {
+                    drop_t(i,j) = t;
+                }
+            }
+        }
+
+        // Last time point is always used if nothing else is in window:
+        if (t >= window_start) {
+            window_mean += last;
+            n_window++;
+        }
+
+        return;
+    }
+
+    /*
+     Means inside window, or final values if no time points were inside it.
+     Row `n_plants` is for the entire landscape.
+     */
+    double Y(const size_t& i) const {
+        if (n_window == 0) return last(i,0);
+        return window_mean(i,0) / static_cast<double>(n_window);
+    }
+    double B(const size_t& i) const {
+        if (n_window == 0) return last(i,1);
+        return window_mean(i,1) / static_cast<double>(n_window);
+    }
+    int outcome(const size_t& i) const {
+        return classify_outcome(Y(i), B(i), threshold);
+    }
+
+    // For checkpoints (see checkpoint.h):
+    template< class W >
+    void save(W& w) const {
+        w.write(window_mean);
+        w.write(drop_t);
+        w.write(above);
+        w.write(last);
+        w.write(static_cast<uint64_t>(n_window));
+        return;
+    }
+    template< class R >
+    void load(R& r) {
+        uint64_t n_window_in = 0;
+        r.read(window_mean);
+        r.read(drop_t);
+        r.read(above);
+        r.read(last);
+        r.read(n_window_in);
+        n_window = n_window_in;
+        return;
+    }
+
+    // Number of output rows:
+    size_t n_rows(const bool& by_plant) const {
+        return by_plant ? n_plants : 1U;
+    }
+
+    /*
+     Fill rows of output starting at row `i` and column `j0`.
+     Columns are plant (only if `by_plant`), Y, B, outcome, Y_drop_t, B_drop_t.
+     `i` is incremented to the next empty row.
+     */
+    void fill_output(NumericMatrix& output,
+                     size_t& i,
+                     const size_t& j0,
+                     const bool& by_plant) const {
+        if (by_plant) {
+            for (size_t k = 0; k < n_plants; k++) {
+                output(i, j0) = k;
+                fill_row__(output, i, j0 + 1U, k);
+                i++;
+            }
+        } else {
+            fill_row__(output, i, j0, n_plants);
+            i++;
+        }
+        return;
+    }
+
+
+private:
+    // Whether Y or B has been above the threshold:
+    arma::mat above;
+    // Values at the last time point:
+    arma::mat last;
+    size_t n_window;
+
+    void fill_row__(NumericMatrix& output,
+                    const size_t& i,
+                    const size_t& j0,
+                    const size_t& k) const {
+        output(i, j0) = Y(k);
+        output(i, j0+1U) = B(k);
+        output(i, j0+2U) = outcome(k);
+        output(i, j0+3U) = drop_t(k,0);
+        output(i, j0+4U) = drop_t(k,1);
+        return;
+    }
+
+};
+
+
+// Column names for outcome output:
+inline CharacterVector outcome_colnames(const bool& by_plant,
+                                        const bool& with_rep) {
+    CharacterVector cn;
+    if (with_rep) cn.push_back("rep");
+    if (by_plant) cn.push_back("p");
+    cn.push_back("Y");
+    cn.push_back("B");
+    cn.push_back("outcome");
+    cn.push_back("Y_drop_t");
+    cn.push_back("B_drop_t");
+    return cn;
+}
+
+
+inline void outcome_arg_checks(bool& err,
+                               const double& threshold,
+                               const double& outcome_window) {
+    min_val_check(err, threshold, "threshold", 0);
+    min_val_check(err, outcome_window, "outcome_window", 0);
+    return;
+}
+
+
+// Output matrix for a single run:
+inline NumericMatrix outcome_output(const OutcomeTracker& tracker,
+                                    const bool& by_plant) {
+    NumericMatrix output(tracker.n_rows(by_plant), by_plant ? 6U : 5U);
+    colnames(output) = outcome_colnames(by_plant, false);
+    size_t i = 0;
+    tracker.fill_output(output, i, 0U, by_plant);
+    return output;
+}
+
+
+#endif
@@ -0,0 +1,214 @@
+# ifndef __SWEETSOURSONG_PROGRESS_H
+# define __SWEETSOURSONG_PROGRESS_H
+
+
+/*
+ Progress reporting and user interrupts for long runs.
+ Worker threads only update atomic counters (in batches, see
+ `ProgressTicker`), and only the main R thread checks for interrupts and
+ prints anything.
+ */
+
+#include <Rcpp.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdint>
+#include <string>
+
+
+using namespace Rcpp;
+
+
+inline void check_interrupt_fn__(void* /* dummy */) {
+    R_CheckUserInterrupt();
+}
+/*
+ Whether the user has tried to interrupt (without the longjmp that
+ R_CheckUserInterrupt would otherwise do). Only call from the main thread.
+ */
+inline bool user_interrupt() {
+    return R_ToplevelExec(check_interrupt_fn__, NULL) == FALSE;
+}
+
+
+
+class Progress
+{
+public:
+
+    Progress(const uint64_t& total_reps_,
+             const uint64_t& total_steps_,
+             const bool& show_)
+        : reps(0),
+          steps(0),
+          cancel_flag(false),
+          total_reps(total_reps_),
+          total_steps(total_steps_),
+          show(show_),
+          start(std::chrono::steady_clock::now()),
+          last_poll(start) {};
+
+    // ------------------
+    // Safe to call from any thread:
+    // ------------------
+    void add_steps(const uint64_t& n) {
+        steps.fetch_add(n, std::memory_order_relaxed);
+        return;
+    }
+    void add_rep() {
+        reps.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    bool cancelled() const {
+        return cancel_flag.load(std::memory_order_relaxed);
+    }
+    void cancel() {
+        cancel_flag.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    // ------------------
+    // Only call these from the main thread:
+    // ------------------
+
+    // Whether it's been at least `poll_ms` milliseconds since the last poll:
+    bool poll_due() const {
+        return (std::chrono::steady_clock::now() - last_poll) >=
+            std::chrono::milliseconds(poll_ms);
+    }
+
+    /*
+     Check for interrupts and print progress.
+     Returns false if the run was cancelled.
+     */
+    bool poll() {
+        auto now = std::chrono::steady_clock::now();
+        last_poll = now;
+        if (user_interrupt()) cancel();
+        if (show) print__(now);
+        return ! cancelled();
+    }
+
+    /*
+     Run `f` (usually a call to `RcppParallel::parallelFor`) in another
+     thread while this one polls for interrupts and progress.
+     Returns false if the run was cancelled.
+     */
+    template< class F >
+    bool run_parallel(F f) {
+        std::atomic<bool> done(false);
+        std::thread runner([&]() {
+            f();
+            done.store(true, std::memory_order_release);
+        });
+        while (! done.load(std::memory_order_acquire)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+            if (poll_due()) poll();
+        }
+        runner.join();
+        return finish();
+    }
+
+    // Print final progress (if shown) and return false if cancelled.
+    bool finish() {
+        if (show) {
+            print__(std::chrono::steady_clock::now());
+            Rcout << std::endl;
+        }
+        if (cancelled()) Rcout << "Interrupted by user." << std::endl;
+        return ! cancelled();
+    }
+
+private:
+    std::atomic<uint64_t> reps;
+    std::atomic<uint64_t> steps;
+    std::atomic<bool> cancel_flag;
+    uint64_t total_reps;
+    uint64_t total_steps;
+    bool show;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point last_poll;
+    const int poll_ms = 250;
+    const int sleep_ms = 20;
+
+    void print__(const std::chrono::steady_clock::time_point& now) {
+        double secs = std::chrono::duration<double>(now - start).count();
+        if (secs <= 0) secs = 1e-9;
+        double n_steps = static_cast<double>(steps.load(std::memory_order_relaxed));
+        double n_reps = static_cast<double>(reps.load(std::memory_order_relaxed));
+        double pct = total_steps > 0 ?
+            100 * n_steps / static_cast<double>(total_steps) : 0;
+        char buffer[200];
+        if (total_reps > 1) {
+            std::snprintf(buffer, sizeof(buffer),
+                          "\r%5.1f%% | %.0f / %llu reps | %.3g reps/s | %.3g steps/s   ",
+                          pct, n_reps,
+                          static_cast<unsigned long long>(total_reps),
+                          n_reps / secs, n_steps / secs);
+        } else {
+            std::snprintf(buffer, sizeof(buffer),
+                          "\r%5.1f%% | %.3g steps/s   ",
+                          pct, n_steps / secs);
+        }
+        Rcout << buffer << std::flush;
+        return;
+    }
+};
+
+
+
+
+/*
+ Step counter for a single thread that only touches the shared atomic
+ counter every `flush_every` steps.
+ On the main thread (i.e., for serial runs), it instead checks the clock
+ every step and polls for interrupts and progress when that's due.
+ */
+class ProgressTicker
+{
+public:
+
+    ProgressTicker(Progress& progress_, const bool& main_thread_)
+        : progress(progress_),
+          main_thread(main_thread_),
+          n(0) {};
+
+    ~ProgressTicker() {
+        flush();
+    }
+
+    // Call once per step. Returns false if the run should stop.
+    bool tick() {
+        ++n;
+        if (main_thread) {
+            if (progress.poll_due()) {
+                flush();
+                return progress.poll();
+            }
+        } else if (n >= flush_every) flush();
+        return ! progress.cancelled();
+    }
+
+    void flush() {
+        if (n > 0) progress.add_steps(n);
+        n = 0;
+        return;
+    }
+
+private:
+    Progress& progress;
+    bool main_thread;
+    uint64_t n;
+    const uint64_t flush_every = 256;
+};
+
+
+// Number of steps `integrate_const` takes from 0 to `max_t`:
+inline uint64_t n_const_steps(const double& dt, const double& max_t) {
+    return static_cast<uint64_t>(max_t / dt + 1e-10);
+}
+
+
+#endif
@@ -0,0 +1,153 @@
+# ifndef __SWEETSOURSONG_RNG_H
+# define __SWEETSOURSONG_RNG_H
+
+
+/*
+ Random number generation for stochastic replicates.
+ */
+
+#include <RcppArmadillo.h>
+#include <cstdint>
+#include <cmath>
+
+#include <pcg_random.hpp>
+
+
+using namespace Rcpp;
+
+
+
+// SplitMix64 (used to scramble seeds):
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+
+/*
+ Seed the generator for replicate `rep` from one master seed.
+ Each rep gets its own pcg32 stream (selected by the rep index) and its own
+ scrambled starting state, so streams for different reps are independent
+ and a rep's numbers never depend on the number of threads or how reps are
+ split among them.
+ */
+inline void seed_rep_rng(pcg32& rng,
+                         const uint64_t& master_seed,
+                         const uint64_t& rep) {
+    uint64_t state = splitmix64(master_seed ^ splitmix64(rep));
+    rng.seed(state, rep);
+    return;
+}
+
+
+/*
+ Master seed from an optional user-provided seed. If none is provided,
+ it's made from two draws from R's RNG, so it still follows `set.seed`.
+ */
+inline uint64_t make_master_seed(SEXP seed) {
+    if (seed != R_NilValue) {
+        return static_cast<uint64_t>(as<double>(seed));
+    }
+    uint64_t seed1 = static_cast<uint64_t>(R::runif(0, 4294967296));
+    uint64_t seed2 = static_cast<uint64_t>(R::runif(0, 4294967296));
+    return (seed1 << 32) + seed2;
+}
+
+
+
+/*
+ Uniform on the open interval (0,1) from one 32-bit draw.
+ Never returns exactly 0 or 1, so it's safe inside `log`.
+ */
+inline double unif_open(const uint32_t& r) {
+    return (static_cast<double>(r) + 0.5) * 2.3283064365386963e-10; // 2^-32
+}
+
+
+/*
+ Layer boundaries for the 256-layer ziggurat (Marsaglia & Tsang 2000).
+ `x[i]` is the right edge of layer `i` (`x[0]` is the width of the base
+ layer's rectangle if it had the same area as the others), and `f[i]` is the
+ normal density (without constant) at `x[i]`.
+ */
+struct ZigguratTables
+{
+    static constexpr size_t n = 256;
+    static constexpr double r = 3.6541528853610088;    // start of the tail
+    static constexpr double v = 0.00492867323399;      // area of each layer
+    double x[n + 1];
+    double f[n + 1];
+
+    ZigguratTables() {
+        f[1] = std::exp(-0.5 * r * r);
+        x[0] = v / f[1];
+        x[1] = r;
+        for (size_t i = 1; i < n - 1; i++) {
+            x[i+1] = std::sqrt(-2.0 * std::log(v / x[i] + f[i]));
+            f[i+1] = std::exp(-0.5 * x[i+1] * x[i+1]);
+        }
+        x[n] = 0;
+        f[n] = 1;
+        f[0] = 0;
+    }
+};
+
+inline const ZigguratTables& zig_tables() {
+    static const ZigguratTables tables;
+    return tables;
+}
+
+
+/*
+ One standard normal using the ziggurat method.
+ Each try uses one 64-bit draw (two from pcg32): 8 bits pick the layer,
+ 1 bit the sign, and the top 53 bits the position within the layer.
+ Keeping these bits separate avoids the correlation between layer and
+ position in the original 32-bit version.
+ About 99% of draws are accepted on the first (cheap) comparison.
+ */
+inline double zig_normal(pcg32& rng, const ZigguratTables& zt) {
+    constexpr double two_53 = 1.1102230246251565e-16; // 2^-53
+    while (true) {
+        // (Separate statements so the order of the two draws is defined)
+        uint64_t bits = static_cast<uint64_t>(rng()) << 32;
+        bits |= static_cast<uint64_t>(rng());
+        size_t i = bits & 0xFFU;
+        double sign = (bits & 0x100U) ? -1.0 : 1.0;
+        double z = static_cast<double>(bits >> 11) * two_53 * zt.x[i];
+        // Inside the layer's rectangle:
+        if (z < zt.x[i+1]) return sign * z;
+        if (i == 0) {
+            // Tail beyond r (Marsaglia 1964):
+            double a, b;
+            do {
+                a = -std::log(unif_open(rng())) / zt.r;
+                b = -std::log(unif_open(rng()));
+            } while (2 * b < a * a);
+            return sign * (zt.r + a);
+        }
+        // In the wedge, so compare to the density itself:
+        double y = zt.f[i] + unif_open(rng()) * (zt.f[i+1] - zt.f[i]);
+        if (y < std::exp(-0.5 * z * z)) return sign * z;
+    }
+}
+
+
+/*
+ Fill all of `z` with standard normals (ziggurat method).
+ No values are cached between calls, so the RNG state alone determines
+ future draws (which keeps checkpoints simple).
+ */
+template< class M >
+inline void fill_normals(M& z, pcg32& rng) {
+    const ZigguratTables& zt(zig_tables());
+    double* zp = z.memptr();
+    for (size_t k = 0; k < z.n_elem; k++) zp[k] = zig_normal(rng, zt);
+    return;
+}
+
+
+
+#endif
@@ -0,0 +1,164 @@
+# ifndef __SWEETSOURSONG_SCHEDULER_H
+# define __SWEETSOURSONG_SCHEDULER_H
+
+
+/*
+ Dynamic self-scheduling of reps (or any other independent tasks).
+ Instead of handing out fixed ranges of reps up front, `parallelFor` is run
+ over one slot per thread, and each slot repeatedly grabs the next
+ `grain_size` tasks from a shared counter until none are left, so slots
+ that get quick reps (e.g., ones where a strain goes extinct early) just
+ take more of them. (There's no stealing between slots; the shared counter
+ does all the balancing.)
+ This doesn't depend on which backend RcppParallel uses, and since each
+ rep's RNG only depends on its index (see rng.h), results don't depend on
+ the scheduling.
+ Time spent working and the number of tasks done are also recorded per
+ slot so load balance can be checked. Each slot normally runs on its own
+ thread, but the backend decides that, so slots aren't OS threads.
+ */
+
+#include <RcppParallel.h>
+#include <Rcpp.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+
+
+using namespace Rcpp;
+
+
+
+// Number of threads RcppParallel is set to use (see `setThreadOptions`):
+inline size_t parallel_n_threads() {
+    const char* env = std::getenv("RCPP_PARALLEL_NUM_THREADS");
+    if (env != NULL) {
+        int n = std::atoi(env);
+        if (n > 0) return static_cast<size_t>(n);
+    }
+    size_t n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1U;
+}
+
+
+
+/*
+ Tasks done and time spent working for each slot (see above).
+ Each slot only writes to its own element.
+ */
+class ThreadUsage
+{
+public:
+
+    std::vector<double> busy;  // seconds
+    std::vector<double> n_chunks;
+    std::vector<double> n_tasks;
+    double wall;  // seconds for the whole parallel section
+
+    ThreadUsage() : busy(), n_chunks(), n_tasks(), wall(0) {};
+
+    void reset(const size_t& n_slots) {
+        busy.assign(n_slots, 0);
+        n_chunks.assign(n_slots, 0);
+        n_tasks.assign(n_slots, 0);
+        wall = 0;
+        return;
+    }
+
+    /*
+     One row per slot with columns for the number of chunks and tasks it
+     did, seconds spent working, and the proportion of the parallel section's
+     total time that was spent working.
+     */
+    NumericMatrix output() const {
+        size_t n = busy.size();
+        NumericMatrix out(n, 5U);
+        colnames(out) = CharacterVector::create("slot", "chunks", "tasks",
+                 "busy", "utilization");
+        for (size_t i = 0; i < n; i++) {
+            out(i,0) = i + 1;
+            out(i,1) = n_chunks[i];
+            out(i,2) = n_tasks[i];
+            out(i,3) = busy[i];
+            out(i,4) = wall > 0 ? busy[i] / wall : 0;
+        }
+        return out;
+    }
+};
+
+
+
+
+/*
+ Wraps a Worker whose `operator()(begin, end)` does tasks `begin` to
+ `end - 1`. Ranges given to this worker are over slots, not tasks.
+ */
+template< class W >
+struct DynamicWorker : public RcppParallel::Worker {
+
+    W& worker;
+    size_t n_tasks;
+    size_t grain_size;
+    ThreadUsage& usage;
+    std::atomic<size_t> next;
+
+    DynamicWorker(W& worker_,
+                  const size_t& n_tasks_,
+                  const size_t& grain_size_,
+                  ThreadUsage& usage_)
+        : worker(worker_),
+          n_tasks(n_tasks_),
+          grain_size(grain_size_),
+          usage(usage_),
+          next(0) {};
+
+    void operator()(size_t begin, size_t end) {
+        for (size_t slot = begin; slot < end; slot++) {
+            size_t b, e;
+            while ((b = next.fetch_add(grain_size,
+                                       std::memory_order_relaxed)) < n_tasks) {
+                e = std::min(b + grain_size, n_tasks);
+                auto t0 = std::chrono::steady_clock::now();
+                worker(b, e);
+                usage.busy[slot] += std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - t0).count();
+                usage.n_chunks[slot]++;
+                usage.n_tasks[slot] += static_cast<double>(e - b);
+            }
+        }
+        return;
+    }
+};
+
+
+/*
+ Do tasks `0` to `n_tasks - 1` using `worker`, grabbing `grain_size` at a
+ time, with one slot per thread (or fewer if there aren't enough tasks).
+ Usage per slot is stored in `usage`.
+ */
+template< class W >
+inline void dynamic_parallel_for(W& worker,
+                                 const size_t& n_tasks,
+                                 const size_t& grain_size,
+                                 ThreadUsage& usage) {
+    size_t grain = std::max(grain_size, static_cast<size_t>(1U));
+    size_t n_slots = std::min(parallel_n_threads(),
+                              (n_tasks + grain - 1U) / grain);
+    if (n_slots < 1U) n_slots = 1U;
+    usage.reset(n_slots);
+    DynamicWorker<W> dyn_worker(worker, n_tasks, grain, usage);
+    auto t0 = std::chrono::steady_clock::now();
+    RcppParallel::parallelFor(0, n_slots, dyn_worker, 1);
+    usage.wall = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - t0).count();
+    return;
+}
+
+
+
+
+#endif
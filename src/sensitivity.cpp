@@ -0,0 +1,140 @@
+
+/*
+ Forward sensitivities for `landscape_constantF_ode` and `landscape_ode`
+ (see sensitivity.h).
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <string>
+
+#include "ode.h"
+#include "landscape.h"
+#include "landscape_constantF.h"
+#include "sensitivity.h"
+#include "checkpoint.h"
+
+using namespace Rcpp;
+
+
+
+
+/*
+ Same as `landscape_constantF_ode`, but also returning sensitivities of
+ Y and B to the parameters in `sens_pars` (any of m, d_yp, d_b0, d_bp,
+ g_yp, g_b0, g_bp, L_0, u, and X).
+ Sensitivities to per-plant parameters are for changing the values at all
+ plants together.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_constantF_sensitivity(const std::vector<double>& m,
+                                              const std::vector<double>& d_yp,
+                                              const std::vector<double>& d_b0,
+                                              const std::vector<double>& d_bp,
+                                              const std::vector<double>& g_yp,
+                                              const std::vector<double>& g_b0,
+                                              const std::vector<double>& g_bp,
+                                              const std::vector<double>& L_0,
+                                              const double& u,
+                                              const double& X,
+                                              const std::vector<double>& Y0,
+                                              const std::vector<double>& B0,
+                                              const std::vector<std::string>& sens_pars,
+                                              const double& dt = 0.1,
+                                              const double& max_t = 90.0,
+                                              const bool& show_progress = false) {
+
+    size_t np = m.size();
+    bool err = lanscape_constF_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                          L_0, u, X, Y0, B0, dt, max_t);
+    std::vector<size_t> pars = sens_par_indices(err, sens_pars,
+                                                const_f_sens_names);
+    if (err) return NumericMatrix(0,0);
+
+    size_t n_states = 2U;
+    // Sensitivities start at zero:
+    MatType x(np, n_states * (1U + pars.size()), arma::fill::zeros);
+    for (size_t i = 0; i < np; i++) {
+        x(i,0) = Y0[i];
+        x(i,1) = B0[i];
+    }
+
+    LandscapeConstFSens system(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp, L_0,
+                               u, X, pars);
+
+    ObserverP<LandscapeConstFSens> obs(system);
+    if (! integrate_interruptible(system, x, dt, max_t, obs, show_progress)) {
+        return NumericMatrix(0,0);
+    }
+
+    return sensitivity_output(obs, {"Y", "B"}, sens_pars);
+}
+
+
+
+/*
+ Same as `landscape_ode`, but also returning sensitivities of Y, B, and N
+ to the parameters in `sens_pars` (any of m, R, d_yp, d_b0, d_bp, g_yp,
+ g_b0, g_bp, L_0, P_max, u, q, W, and w).
+ Sensitivities to per-plant parameters are for changing the values at all
+ plants together.
+ */
+//' @export
+// [[Rcpp::export]]
+NumericMatrix landscape_sensitivity(const std::vector<double>& m,
+                                    const std::vector<double>& R,
+                                    const std::vector<double>& d_yp,
+                                    const std::vector<double>& d_b0,
+                                    const std::vector<double>& d_bp,
+                                    const std::vector<double>& g_yp,
+                                    const std::vector<double>& g_b0,
+                                    const std::vector<double>& g_bp,
+                                    const std::vector<double>& L_0,
+                                    const std::vector<double>& P_max,
+                                    const double& u,
+                                    const double& q,
+                                    const std::vector<double>& W,
+                                    const double& w,
+                                    const arma::mat& z,
+                                    const double& min_F_for_P,
+                                    const std::vector<double>& Y0,
+                                    const std::vector<double>& B0,
+                                    const std::vector<double>& N0,
+                                    const std::vector<std::string>& sens_pars,
+                                    const double& dt = 0.1,
+                                    const double& max_t = 90.0,
+                                    const bool& show_progress = false) {
+
+    size_t np = z.n_rows;
+    bool err = lanscape_arg_checks(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                   L_0, P_max, u, q, W, w, z, min_F_for_P,
+                                   Y0, B0, dt, max_t);
+    len_check(err, R, "R", np);
+    len_check(err, N0, "N0", np);
+    min_val_check(err, R, "R", 0);
+    min_val_check(err, N0, "N0", 0);
+    std::vector<size_t> pars = sens_par_indices(err, sens_pars,
+                                                landscape_sens_names);
+    if (err) return NumericMatrix(0,0);
+
+    size_t n_states = 3U;
+    // Sensitivities start at zero:
+    MatType x(np, n_states * (1U + pars.size()), arma::fill::zeros);
+    for (size_t i = 0; i < np; i++) {
+        x(i,0) = Y0[i];
+        x(i,1) = B0[i];
+        x(i,2) = N0[i];
+    }
+
+    NonSeasonalLandscapeSens system(m, d_yp, d_b0, d_bp, g_yp, g_b0, g_bp,
+                                    L_0, P_max, u, q, W, w, z, min_F_for_P, R,
+                                    pars);
+
+    ObserverP<NonSeasonalLandscapeSens> obs(system);
+    if (! integrate_interruptible(system, x, dt, max_t, obs, show_progress)) {
+        return NumericMatrix(0,0);
+    }
+
+    return sensitivity_output(obs, {"Y", "B", "N"}, sens_pars);
+}
@@ -0,0 +1,480 @@
+# ifndef __SWEETSOURSONG_SENSITIVITY_H
+# define __SWEETSOURSONG_SENSITIVITY_H
+
+
+/*
+ Forward sensitivities for the landscape models.
+ For each chosen parameter theta, the sensitivities S = d(state)/d(theta)
+ follow dS/dt = J S + df/d(theta), where J is the Jacobian of the RHS
+ with respect to the state, and S starts at zero.
+ These are integrated alongside the state by adding columns to the state
+ matrix: columns `0` to `n_states-1` are the state as usual, and the next
+ `n_states` columns are the sensitivities for the first parameter, etc.
+
+ For parameters that have one value per plant (e.g., `d_yp`), theta is a
+ shift in the values for all plants at once (i.e., how things change when
+ that parameter changes everywhere).
+
+ J S is never formed as a matrix product with J. Instead, J is applied to
+ all sensitivities using the same pieces as the RHS, so for the full
+ landscape the only dense operation is one product of Phi with a matrix
+ that has two columns for the state and two for each parameter.
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <memory>
+
+#include "ode.h"
+#include "landscape.h"
+#include "landscape_constantF.h"
+
+
+using namespace Rcpp;
+
+
+
+
+/*
+ Indices of parameter names `pars` in `names` (the parameters that
+ sensitivities can be found for).
+ */
+inline std::vector<size_t> sens_par_indices(bool& err,
+                                            const std::vector<std::string>& pars,
+                                            const std::vector<std::string>& names) {
+    std::vector<size_t> idx;
+    if (pars.empty()) {
+        Rcout << "sens_pars should contain at least one parameter!" << std::endl;
+        err = true;
+        return idx;
+    }
+    for (const std::string& p : pars) {
+        size_t i = 0;
+        while (i < names.size() && names[i] != p) i++;
+        if (i == names.size()) {
+            Rcout << p << " is not a parameter that sensitivities can be ";
+            Rcout << "found for! They should be one of ";
+            for (size_t j = 0; j < names.size(); j++) {
+                Rcout << names[j] << (j + 1U < names.size() ? ", " : "!");
+            }
+            Rcout << std::endl;
+            err = true;
+        } else idx.push_back(i);
+    }
+    return idx;
+}
+
+
+
+
+/*
+ Constant-F landscape (see `LandscapeConstF`) with sensitivities for
+ parameters in `const_f_sens_names`.
+ */
+const std::vector<std::string> const_f_sens_names = {"m", "d_yp", "d_b0",
+                                                     "d_bp", "g_yp", "g_b0",
+                                                     "g_bp", "L_0", "u", "X"};
+
+class LandscapeConstFSens : public LandscapeConstF
+{
+public:
+
+    // Indices into `const_f_sens_names`:
+    std::vector<size_t> pars;
+
+    LandscapeConstFSens(const std::vector<double>& m_,
+                        const std::vector<double>& d_yp_,
+                        const std::vector<double>& d_b0_,
+                        const std::vector<double>& d_bp_,
+                        const std::vector<double>& g_yp_,
+                        const std::vector<double>& g_b0_,
+                        const std::vector<double>& g_bp_,
+                        const std::vector<double>& L_0_,
+                        const double& u_,
+                        const double& X_,
+                        const std::vector<size_t>& pars_)
+        : LandscapeConstF(m_, d_yp_, d_b0_, d_bp_, g_yp_, g_b0_, g_bp_,
+                          L_0_, u_, X_),
+          pars(pars_),
+          w(m_.size()),
+          dw(m_.size()) {};
+
+    void operator()(const MatType& x,
+                    MatType& dxdt,
+                    const double& t) {
+        LandscapeConstF::operator()(x, dxdt, t);
+        sensitivities__(x, dxdt);
+        return;
+    }
+
+private:
+
+    std::vector<double> w;
+    std::vector<double> dw;
+
+    void sensitivities__(const MatType& x, MatType& dxdt) {
+
+        // Unnormalized weights:
+        double w_sum = 0;
+        for (size_t i = 0; i < n_plants; i++) {
+            w[i] = std::pow(1 - x(i,1), u);
+            w_sum += w[i];
+        }
+        double D = X + w_sum;
+
+        for (size_t k = 0; k < pars.size(); k++) {
+
+            const size_t& par(pars[k]);
+            size_t cy = 2U + 2U * k, cb = cy + 1U;
+
+            double dw_sum = 0;
+            for (size_t i = 0; i < n_plants; i++) {
+                double YN = 1 - x(i,1);
+                dw[i] = 0;
+                if (YN > 0) {
+                    dw[i] = w[i] * (-u * x(i,cb) / YN);
+                    if (par == 8U) dw[i] += w[i] * std::log(YN);
+                }
+                dw_sum += dw[i];
+            }
+            double dD = dw_sum + (par == 9U ? 1 : 0);
+
+            for (size_t i = 0; i < n_plants; i++) {
+
+                const double& Y(x(i,0));
+                const double& B(x(i,1));
+                const double& sY(x(i,cy));
+                const double& sB(x(i,cb));
+                double N = 1 - Y - B;
+                double sN = -sY - sB;
+
+                double P = w[i] / D;
+                double dP = (dw[i] - P * dD) / D;
+                double LP = L_0[i] + P;
+                double Lambda = P / LP;
+                double dLambda = (L_0[i] * dP - (par == 7U ? P : 0)) /
+                    (LP * LP);
+
+                double gamma_y = g_yp[i] * Lambda;
+                double gamma_b = g_b0[i] + g_bp[i] * Lambda;
+                double delta_y = d_yp[i] * Lambda;
+                double delta_b = d_b0[i] + d_bp[i] * Lambda;
+
+                double dgamma_y = g_yp[i] * dLambda;
+                double dgamma_b = g_bp[i] * dLambda;
+                double ddelta_y = d_yp[i] * dLambda;
+                double ddelta_b = d_bp[i] * dLambda;
+                switch (par) {
+                case 1U: ddelta_y += Lambda; break;
+                case 2U: ddelta_b += 1; break;
+                case 3U: ddelta_b += Lambda; break;
+                case 4U: dgamma_y += Lambda; break;
+                case 5U: dgamma_b += 1; break;
+                case 6U: dgamma_b += Lambda; break;
+                default: break;
+                }
+
+                double disp_y = delta_y * Y + gamma_y;
+                double disp_b = delta_b * B + gamma_b;
+                double ddisp_y = ddelta_y * Y + delta_y * sY + dgamma_y;
+                double ddisp_b = ddelta_b * B + delta_b * sB + dgamma_b;
+
+                dxdt(i,cy) = ddisp_y * N + disp_y * sN - m[i] * sY;
+                dxdt(i,cb) = ddisp_b * N + disp_b * sN - m[i] * sB;
+                if (par == 0U) {
+                    dxdt(i,cy) -= Y;
+                    dxdt(i,cb) -= B;
+                }
+            }
+        }
+
+        return;
+    }
+
+};
+
+
+
+
+/*
+ Non-seasonal landscape (see `NonSeasonalLandscape`) with sensitivities for
+ parameters in `landscape_sens_names`.
+ */
+const std::vector<std::string> landscape_sens_names = {"m", "R", "d_yp",
+                                                       "d_b0", "d_bp", "g_yp",
+                                                       "g_b0", "g_bp", "L_0",
+                                                       "P_max", "u", "q", "W",
+                                                       "w"};
+
+class NonSeasonalLandscapeSens : public NonSeasonalLandscape
+{
+public:
+
+    // Indices into `landscape_sens_names`:
+    std::vector<size_t> pars;
+
+    NonSeasonalLandscapeSens(const std::vector<double>& m_,
+                             const std::vector<double>& d_yp_,
+                             const std::vector<double>& d_b0_,
+                             const std::vector<double>& d_bp_,
+                             const std::vector<double>& g_yp_,
+                             const std::vector<double>& g_b0_,
+                             const std::vector<double>& g_bp_,
+                             const std::vector<double>& L_0_,
+                             const std::vector<double>& P_max_,
+                             const double& u_,
+                             const double& q_,
+                             const std::vector<double>& W_,
+                             const double& w_,
+                             const arma::mat& z_,
+                             const double& min_F_for_P_,
+                             const std::vector<double>& R_,
+                             const std::vector<size_t>& pars_)
+        : NonSeasonalLandscape(m_, d_yp_, d_b0_, d_bp_, g_yp_, g_b0_, g_bp_,
+                               L_0_, P_max_, u_, q_, W_, w_, z_, min_F_for_P_,
+                               R_),
+          pars(pars_),
+          dPhi(),
+          a(z_.n_rows),
+          V(z_.n_rows, 2U + 2U * pars_.size()),
+          PhiV(),
+          dPhi_v(),
+          dx(z_.n_rows, 3U),
+          dF(z_.n_rows) {
+        // d(Phi)/dw is only needed if `w` is one of the parameters:
+        for (const size_t& p : pars) {
+            if (p == 13U) {
+                dPhi = std::make_shared<const arma::mat>(dPhi_dw__(w_, z_));
+                break;
+            }
+        }
+    };
+
+    void operator()(const MatType& x,
+                    MatType& dxdt,
+                    const double t) {
+        NonSeasonalLandscape::operator()(x, dxdt, t);
+        sensitivities__(x, dxdt);
+        return;
+    }
+
+private:
+
+    std::shared_ptr<const arma::mat> dPhi;
+    arma::vec a;        // weights before dividing by their sum (plus W)
+    /*
+     Vectors that are multiplied by Phi: first the two from the RHS,
+     then their derivatives for each parameter.
+     */
+    arma::mat V;
+    arma::mat PhiV;
+    arma::mat dPhi_v;
+    arma::mat dx;
+    arma::vec dF;
+
+    void sensitivities__(const MatType& x, MatType& dxdt) {
+
+        const size_t n_pars = pars.size();
+        const arma::vec Y(x.unsafe_col(0));
+        const arma::vec B(x.unsafe_col(1));
+        const arma::vec N(x.unsafe_col(2));
+
+        // `F` and `weights` were already calculated in the RHS:
+        double a_sum = 0;
+        for (size_t i = 0; i < n_plants; i++) {
+            a(i) = 0;
+            if (F(i) < min_F_for_P) continue;
+            a(i) = std::pow(F(i), q);
+            double YN = Y(i) + N(i);
+            if (F(i) > 0) YN /= F(i);
+            a(i) *= std::pow(YN, u);
+            a_sum += a(i);
+        }
+
+        // Per-plant pieces that don't depend on the parameter:
+        arma::vec P = P_max % weights;
+        arma::vec PF(n_plants, arma::fill::zeros);
+        arma::vec YF(n_plants, arma::fill::zeros);
+        arma::vec BF(n_plants, arma::fill::zeros);
+        for (size_t i = 0; i < n_plants; i++) {
+            if (F(i) <= 0) continue;
+            PF(i) = P(i) / F(i);
+            YF(i) = Y(i) / F(i);
+            BF(i) = B(i) / F(i);
+        }
+        arma::vec Lambda = PF / (L_0 + PF);
+        arma::vec delta_y = d_yp % Lambda;
+        arma::vec delta_b = d_b0 + d_bp % Lambda;
+        V.col(0) = delta_y % YF + g_yp % Lambda;
+        V.col(1) = delta_b % BF + g_b0 + g_bp % Lambda;
+
+        for (size_t k = 0; k < n_pars; k++) {
+            const size_t& par(pars[k]);
+            size_t c0 = 3U * (k + 1U);
+            dx = x.cols(c0, c0 + 2U);
+            dF = dx.col(0) + dx.col(1) + dx.col(2);
+
+            // Derivatives of weights:
+            double da_sum = 0;
+            arma::vec da(n_plants, arma::fill::zeros);
+            for (size_t i = 0; i < n_plants; i++) {
+                if (a(i) <= 0 || F(i) <= 0) continue;
+                double YN = (Y(i) + N(i)) / F(i);
+                double d_log_a = q * dF(i) / F(i);
+                if (par == 11U) d_log_a += std::log(F(i));
+                if (YN > 0) {
+                    double dYN = (dx(i,0) + dx(i,2) - YN * dF(i)) / F(i);
+                    d_log_a += u * dYN / YN;
+                    if (par == 10U) d_log_a += std::log(YN);
+                }
+                da(i) = a(i) * d_log_a;
+                da_sum += da(i);
+            }
+            arma::vec dP(n_plants);
+            for (size_t i = 0; i < n_plants; i++) {
+                double dwt = da(i);
+                if (a_sum > 0 || W[i] > 0) {
+                    dwt = (da(i) - weights(i) * (da_sum + (par == 12U ? 1 : 0))) /
+                        (a_sum + W[i]);
+                }
+                dP(i) = P_max(i) * dwt;
+                if (par == 9U) dP(i) += weights(i);
+            }
+
+            // Derivatives of things multiplied by Phi:
+            arma::vec dPF(n_plants, arma::fill::zeros);
+            arma::vec dYF(n_plants, arma::fill::zeros);
+            arma::vec dBF(n_plants, arma::fill::zeros);
+            for (size_t i = 0; i < n_plants; i++) {
+                if (F(i) <= 0) continue;
+                dPF(i) = (dP(i) - PF(i) * dF(i)) / F(i);
+                dYF(i) = (dx(i,0) - YF(i) * dF(i)) / F(i);
+                dBF(i) = (dx(i,1) - BF(i) * dF(i)) / F(i);
+            }
+            arma::vec LPF = L_0 + PF;
+            arma::vec dLambda = L_0 % dPF;
+            if (par == 8U) dLambda -= PF;
+            dLambda /= (LPF % LPF);
+
+            arma::vec ddelta_y = d_yp % dLambda;
+            arma::vec ddelta_b = d_bp % dLambda;
+            arma::vec dgamma_y = g_yp % dLambda;
+            arma::vec dgamma_b = g_bp % dLambda;
+            switch (par) {
+            case 2U: ddelta_y += Lambda; break;
+            case 3U: ddelta_b += 1; break;
+            case 4U: ddelta_b += Lambda; break;
+            case 5U: dgamma_y += Lambda; break;
+            case 6U: dgamma_b += 1; break;
+            case 7U: dgamma_b += Lambda; break;
+            default: break;
+            }
+            V.col(2U + 2U * k) = ddelta_y % YF + delta_y % dYF + dgamma_y;
+            V.col(3U + 2U * k) = ddelta_b % BF + delta_b % dBF + dgamma_b;
+        }
+
+        // All products with Phi at once:
+        PhiV = (*Phi) * V;
+        if (dPhi) dPhi_v = (*dPhi) * V.cols(0, 1);
+
+        for (size_t k = 0; k < n_pars; k++) {
+            const size_t& par(pars[k]);
+            size_t c0 = 3U * (k + 1U);
+            arma::vec dgrowth_y = x.col(c0 + 2U) % PhiV.col(0) +
+                N % PhiV.col(2U + 2U * k);
+            arma::vec dgrowth_b = x.col(c0 + 2U) % PhiV.col(1) +
+                N % PhiV.col(3U + 2U * k);
+            if (par == 13U) {
+                dgrowth_y += N % dPhi_v.col(0);
+                dgrowth_b += N % dPhi_v.col(1);
+            }
+            dxdt.col(c0) = dgrowth_y - m % x.col(c0);
+            dxdt.col(c0 + 1U) = dgrowth_b - m % x.col(c0 + 1U);
+            dxdt.col(c0 + 2U) = -m % x.col(c0 + 2U) - dgrowth_y - dgrowth_b;
+            if (par == 0U) {
+                dxdt.col(c0) -= Y;
+                dxdt.col(c0 + 1U) -= B;
+                dxdt.col(c0 + 2U) -= N;
+            } else if (par == 1U) dxdt.col(c0 + 2U) += 1;
+        }
+
+        return;
+    }
+
+    // d(Phi)/dw, where Phi has columns exp(-w * z) normalized to sum to 1:
+    arma::mat dPhi_dw__(const double& w_, const arma::mat& z_) const {
+        arma::mat E(n_plants, n_plants), dE(n_plants, n_plants);
+        arma::mat out(n_plants, n_plants);
+        for (size_t j = 0; j < n_plants; j++) {
+            double col_sum = 0, dcol_sum = 0;
+            for (size_t i = 0; i < n_plants; i++) {
+                if (i == j) {
+                    E(i,j) = 1;
+                    dE(i,j) = 0;
+                } else {
+                    E(i,j) = std::exp(-w_ * z_(i,j));
+                    dE(i,j) = -z_(i,j) * E(i,j);
+                }
+                col_sum += E(i,j);
+                dcol_sum += dE(i,j);
+            }
+            for (size_t i = 0; i < n_plants; i++) {
+                out(i,j) = (dE(i,j) - E(i,j) * dcol_sum / col_sum) / col_sum;
+            }
+        }
+        return out;
+    }
+
+};
+
+
+
+
+/*
+ Output for sensitivities with one row per time point and plant: `t`, `p`,
+ the states, `P`, then the sensitivity of each state to each parameter
+ (e.g., `dY_d_yp` for how Y changes with `d_yp`).
+ */
+template< class L >
+inline NumericMatrix sensitivity_output(ObserverP<L>& obs,
+                                        const std::vector<std::string>& states,
+                                        const std::vector<std::string>& pars) {
+
+    obs.finish();
+
+    size_t np = obs.P.empty() ? 0U : obs.P.front().n_elem;
+    size_t ns = states.size();
+    size_t n_steps = obs.data.size();
+    size_t n_cols = 3U + ns * (1U + pars.size());
+    NumericMatrix output(n_steps * np, n_cols);
+    CharacterVector cn = CharacterVector::create("t", "p");
+    for (const std::string& s : states) cn.push_back(s);
+    cn.push_back("P");
+    for (const std::string& p : pars) {
+        for (const std::string& s : states) cn.push_back("d" + s + "_" + p);
+    }
+    colnames(output) = cn;
+
+    size_t i = 0;
+    for (size_t t = 0; t < n_steps; t++) {
+        const MatType& x(obs.data[t]);
+        for (size_t k = 0; k < np; k++) {
+            output(i,0) = obs.time[t];
+            output(i,1) = k;
+            for (size_t j = 0; j < ns; j++) output(i,j+2U) = x(k,j);
+            output(i,ns+2U) = obs.P[t](k);
+            for (size_t j = ns; j < ns * (1U + pars.size()); j++) {
+                output(i,j+3U) = x(k,j);
+            }
+            i++;
+        }
+    }
+    return output;
+}
+
+
+
+
+#endif
@@ -0,0 +1,185 @@
+# ifndef __SWEETSOURSONG_SPATIAL_NOISE_H
+# define __SWEETSOURSONG_SPATIAL_NOISE_H
+
+
+/*
+ Spatially correlated standard normals for stochastic landscapes.
+ The correlation matrix among plants is factored once (so C = F * F^T),
+ and the factor is shared read-only among threads and reps.
+ Each column of a draw (e.g., Y and B) is correlated among plants but
+ independent of the other columns.
+ */
+
+#include <RcppArmadillo.h>
+#include <string>
+#include <cmath>
+
+#include "ode.h"
+#include "rng.h"
+
+
+using namespace Rcpp;
+
+
+
+
+class SpatialNoise
+{
+public:
+
+    // Independent noise (the default):
+    SpatialNoise() : F(), D(), rank(0), independent(true), low_rank(false) {};
+
+    /*
+     `C` is the correlation matrix among plants.
+     If `rank_` is zero or >= the number of plants, `F` is the (lower)
+     Cholesky factor of `C`, or, if `C` is only positive semi-definite,
+     comes from its eigen decomposition.
+     Otherwise, `C` is approximated by its `rank_` largest eigenvectors plus a
+     diagonal that keeps each plant's variance at exactly 1, so each draw
+     costs O(n * rank) instead of O(n^2).
+     Returns false if `C` couldn't be factored.
+     */
+    bool factor(const arma::mat& C, const size_t& rank_) {
+
+        size_t n = C.n_rows;
+        independent = false;
+        low_rank = rank_ > 0 && rank_ < n;
+        rank = low_rank ? rank_ : n;
+
+        if (! low_rank && arma::chol(F, C, "lower")) {
+            D.reset();
+            return true;
+        }
+
+        arma::vec eigval;
+        arma::mat eigvec;
+        if (! arma::eig_sym(eigval, eigvec, C)) return false;
+        // Eigenvalues are in ascending order and can be slightly negative
+        // from rounding:
+        if (eigval(n-1U) <= 0 || eigval(0) < -1e-8 * eigval(n-1U)) return false;
+        F.set_size(n, rank);
+        for (size_t k = 0; k < rank; k++) {
+            size_t kk = n - 1U - k;
+            double sd = std::sqrt(std::max(eigval(kk), 0.0));
+            for (size_t i = 0; i < n; i++) F(i,k) = eigvec(i,kk) * sd;
+        }
+        if (low_rank) {
+            D.set_size(n);
+            double v;
+            for (size_t i = 0; i < n; i++) {
+                v = 1;
+                for (size_t k = 0; k < rank; k++) v -= F(i,k) * F(i,k);
+                D(i) = std::sqrt(std::max(v, 0.0));
+            }
+        } else D.reset();
+
+        return true;
+    }
+
+    /*
+     Fill `z` with standard normals that are correlated among plants (rows).
+     `work` is scratch space (one per thread, since this object is shared).
+     */
+    void fill(MatType& z, pcg32& rng, MatType& work) const {
+        if (independent) {
+            fill_normals(z, rng);
+            return;
+        }
+        if (work.n_rows != rank || work.n_cols != z.n_cols) {
+            work.set_size(rank, z.n_cols);
+        }
+        fill_normals(work, rng);
+        if (! low_rank) {
+            z = F * work;
+            return;
+        }
+        // Plant-specific part, then the shared low-rank part:
+        fill_normals(z, rng);
+        for (size_t j = 0; j < z.n_cols; j++) {
+            for (size_t i = 0; i < z.n_rows; i++) z(i,j) *= D(i);
+        }
+        z += F * work;
+        return;
+    }
+
+    bool is_independent() const { return independent; }
+
+private:
+    arma::mat F;
+    arma::vec D;
+    size_t rank;
+    bool independent;
+    bool low_rank;
+
+};
+
+
+
+
+/*
+ Correlation matrix among plants for stochastic noise from either a
+ distance matrix (`z`, with correlations `exp(-w * z)`) or a
+ variance-covariance matrix (`vcv`, rescaled to correlations since the
+ magnitudes of noise are set elsewhere).
+ Returns false without changing `C` if neither is provided.
+ */
+inline bool noise_corr_mat(arma::mat& C,
+                           bool& err,
+                           SEXP z,
+                           const double& w,
+                           SEXP vcv,
+                           const size_t& n_plants) {
+
+    if (z != R_NilValue && vcv != R_NilValue) {
+        Rcout << "Only one of noise_z and noise_vcv should be provided!";
+        Rcout << std::endl;
+        err = true;
+        return false;
+    }
+    if (z == R_NilValue && vcv == R_NilValue) return false;
+
+    if (z != R_NilValue) {
+        arma::mat z_ = as<arma::mat>(z);
+        mat_dim_check(err, z_, "noise_z", n_plants);
+        min_val_check(err, w, "noise_w", 0);
+        if (err) return false;
+        min_val_check(err, z_, "noise_z", 0);
+        if (err) return false;
+        C = arma::exp(-w * z_);
+        for (size_t i = 0; i < n_plants; i++) C(i,i) = 1;
+    } else {
+        arma::mat vcv_ = as<arma::mat>(vcv);
+        mat_dim_check(err, vcv_, "noise_vcv", n_plants);
+        if (err) return false;
+        arma::vec sd = vcv_.diag();
+        if (sd.min() <= 0) {
+            Rcout << "noise_vcv should have positive values on its diagonal!";
+            Rcout << std::endl;
+            err = true;
+            return false;
+        }
+        sd = arma::sqrt(sd);
+        C = vcv_;
+        for (size_t j = 0; j < n_plants; j++) {
+            for (size_t i = 0; i < n_plants; i++) {
+                C(i,j) /= (sd(i) * sd(j));
+            }
+        }
+    }
+
+    double max_asym = arma::abs(C - C.t()).max();
+    if (max_asym > 1e-8) {
+        Rcout << (z != R_NilValue ? "noise_z" : "noise_vcv");
+        Rcout << " should be symmetrical!" << std::endl;
+        err = true;
+        return false;
+    }
+
+    return true;
+}
+
+
+
+
+#endif
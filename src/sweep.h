@@ -0,0 +1,103 @@
+# ifndef __SWEETSOURSONG_SWEEP_H
+# define __SWEETSOURSONG_SWEEP_H
+
+
+/*
+ Reading parameter sets for sweeps.
+ Each parameter set is a named list of arguments (with the same names as
+ the arguments to the single-run function), and anything that's the same
+ for all sets can instead go in one `shared` list.
+ Per-plant parameters of length 1 are recycled to all plants.
+ Everything here uses R's API, so only use it from the main thread.
+ */
+
+#include <RcppArmadillo.h>
+#include <vector>
+#include <string>
+
+
+using namespace Rcpp;
+
+
+
+class SweepPars
+{
+public:
+
+    size_t n_sets;
+
+    SweepPars(const List& par_sets, const List& shared_)
+        : n_sets(par_sets.size()), sets(), shared(shared_) {
+        sets.reserve(n_sets);
+        for (size_t k = 0; k < n_sets; k++) {
+            List set_k = par_sets[k];
+            sets.push_back(set_k);
+        }
+    };
+
+    // Per-plant values for set `k`:
+    std::vector<double> plant_pars(const size_t& k,
+                                   const std::string& name,
+                                   const size_t& n_plants,
+                                   bool& err) {
+        SEXP x = find__(k, name, err);
+        if (x == R_NilValue) return std::vector<double>(n_plants, 0.0);
+        std::vector<double> out = as<std::vector<double>>(x);
+        if (out.size() == 1U) out.resize(n_plants, out.front());
+        return out;
+    }
+    // Same as above, but for strings (e.g., `distr_types`):
+    StringVector plant_strings(const size_t& k,
+                               const std::string& name,
+                               const size_t& n_plants,
+                               bool& err) {
+        SEXP x = find__(k, name, err);
+        if (x == R_NilValue) return StringVector(n_plants);
+        StringVector out = as<StringVector>(x);
+        if (out.size() == 1U) {
+            std::string s0 = as<std::string>(out[0]);
+            out = StringVector(n_plants);
+            for (size_t i = 0; i < n_plants; i++) out[i] = s0;
+        }
+        return out;
+    }
+    // Single value for set `k`:
+    double scalar_par(const size_t& k,
+                      const std::string& name,
+                      bool& err) {
+        SEXP x = find__(k, name, err);
+        if (x == R_NilValue) return 0;
+        std::vector<double> out = as<std::vector<double>>(x);
+        if (out.size() != 1U) {
+            Rcout << name << " should be a single number in parameter set ";
+            Rcout << (k + 1U) << "!" << std::endl;
+            err = true;
+            return 0;
+        }
+        return out.front();
+    }
+
+    // Whether set `k` (or the shared parameters) has a value for `name`:
+    bool has(const size_t& k, const std::string& name) const {
+        return sets[k].containsElementNamed(name.c_str()) ||
+            shared.containsElementNamed(name.c_str());
+    }
+
+private:
+    std::vector<List> sets;
+    List shared;
+
+    SEXP find__(const size_t& k, const std::string& name, bool& err) {
+        if (sets[k].containsElementNamed(name.c_str())) return sets[k][name];
+        if (shared.containsElementNamed(name.c_str())) return shared[name];
+        Rcout << name << " is missing from parameter set " << (k + 1U);
+        Rcout << " and from shared parameters!" << std::endl;
+        err = true;
+        return R_NilValue;
+    }
+};
+
+
+
+
+#endif
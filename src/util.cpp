@@ -5,6 +5,8 @@
 #include <cmath>
 
 #include "ode.h"
+#include "rng.h"
+#include "community.h"
 
 using namespace Rcpp;
 
@@ -123,6 +125,32 @@ NumericVector landscape_weights(const NumericMatrix& x,
 
 
 
+/*
+ Normals as drawn inside `landscape_constantF_stoch_ode`: `n_blocks` calls to
+ `fill_normals` (see rng.h), each filling `block_size` values, from rep
+ `rep`'s RNG stream. Rows are blocks. For checking these draws.
+ */
+//[[Rcpp::export]]
+NumericMatrix normal_draws_rcpp(const uint32_t& n_blocks,
+                                const uint32_t& block_size,
+                                const double& seed,
+                                const uint32_t& rep = 0) {
+
+    pcg32 rng;
+    seed_rep_rng(rng, static_cast<uint64_t>(seed), rep);
+
+    NumericMatrix out(n_blocks, block_size);
+    arma::vec z(block_size);
+    for (size_t i = 0; i < n_blocks; i++) {
+        fill_normals(z, rng);
+        for (size_t j = 0; j < block_size; j++) out(i,j) = z(j);
+    }
+
+    return out;
+}
+
+
+
 
 /*
  =====================================================================================
@@ -140,7 +168,7 @@ NumericVector landscape_weights(const NumericMatrix& x,
 //' @name dissimilarity
 //'
 //' @return A single number indicating the mean dissimilarity across the
-//'     two vectors.
+//'     two vectors (`NA` if they have fewer than two elements).
 //'
 //' @export
 //'
@@ -148,21 +176,9 @@ NumericVector landscape_weights(const NumericMatrix& x,
 double dissimilarity(NumericVector yeast, NumericVector bact) {
     size_t n = yeast.size();
     if (n != bact.size()) stop("lengths do not match");
-    size_t n_combos = static_cast<size_t>(Rf_choose(static_cast<double>(n), 2.0));
-    NumericVector bc_vec(n_combos);
-    size_t k = 0;
-    double min_y, min_b, denom;
-    for (size_t i = 0; i < (n-1U); i++) {
-        for (size_t j = i+1U; j < n; j++) {
-            min_y = (yeast(i) < yeast(j)) ? yeast(i) : yeast(j);
-            min_b = (bact(i) < bact(j)) ? bact(i) : bact(j);
-            denom = yeast(i) + yeast(j) + bact(i) + bact(j);
-            bc_vec(k) = 1 - (2 * (min_y + min_b)) / denom;
-            k++;
-        }
-    }
-    double bc_mean = mean(bc_vec);
-    return bc_mean;
+    // (No pairs to compare, and `&yeast[0]` isn't valid if it's empty)
+    if (n < 2) return NA_REAL;
+    return bray_curtis_mean(&yeast[0], &bact[0], n);
 }
 
 
@@ -242,7 +258,7 @@ NumericVector dissimilarity_vector(NumericVector yeast,
 //' @name diversity
 //'
 //' @return A single number indicating the mean diversity across the
-//'     two vectors.
+//'     two vectors (`NA` if they're empty).
 //'
 //' @export
 //'
@@ -251,17 +267,6 @@ double diversity(NumericVector yeast, NumericVector bact,
                  double zero_threshold = 2.220446e-16) {
     size_t n = yeast.size();
     if (n != bact.size()) stop("lengths do not match");
-    // Do calculation while accounting for zeros:
-    double p_yeast, p_bact, total, H_i, H_mean = 0;
-    for (size_t i = 0; i < n; i++) {
-        if (bact(i) > zero_threshold && yeast(i) > zero_threshold) {
-            total = yeast(i) + bact(i);
-            p_yeast = yeast(i) / total;
-            p_bact = bact(i) / total;
-            H_i = - p_yeast * log(p_yeast) - p_bact * log(p_bact);
-            H_mean += H_i;
-        }
-    }
-    H_mean /= static_cast<double>(n);
-    return H_mean;
+    if (n == 0) return NA_REAL;
+    return shannon_mean(&yeast[0], &bact[0], n, zero_threshold);
 }